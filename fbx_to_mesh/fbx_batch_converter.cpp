@@ -0,0 +1,216 @@
+#include "fbx_batch_converter.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include "solar/utility/alert.h"
+#include "solar/strings/string_build.h"
+#include "solar/io/file_path_helpers.h"
+#include "fbx_converter.h"
+#include "fbx_conversion_cache.h"
+#include "fbx_process_memory.h"
+
+namespace solar {
+
+	fbx_batch_converter::fbx_batch_converter(const fbx_converter_params& converter_params, unsigned int worker_count, write_output_mesh_func write_output_mesh)
+		: _converter_params(converter_params)
+		, _worker_count(std::max(1u, worker_count))
+		, _write_output_mesh(write_output_mesh)
+		, _cache(nullptr) {
+
+		//the workers already keep every core busy, don't oversubscribe with threads inside each conversion.
+		_converter_params.set_thread_count(std::max(1u, get_default_fbx_thread_count() / _worker_count));
+	}
+
+	void fbx_batch_converter::set_cache(const fbx_conversion_cache* cache) {
+		_cache = cache;
+	}
+
+	void fbx_batch_converter::add_job(const std::string& input_path, const std::string& output_path) {
+		_jobs.push_back(job(input_path, output_path));
+	}
+
+	bool fbx_batch_converter::add_jobs_from_manifest_or_directory(const std::string& path, const std::string& output_dir) {
+		DWORD attributes = ::GetFileAttributesA(path.c_str());
+		if (attributes == INVALID_FILE_ATTRIBUTES) {
+			ALERT("batch input not found : {}", path);
+			return false;
+		}
+		if ((attributes & FILE_ATTRIBUTE_DIRECTORY) != 0) {
+			return add_jobs_from_directory(path, output_dir);
+		}
+		return add_jobs_from_manifest(path, output_dir);
+	}
+
+	bool fbx_batch_converter::add_jobs_from_manifest(const std::string& manifest_path, const std::string& output_dir) {
+		//one job per line : "input.fbx" or "input.fbx<TAB>output.mesh". empty lines and lines starting with # are ignored.
+		std::ifstream manifest(manifest_path);
+		if (!manifest) {
+			ALERT("failed to open batch manifest : {}", manifest_path);
+			return false;
+		}
+
+		std::string line;
+		while (std::getline(manifest, line)) {
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			if (line.empty() || line.front() == '#') {
+				continue;
+			}
+
+			auto tab = line.find('\t');
+			if (tab == std::string::npos) {
+				add_job(line, make_output_path(line, output_dir));
+			}
+			else {
+				add_job(line.substr(0, tab), line.substr(tab + 1));
+			}
+		}
+		return true;
+	}
+
+	bool fbx_batch_converter::add_jobs_from_directory(const std::string& dir_path, const std::string& output_dir) {
+		WIN32_FIND_DATAA find_data;
+		HANDLE find_handle = ::FindFirstFileA((dir_path + "\\*.fbx").c_str(), &find_data);
+		if (find_handle == INVALID_HANDLE_VALUE) {
+			return true; //empty directory is not an error
+		}
+
+		std::vector<std::string> input_paths;
+		do {
+			if ((find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+				input_paths.push_back(dir_path + "\\" + find_data.cFileName);
+			}
+		} while (::FindNextFileA(find_handle, &find_data));
+		::FindClose(find_handle);
+
+		//FindNextFile order depends on the file system, sort so reports are stable between runs.
+		std::sort(input_paths.begin(), input_paths.end());
+		for (const auto& input_path : input_paths) {
+			add_job(input_path, make_output_path(input_path, output_dir));
+		}
+		return true;
+	}
+
+	std::string fbx_batch_converter::make_output_path(const std::string& input_path, const std::string& output_dir) {
+		if (output_dir.empty()) {
+			auto last_dot = input_path.find_last_of('.');
+			auto last_slash = input_path.find_last_of("\\/");
+			if (last_dot != std::string::npos && (last_slash == std::string::npos || last_dot > last_slash)) {
+				return input_path.substr(0, last_dot) + ".mesh";
+			}
+			return input_path + ".mesh";
+		}
+		return output_dir + "\\" + get_file_name_no_path_no_extension(input_path) + ".mesh";
+	}
+
+	void fbx_batch_converter::execute() {
+		std::atomic<int> next_job_index(0);
+		unsigned int worker_count = std::min(_worker_count, static_cast<unsigned int>(std::max<size_t>(1, _jobs.size())));
+
+		std::vector<std::thread> workers;
+		for (unsigned int i = 1; i < worker_count; ++i) {
+			workers.emplace_back([this, &next_job_index]() { execute_worker(next_job_index); });
+		}
+		execute_worker(next_job_index);
+		for (auto& worker : workers) {
+			worker.join();
+		}
+
+		//reported once every worker is done so ALERT is only ever called from this thread here.
+		for (const auto& job : _jobs) {
+			if (!job._exception_message.empty()) {
+				ALERT("{} : {}", job._input_path, job._exception_message);
+			}
+		}
+	}
+
+	void fbx_batch_converter::execute_worker(std::atomic<int>& next_job_index) {
+		fbx_converter converter(_converter_params);
+		for (;;) {
+			int job_index = next_job_index++;
+			if (job_index >= static_cast<int>(_jobs.size())) {
+				break;
+			}
+			execute_job(converter, _jobs.at(job_index));
+		}
+	}
+
+	void fbx_batch_converter::execute_job(fbx_converter& converter, job& job) const {
+		try {
+			std::string cache_key;
+			if (_cache != nullptr) {
+				cache_key = _cache->make_key(job._input_path);
+				if (!cache_key.empty() && _cache->try_restore(cache_key, job._output_path)) {
+					job._is_cache_hit = true;
+					return;
+				}
+			}
+
+			auto output_mesh = converter.convert_fbx_to_output_mesh(job._input_path);
+			job._error_count = converter.get_error_count();
+			job._stats = converter.get_stats();
+			if (output_mesh != nullptr) {
+				if (_cache != nullptr) {
+					fbx_conversion_cache::break_hard_link(job._output_path);
+				}
+				auto write_start = std::chrono::high_resolution_clock::now();
+				_write_output_mesh(*output_mesh, job._output_path);
+				auto write_end = std::chrono::high_resolution_clock::now();
+				job._stats.add_stage("write", std::chrono::duration<double, std::milli>(write_end - write_start).count(), job._stats._scratch_memory_bytes); //writing takes nothing from the arena
+				//a cache hit reports nothing, so only conversions with nothing to report are stored. that keeps
+				//warnings_as_errors out of the key without a hit hiding a warning it should have failed on.
+				if (_cache != nullptr && !cache_key.empty() && job._error_count == 0 && converter.get_warning_count() == 0) {
+					_cache->store(cache_key, job._output_path);
+				}
+			}
+		}
+		catch (std::exception& e) {
+			job._error_count = converter.get_error_count() + 1;
+			job._exception_message = e.what();
+			job._stats = converter.get_stats(); //the stages that finished
+		}
+	}
+
+	const fbx_converter_params& fbx_batch_converter::get_converter_params() const {
+		return _converter_params;
+	}
+
+	const std::vector<fbx_batch_converter::job>& fbx_batch_converter::get_jobs() const {
+		return _jobs;
+	}
+
+	int fbx_batch_converter::get_error_count() const {
+		int error_count = 0;
+		for (const auto& job : _jobs) {
+			error_count += job._error_count;
+		}
+		return error_count;
+	}
+
+	int fbx_batch_converter::get_failed_job_count() const {
+		return static_cast<int>(std::count_if(_jobs.begin(), _jobs.end(), [](const job& job) { return !job.is_successful(); }));
+	}
+
+	int fbx_batch_converter::get_cache_hit_count() const {
+		return static_cast<int>(std::count_if(_jobs.begin(), _jobs.end(), [](const job& job) { return job._is_cache_hit; }));
+	}
+
+	void fbx_batch_converter::write_stats_to_archive(archive_writer& writer) const {
+		//the process's peak covers every worker's conversions at once, only the whole batch has one. archives have no
+		//64 bit integers, megabytes fit a float.
+		writer.write_float("peak_process_memory_mb", static_cast<float>(static_cast<double>(get_peak_process_memory_bytes()) / (1024.0 * 1024.0)));
+		writer.write_objects("files", static_cast<unsigned int>(_jobs.size()), [this](archive_writer& writer, unsigned int i) {
+			const auto& job = _jobs[i];
+			writer.write_string("input", job._input_path);
+			writer.write_string("output", job._output_path);
+			writer.write_bool("is_cache_hit", job._is_cache_hit);
+			writer.write_int("error_count", job._error_count);
+			job._stats.write_to_archive(writer);
+		});
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "solar/archiving/archive_writer.h"
+#include "fbx_conversion_stats.h"
+#include "fbx_converter_params.h"
+#include "fbx_output_mesh.h"
+
+namespace solar {
+
+	class fbx_converter;
+	class fbx_conversion_cache;
+
+	//converts many .fbx files on a pool of worker threads. each worker owns one fbx_converter (and so one
+	//FbxManager) for its whole lifetime instead of paying for sdk setup per file.
+
+	class fbx_batch_converter {
+	public:
+		//called on the worker threads, concurrently when there is more than one worker.
+		typedef std::function<void(const fbx_output_mesh& output_mesh, const std::string& output_path)> write_output_mesh_func;
+
+		class job {
+		public:
+			std::string _input_path;
+			std::string _output_path;
+			int _error_count;
+			bool _is_cache_hit;
+			std::string _exception_message;
+			fbx_conversion_stats _stats; //the converter's, plus writing. empty for cache hits
+
+		public:
+			job(const std::string& input_path, const std::string& output_path)
+				: _input_path(input_path)
+				, _output_path(output_path)
+				, _error_count(0)
+				, _is_cache_hit(false) {
+			}
+
+			bool is_successful() const {
+				return _error_count == 0;
+			}
+		};
+
+	private:
+		fbx_converter_params _converter_params;
+		unsigned int _worker_count;
+		write_output_mesh_func _write_output_mesh;
+		const fbx_conversion_cache* _cache;
+		std::vector<job> _jobs;
+
+	public:
+		fbx_batch_converter(const fbx_converter_params& converter_params, unsigned int worker_count, write_output_mesh_func write_output_mesh);
+
+		void set_cache(const fbx_conversion_cache* cache); //optional, may be null
+		void add_job(const std::string& input_path, const std::string& output_path);
+		bool add_jobs_from_manifest_or_directory(const std::string& path, const std::string& output_dir);
+		void execute();
+
+		//converts and writes one job with a converter the caller keeps warm, see fbx_watch_converter.
+		void execute_job(fbx_converter& converter, job& job) const;
+
+		const fbx_converter_params& get_converter_params() const; //with the per worker thread count
+		const std::vector<job>& get_jobs() const;
+		int get_error_count() const; //sum of every job's error count
+		int get_failed_job_count() const;
+		int get_cache_hit_count() const;
+		void write_stats_to_archive(archive_writer& writer) const; //the process's peak memory, then every job's fbx_conversion_stats
+
+		//next to the input when output_dir is empty.
+		static std::string make_output_path(const std::string& input_path, const std::string& output_dir);
+
+	private:
+		void execute_worker(std::atomic<int>& next_job_index);
+		bool add_jobs_from_manifest(const std::string& manifest_path, const std::string& output_dir);
+		bool add_jobs_from_directory(const std::string& dir_path, const std::string& output_dir);
+	};
+
+}
\ No newline at end of file
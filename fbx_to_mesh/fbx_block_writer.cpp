@@ -0,0 +1,66 @@
+#include "fbx_block_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include "solar/utility/assert.h"
+
+namespace solar {
+
+	fbx_block_writer::fbx_block_writer(std::ostream& stream, size_t buffer_size)
+		: _stream(stream)
+		, _buffer(new char[buffer_size])
+		, _buffer_size(buffer_size)
+		, _buffered(0)
+		, _written(0) {
+		ASSERT(buffer_size > 0);
+	}
+
+	fbx_block_writer::~fbx_block_writer() {
+		flush();
+	}
+
+	void fbx_block_writer::write(const void* data, uint64_t size) {
+		const char* bytes = static_cast<const char*>(data);
+		_written += size;
+
+		if (_buffered + size <= _buffer_size) {
+			std::memcpy(_buffer.get() + _buffered, bytes, static_cast<size_t>(size));
+			_buffered += static_cast<size_t>(size);
+			return;
+		}
+
+		flush();
+		if (size >= _buffer_size) {
+			_stream.write(bytes, static_cast<std::streamsize>(size));
+			return;
+		}
+		std::memcpy(_buffer.get(), bytes, static_cast<size_t>(size));
+		_buffered = static_cast<size_t>(size);
+	}
+
+	void fbx_block_writer::write_zeros(uint64_t size) {
+		while (size > 0) {
+			if (_buffered == _buffer_size) {
+				flush();
+			}
+			size_t count = static_cast<size_t>(std::min<uint64_t>(size, _buffer_size - _buffered));
+			std::memset(_buffer.get() + _buffered, 0, count);
+			_buffered += count;
+			_written += count;
+			size -= count;
+		}
+	}
+
+	bool fbx_block_writer::flush() {
+		if (_buffered > 0) {
+			_stream.write(_buffer.get(), static_cast<std::streamsize>(_buffered));
+			_buffered = 0;
+		}
+		return static_cast<bool>(_stream);
+	}
+
+	uint64_t fbx_block_writer::get_written_bytes() const {
+		return _written;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+namespace solar {
+
+	//buffered writes of large contiguous blocks to a stream. small writes are gathered into the buffer, writes at
+	//least as big as the buffer go straight to the stream so big vertex and index arrays are never copied.
+
+	class fbx_block_writer {
+	public:
+		static const size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+	private:
+		std::ostream& _stream;
+		std::unique_ptr<char[]> _buffer;
+		size_t _buffer_size;
+		size_t _buffered;
+		uint64_t _written; //bytes handed to write and write_zeros, buffered or not
+
+	public:
+		fbx_block_writer(std::ostream& stream, size_t buffer_size = DEFAULT_BUFFER_SIZE);
+		fbx_block_writer(const fbx_block_writer&) = delete;
+		fbx_block_writer& operator=(const fbx_block_writer&) = delete;
+		~fbx_block_writer();
+
+		void write(const void* data, uint64_t size);
+		void write_zeros(uint64_t size);
+		bool flush(); //returns false if the stream failed
+
+		uint64_t get_written_bytes() const;
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,468 @@
+#include "fbx_bvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "solar/utility/assert.h"
+
+namespace solar {
+
+	namespace {
+
+		const float TRAVERSAL_COST = 1.f; //relative to intersecting one triangle
+
+		float dot_product(const vec3& a, const vec3& b) {
+			return a._x * b._x + a._y * b._y + a._z * b._z;
+		}
+
+		vec3 cross_product(const vec3& a, const vec3& b) {
+			return vec3(
+				a._y * b._z - a._z * b._y,
+				a._z * b._x - a._x * b._z,
+				a._x * b._y - a._y * b._x);
+		}
+
+		vec3 min_vec3(const vec3& a, const vec3& b) {
+			return vec3(std::min(a._x, b._x), std::min(a._y, b._y), std::min(a._z, b._z));
+		}
+
+		vec3 max_vec3(const vec3& a, const vec3& b) {
+			return vec3(std::max(a._x, b._x), std::max(a._y, b._y), std::max(a._z, b._z));
+		}
+
+		float get_axis(const vec3& v, int axis) {
+			return (axis == 0) ? v._x : (axis == 1) ? v._y : v._z;
+		}
+
+		float get_surface_area(const vec3& min, const vec3& max) {
+			vec3 d = max - min;
+			return 2.f * (d._x * d._y + d._y * d._z + d._z * d._x);
+		}
+
+		float safe_inverse(float x) {
+			const float LARGE = 1e30f;
+			return (std::fabs(x) > 1e-30f) ? 1.f / x : (x < 0.f ? -LARGE : LARGE);
+		}
+
+	}
+
+	void fbx_bvh::build(const std::vector<vec3>& positions, const std::vector<unsigned int>& indices) {
+		_nodes.clear();
+		_triangle_indices.clear();
+
+		int triangle_count = static_cast<int>(indices.size() / 3);
+		if (triangle_count == 0) {
+			return;
+		}
+
+		std::vector<vec3> triangle_mins(triangle_count);
+		std::vector<vec3> triangle_maxs(triangle_count);
+		std::vector<vec3> centroids(triangle_count);
+		_triangle_indices.resize(triangle_count);
+		for (int i_triangle = 0; i_triangle < triangle_count; ++i_triangle) {
+			const vec3& p0 = positions[indices[i_triangle * 3 + 0]];
+			const vec3& p1 = positions[indices[i_triangle * 3 + 1]];
+			const vec3& p2 = positions[indices[i_triangle * 3 + 2]];
+			triangle_mins[i_triangle] = min_vec3(p0, min_vec3(p1, p2));
+			triangle_maxs[i_triangle] = max_vec3(p0, max_vec3(p1, p2));
+			centroids[i_triangle] = (triangle_mins[i_triangle] + triangle_maxs[i_triangle]) * 0.5f;
+			_triangle_indices[i_triangle] = static_cast<uint32_t>(i_triangle);
+		}
+		_nodes.reserve(triangle_count * 2 / 3 + 1);
+
+		bin bins[BIN_COUNT];
+		float right_costs[BIN_COUNT];
+		std::vector<build_task> tasks;
+		tasks.push_back(build_task{ 0, triangle_count, -1, 0 });
+		while (!tasks.empty()) {
+			build_task task = tasks.back();
+			tasks.pop_back();
+
+			int node_index = static_cast<int>(_nodes.size());
+			if (task._parent_index >= 0) {
+				_nodes[task._parent_index]._offset = static_cast<uint32_t>(node_index);
+			}
+
+			vec3 min = triangle_mins[_triangle_indices[task._begin]];
+			vec3 max = triangle_maxs[_triangle_indices[task._begin]];
+			vec3 centroid_min = centroids[_triangle_indices[task._begin]];
+			vec3 centroid_max = centroid_min;
+			for (int i = task._begin; i < task._end; ++i) {
+				uint32_t i_triangle = _triangle_indices[i];
+				min = min_vec3(min, triangle_mins[i_triangle]);
+				max = max_vec3(max, triangle_maxs[i_triangle]);
+				centroid_min = min_vec3(centroid_min, centroids[i_triangle]);
+				centroid_max = max_vec3(centroid_max, centroids[i_triangle]);
+			}
+
+			fbx_bvh_node node;
+			node._min[0] = min._x;
+			node._min[1] = min._y;
+			node._min[2] = min._z;
+			node._max[0] = max._x;
+			node._max[1] = max._y;
+			node._max[2] = max._z;
+			node._offset = static_cast<uint32_t>(task._begin);
+			node._count = static_cast<uint32_t>(task._end - task._begin);
+
+			int count = task._end - task._begin;
+			int split = -1;
+			if (count > 1 && task._depth < MAX_DEPTH) {
+				//evaluate the SAH at every bin boundary of every axis.
+				float parent_area = get_surface_area(min, max);
+				float best_cost = std::numeric_limits<float>::max();
+				int best_axis = -1;
+				int best_bin = -1;
+				for (int axis = 0; axis < 3; ++axis) {
+					float axis_min = get_axis(centroid_min, axis);
+					float extent = get_axis(centroid_max, axis) - axis_min;
+					if (extent <= 0.f) {
+						continue;
+					}
+					float scale = BIN_COUNT / extent;
+
+					for (auto& b : bins) {
+						b._count = 0;
+					}
+					for (int i = task._begin; i < task._end; ++i) {
+						uint32_t i_triangle = _triangle_indices[i];
+						int i_bin = std::min(BIN_COUNT - 1, static_cast<int>((get_axis(centroids[i_triangle], axis) - axis_min) * scale));
+						bin& b = bins[i_bin];
+						b._min = (b._count == 0) ? triangle_mins[i_triangle] : min_vec3(b._min, triangle_mins[i_triangle]);
+						b._max = (b._count == 0) ? triangle_maxs[i_triangle] : max_vec3(b._max, triangle_maxs[i_triangle]);
+						++b._count;
+					}
+
+					vec3 right_min;
+					vec3 right_max;
+					int right_count = 0;
+					for (int i_bin = BIN_COUNT - 1; i_bin > 0; --i_bin) {
+						const bin& b = bins[i_bin];
+						if (b._count > 0) {
+							right_min = (right_count == 0) ? b._min : min_vec3(right_min, b._min);
+							right_max = (right_count == 0) ? b._max : max_vec3(right_max, b._max);
+							right_count += b._count;
+						}
+						right_costs[i_bin] = (right_count > 0) ? get_surface_area(right_min, right_max) * right_count : 0.f;
+					}
+
+					vec3 left_min;
+					vec3 left_max;
+					int left_count = 0;
+					for (int i_bin = 0; i_bin < BIN_COUNT - 1; ++i_bin) {
+						const bin& b = bins[i_bin];
+						if (b._count > 0) {
+							left_min = (left_count == 0) ? b._min : min_vec3(left_min, b._min);
+							left_max = (left_count == 0) ? b._max : max_vec3(left_max, b._max);
+							left_count += b._count;
+						}
+						if (left_count == 0 || left_count == count) {
+							continue;
+						}
+						float cost = TRAVERSAL_COST + (get_surface_area(left_min, left_max) * left_count + right_costs[i_bin + 1]) / parent_area;
+						if (cost < best_cost) {
+							best_cost = cost;
+							best_axis = axis;
+							best_bin = i_bin;
+						}
+					}
+				}
+
+				if (best_axis >= 0 && (best_cost < count || count > MAX_LEAF_TRIANGLE_COUNT)) {
+					float axis_min = get_axis(centroid_min, best_axis);
+					float scale = BIN_COUNT / (get_axis(centroid_max, best_axis) - axis_min);
+					auto middle = std::partition(_triangle_indices.begin() + task._begin, _triangle_indices.begin() + task._end, [&](uint32_t i_triangle) {
+						int i_bin = std::min(BIN_COUNT - 1, static_cast<int>((get_axis(centroids[i_triangle], best_axis) - axis_min) * scale));
+						return i_bin <= best_bin;
+					});
+					split = static_cast<int>(middle - _triangle_indices.begin());
+				}
+				else if (best_axis < 0 && count > MAX_LEAF_TRIANGLE_COUNT) {
+					split = task._begin + count / 2; //every centroid is the same point, any split is as good as another
+				}
+				if (split == task._begin || split == task._end) {
+					split = task._begin + count / 2;
+				}
+			}
+
+			if (split >= 0) {
+				node._offset = 0; //patched once the second child is emitted
+				node._count = 0;
+			}
+			_nodes.push_back(node);
+
+			if (split >= 0) {
+				//second child first so the first child is emitted right after this node.
+				tasks.push_back(build_task{ split, task._end, node_index, task._depth + 1 });
+				tasks.push_back(build_task{ task._begin, split, -1, task._depth + 1 });
+			}
+		}
+	}
+
+	bool fbx_bvh::empty() const {
+		return _nodes.empty();
+	}
+
+	int fbx_bvh::get_leaf_count() const {
+		return static_cast<int>(std::count_if(_nodes.begin(), _nodes.end(), [](const fbx_bvh_node& node) { return node.is_leaf(); }));
+	}
+
+	bool fbx_bvh::raycast(
+		const std::vector<vec3>& positions,
+		const std::vector<unsigned int>& indices,
+		const vec3& origin,
+		const vec3& direction,
+		float max_t,
+		float& hit_t,
+		int& hit_triangle) const {
+
+		hit_t = max_t;
+		hit_triangle = -1;
+		if (_nodes.empty()) {
+			return false;
+		}
+
+		vec3 inverse_direction(safe_inverse(direction._x), safe_inverse(direction._y), safe_inverse(direction._z));
+
+		//depth first, a node pushes at most its two children so the stack never outgrows the depth.
+		int stack_nodes[MAX_DEPTH * 2 + 2];
+		float stack_ts[MAX_DEPTH * 2 + 2];
+		int stack_size = 0;
+
+		float root_t;
+		if (intersect_box(_nodes[0], origin, inverse_direction, hit_t, root_t)) {
+			stack_nodes[stack_size] = 0;
+			stack_ts[stack_size] = root_t;
+			++stack_size;
+		}
+
+		while (stack_size > 0) {
+			--stack_size;
+			if (stack_ts[stack_size] >= hit_t) {
+				continue; //a closer hit was found since this node was pushed
+			}
+			int node_index = stack_nodes[stack_size];
+			const auto& node = _nodes[node_index];
+
+			if (node.is_leaf()) {
+				for (uint32_t i = node._offset; i < node._offset + node._count; ++i) {
+					int i_triangle = static_cast<int>(_triangle_indices[i]);
+					float t;
+					if (intersect_triangle(origin, direction, positions[indices[i_triangle * 3 + 0]], positions[indices[i_triangle * 3 + 1]], positions[indices[i_triangle * 3 + 2]], t) && t < hit_t) {
+						hit_t = t;
+						hit_triangle = i_triangle;
+					}
+				}
+				continue;
+			}
+
+			int first = node_index + 1;
+			int second = static_cast<int>(node._offset);
+			float first_t;
+			float second_t;
+			bool is_first_hit = intersect_box(_nodes[first], origin, inverse_direction, hit_t, first_t);
+			bool is_second_hit = intersect_box(_nodes[second], origin, inverse_direction, hit_t, second_t);
+			if (is_first_hit && is_second_hit && second_t < first_t) {
+				std::swap(first, second);
+				std::swap(first_t, second_t);
+			}
+			//the nearer child is pushed last so it's visited first.
+			if (is_second_hit) {
+				stack_nodes[stack_size] = second;
+				stack_ts[stack_size] = second_t;
+				++stack_size;
+			}
+			if (is_first_hit) {
+				stack_nodes[stack_size] = first;
+				stack_ts[stack_size] = first_t;
+				++stack_size;
+			}
+		}
+		return hit_triangle >= 0;
+	}
+
+	bool fbx_bvh::raycast_brute_force(
+		const std::vector<vec3>& positions,
+		const std::vector<unsigned int>& indices,
+		const vec3& origin,
+		const vec3& direction,
+		float max_t,
+		float& hit_t,
+		int& hit_triangle) {
+
+		hit_t = max_t;
+		hit_triangle = -1;
+		int triangle_count = static_cast<int>(indices.size() / 3);
+		for (int i_triangle = 0; i_triangle < triangle_count; ++i_triangle) {
+			float t;
+			if (intersect_triangle(origin, direction, positions[indices[i_triangle * 3 + 0]], positions[indices[i_triangle * 3 + 1]], positions[indices[i_triangle * 3 + 2]], t) && t < hit_t) {
+				hit_t = t;
+				hit_triangle = i_triangle;
+			}
+		}
+		return hit_triangle >= 0;
+	}
+
+	bool fbx_bvh::find_closest(
+		const std::vector<vec3>& positions,
+		const std::vector<unsigned int>& indices,
+		const vec3& point,
+		float max_distance,
+		float& closest_distance,
+		int& closest_triangle) const {
+
+		closest_distance = max_distance;
+		closest_triangle = -1;
+		if (_nodes.empty()) {
+			return false;
+		}
+
+		float closest_distance_squared = max_distance * max_distance;
+
+		int stack_nodes[MAX_DEPTH * 2 + 2];
+		float stack_distances_squared[MAX_DEPTH * 2 + 2];
+		int stack_size = 0;
+
+		stack_nodes[stack_size] = 0;
+		stack_distances_squared[stack_size] = get_box_distance_squared(_nodes[0], point);
+		++stack_size;
+
+		while (stack_size > 0) {
+			--stack_size;
+			if (stack_distances_squared[stack_size] >= closest_distance_squared) {
+				continue; //a closer triangle was found since this node was pushed
+			}
+			int node_index = stack_nodes[stack_size];
+			const auto& node = _nodes[node_index];
+
+			if (node.is_leaf()) {
+				for (uint32_t i = node._offset; i < node._offset + node._count; ++i) {
+					int i_triangle = static_cast<int>(_triangle_indices[i]);
+					vec3 closest = get_closest_point_on_triangle(point, positions[indices[i_triangle * 3 + 0]], positions[indices[i_triangle * 3 + 1]], positions[indices[i_triangle * 3 + 2]]);
+					vec3 to_closest = closest - point;
+					float distance_squared = dot_product(to_closest, to_closest);
+					if (distance_squared < closest_distance_squared) {
+						closest_distance_squared = distance_squared;
+						closest_triangle = i_triangle;
+					}
+				}
+				continue;
+			}
+
+			int first = node_index + 1;
+			int second = static_cast<int>(node._offset);
+			float first_distance_squared = get_box_distance_squared(_nodes[first], point);
+			float second_distance_squared = get_box_distance_squared(_nodes[second], point);
+			if (second_distance_squared < first_distance_squared) {
+				std::swap(first, second);
+				std::swap(first_distance_squared, second_distance_squared);
+			}
+			//the nearer child is pushed last so it's visited first.
+			if (second_distance_squared < closest_distance_squared) {
+				stack_nodes[stack_size] = second;
+				stack_distances_squared[stack_size] = second_distance_squared;
+				++stack_size;
+			}
+			if (first_distance_squared < closest_distance_squared) {
+				stack_nodes[stack_size] = first;
+				stack_distances_squared[stack_size] = first_distance_squared;
+				++stack_size;
+			}
+		}
+		if (closest_triangle >= 0) {
+			closest_distance = std::sqrt(closest_distance_squared);
+		}
+		return closest_triangle >= 0;
+	}
+
+	bool fbx_bvh::intersect_triangle(const vec3& origin, const vec3& direction, const vec3& p0, const vec3& p1, const vec3& p2, float& t) {
+		//Moller, Trumbore, "Fast, Minimum Storage Ray/Triangle Intersection"
+		vec3 edge1 = p1 - p0;
+		vec3 edge2 = p2 - p0;
+		vec3 p = cross_product(direction, edge2);
+		float determinant = dot_product(edge1, p);
+		if (determinant == 0.f) {
+			return false;
+		}
+		float inverse_determinant = 1.f / determinant;
+		vec3 to_origin = origin - p0;
+		float u = dot_product(to_origin, p) * inverse_determinant;
+		if (u < 0.f || u > 1.f) {
+			return false;
+		}
+		vec3 q = cross_product(to_origin, edge1);
+		float v = dot_product(direction, q) * inverse_determinant;
+		if (v < 0.f || u + v > 1.f) {
+			return false;
+		}
+		t = dot_product(edge2, q) * inverse_determinant;
+		return t > 0.f;
+	}
+
+	bool fbx_bvh::intersect_box(const fbx_bvh_node& node, const vec3& origin, const vec3& inverse_direction, float max_t, float& t) {
+		float t0x = (node._min[0] - origin._x) * inverse_direction._x;
+		float t1x = (node._max[0] - origin._x) * inverse_direction._x;
+		float t0y = (node._min[1] - origin._y) * inverse_direction._y;
+		float t1y = (node._max[1] - origin._y) * inverse_direction._y;
+		float t0z = (node._min[2] - origin._z) * inverse_direction._z;
+		float t1z = (node._max[2] - origin._z) * inverse_direction._z;
+		float t_enter = std::max(std::max(std::min(t0x, t1x), std::min(t0y, t1y)), std::max(std::min(t0z, t1z), 0.f));
+		float t_exit = std::min(std::min(std::max(t0x, t1x), std::max(t0y, t1y)), std::min(std::max(t0z, t1z), max_t));
+		t = t_enter;
+		return t_enter <= t_exit;
+	}
+
+	float fbx_bvh::get_box_distance_squared(const fbx_bvh_node& node, const vec3& point) {
+		float dx = std::max(std::max(node._min[0] - point._x, point._x - node._max[0]), 0.f);
+		float dy = std::max(std::max(node._min[1] - point._y, point._y - node._max[1]), 0.f);
+		float dz = std::max(std::max(node._min[2] - point._z, point._z - node._max[2]), 0.f);
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	vec3 fbx_bvh::get_closest_point_on_triangle(const vec3& point, const vec3& p0, const vec3& p1, const vec3& p2) {
+		//Ericson, "Real-Time Collision Detection" 5.1.5, picks the voronoi region of the triangle point is in.
+		vec3 ab = p1 - p0;
+		vec3 ac = p2 - p0;
+		vec3 ap = point - p0;
+		float d1 = dot_product(ab, ap);
+		float d2 = dot_product(ac, ap);
+		if (d1 <= 0.f && d2 <= 0.f) {
+			return p0;
+		}
+		vec3 bp = point - p1;
+		float d3 = dot_product(ab, bp);
+		float d4 = dot_product(ac, bp);
+		if (d3 >= 0.f && d4 <= d3) {
+			return p1;
+		}
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+			float v = d1 / (d1 - d3);
+			return p0 + ab * v;
+		}
+		vec3 cp = point - p2;
+		float d5 = dot_product(ab, cp);
+		float d6 = dot_product(ac, cp);
+		if (d6 >= 0.f && d5 <= d6) {
+			return p2;
+		}
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+			float w = d2 / (d2 - d6);
+			return p0 + ac * w;
+		}
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) {
+			float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			return p1 + (p2 - p1) * w;
+		}
+		float denominator = va + vb + vc;
+		if (denominator <= 0.f) {
+			return p0; //degenerate, every region test failed
+		}
+		float v = vb / denominator;
+		float w = vc / denominator;
+		return p0 + ab * v + ac * w;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "solar/math/vec3.h"
+
+namespace solar {
+
+	//32 bytes so two nodes share a cache line. nodes are stored depth first, an interior node's first child is the
+	//next node and _offset is its second child. a leaf has _count > 0 triangles starting at _offset in
+	//fbx_bvh::_triangle_indices.
+	class fbx_bvh_node {
+	public:
+		float _min[3];
+		uint32_t _offset;
+		float _max[3];
+		uint32_t _count;
+
+	public:
+		bool is_leaf() const {
+			return _count > 0;
+		}
+	};
+
+	static_assert(sizeof(fbx_bvh_node) == 32, "fbx_bvh_node is meant to be 32 bytes");
+
+	//bounding volume hierarchy over a triangle list, split with the surface area heuristic evaluated over binned
+	//triangle centroids (Wald, "On fast Construction of SAH-based Bounding Volume Hierarchies").
+	//
+	//indices are absolute (not submesh relative), triangles are referred to by their index in them.
+
+	class fbx_bvh {
+	public:
+		static const int BIN_COUNT = 16;
+		static const int MAX_LEAF_TRIANGLE_COUNT = 8; //leaves are only made this big when splitting costs more
+		static const int MAX_DEPTH = 64;
+
+	private:
+		class build_task {
+		public:
+			int _begin;
+			int _end;
+			int _parent_index; //patched with this node's index when it's the second child, -1 otherwise
+			int _depth;
+		};
+
+		class bin {
+		public:
+			vec3 _min;
+			vec3 _max;
+			int _count;
+		};
+
+	public:
+		std::vector<fbx_bvh_node> _nodes;
+		std::vector<uint32_t> _triangle_indices;
+
+	public:
+		void build(const std::vector<vec3>& positions, const std::vector<unsigned int>& indices);
+		bool empty() const;
+		int get_leaf_count() const;
+
+		//closest hit along origin + direction * t for t in (0, max_t). hits both faces of a triangle.
+		bool raycast(
+			const std::vector<vec3>& positions,
+			const std::vector<unsigned int>& indices,
+			const vec3& origin,
+			const vec3& direction,
+			float max_t,
+			float& hit_t,
+			int& hit_triangle) const;
+
+		//same result as raycast but tests every triangle, for validating and benchmarking raycast.
+		static bool raycast_brute_force(
+			const std::vector<vec3>& positions,
+			const std::vector<unsigned int>& indices,
+			const vec3& origin,
+			const vec3& direction,
+			float max_t,
+			float& hit_t,
+			int& hit_triangle);
+
+		//closest point of any triangle to point, searching within max_distance.
+		bool find_closest(
+			const std::vector<vec3>& positions,
+			const std::vector<unsigned int>& indices,
+			const vec3& point,
+			float max_distance,
+			float& closest_distance,
+			int& closest_triangle) const;
+
+	private:
+		static bool intersect_triangle(const vec3& origin, const vec3& direction, const vec3& p0, const vec3& p1, const vec3& p2, float& t);
+		static bool intersect_box(const fbx_bvh_node& node, const vec3& origin, const vec3& inverse_direction, float max_t, float& t);
+		static float get_box_distance_squared(const fbx_bvh_node& node, const vec3& point);
+		static vec3 get_closest_point_on_triangle(const vec3& point, const vec3& p0, const vec3& p1, const vec3& p2);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "fbx_conversion_cache.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include "solar/strings/string_build.h"
+#include "fbx_sha256.h"
+
+namespace solar {
+
+	namespace {
+
+		const char* ENTRY_EXTENSION = ".mesh";
+
+		uint64_t filetime_to_uint64(const FILETIME& ft) {
+			return (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+		}
+
+		void touch_file(const std::string& path) {
+			HANDLE handle = ::CreateFileA(path.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (handle != INVALID_HANDLE_VALUE) {
+				FILETIME now;
+				::GetSystemTimeAsFileTime(&now);
+				::SetFileTime(handle, nullptr, nullptr, &now);
+				::CloseHandle(handle);
+			}
+		}
+
+		class cache_entry {
+		public:
+			std::string _path;
+			uint64_t _size;
+			uint64_t _last_used_time;
+		};
+
+	}
+
+	fbx_conversion_cache::fbx_conversion_cache(const std::string& dir_path, uint64_t max_size, const std::string& options_key)
+		: _dir_path(dir_path)
+		, _max_size(max_size)
+		, _options_key(options_key) {
+
+		::CreateDirectoryA(_dir_path.c_str(), nullptr);
+	}
+
+	std::string fbx_conversion_cache::make_key(const std::string& input_path) const {
+		std::ifstream input(input_path, std::ios::binary);
+		if (!input) {
+			return "";
+		}
+
+		fbx_sha256 sha;
+		sha.add_string(_options_key);
+
+		std::vector<char> buffer(1024 * 1024);
+		while (input) {
+			input.read(buffer.data(), buffer.size());
+			sha.add_bytes(buffer.data(), static_cast<size_t>(input.gcount()));
+		}
+
+		return sha.finish_to_hex_string();
+	}
+
+	bool fbx_conversion_cache::try_restore(const std::string& key, const std::string& output_path) const {
+		auto entry_path = get_entry_path(key);
+		if (::GetFileAttributesA(entry_path.c_str()) == INVALID_FILE_ATTRIBUTES) {
+			return false;
+		}
+
+		break_hard_link(output_path);
+		if (!::CreateHardLinkA(output_path.c_str(), entry_path.c_str(), nullptr)) {
+			//different volume, FAT, etc.
+			if (!::CopyFileA(entry_path.c_str(), output_path.c_str(), FALSE)) {
+				return false;
+			}
+		}
+
+		touch_file(entry_path);
+		return true;
+	}
+
+	void fbx_conversion_cache::store(const std::string& key, const std::string& output_path) const {
+		//copy (never link) into the store so later writes to the output can't change the entry, then rename into
+		//place so a concurrent reader never sees a partial entry.
+		auto entry_path = get_entry_path(key);
+		auto temp_path = build_string("{}.{}.tmp", entry_path, ::GetCurrentThreadId());
+		if (::CopyFileA(output_path.c_str(), temp_path.c_str(), FALSE)) {
+			if (!::MoveFileExA(temp_path.c_str(), entry_path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+				::DeleteFileA(temp_path.c_str());
+			}
+		}
+	}
+
+	void fbx_conversion_cache::evict() const {
+		std::vector<cache_entry> entries;
+		uint64_t total_size = 0;
+
+		WIN32_FIND_DATAA find_data;
+		HANDLE find_handle = ::FindFirstFileA((_dir_path + "\\*" + ENTRY_EXTENSION).c_str(), &find_data);
+		if (find_handle == INVALID_HANDLE_VALUE) {
+			return;
+		}
+		do {
+			if ((find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+				cache_entry entry;
+				entry._path = _dir_path + "\\" + find_data.cFileName;
+				entry._size = (static_cast<uint64_t>(find_data.nFileSizeHigh) << 32) | find_data.nFileSizeLow;
+				entry._last_used_time = filetime_to_uint64(find_data.ftLastWriteTime);
+				entries.push_back(entry);
+				total_size += entry._size;
+			}
+		} while (::FindNextFileA(find_handle, &find_data));
+		::FindClose(find_handle);
+
+		if (total_size <= _max_size) {
+			return;
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const cache_entry& a, const cache_entry& b) {
+			return a._last_used_time < b._last_used_time;
+		});
+
+		for (const auto& entry : entries) {
+			if (total_size <= _max_size) {
+				break;
+			}
+			if (::DeleteFileA(entry._path.c_str())) {
+				total_size -= entry._size;
+			}
+		}
+	}
+
+	void fbx_conversion_cache::break_hard_link(const std::string& output_path) {
+		//outputs restored from the cache may be hard links to an entry. writing into one in place would change the
+		//entry too, so always start from a fresh file.
+		::DeleteFileA(output_path.c_str());
+	}
+
+	std::string fbx_conversion_cache::get_entry_path(const std::string& key) const {
+		return _dir_path + "\\" + key + ENTRY_EXTENSION;
+	}
+
+}
\ No newline at end of file
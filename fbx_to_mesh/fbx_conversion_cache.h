@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace solar {
+
+	//local directory store of previously written .mesh files keyed on the SHA-256 of the input .fbx bytes and every
+	//option that affects output (format, converter params, converter version).
+	//
+	//a hit hard links (or copies if linking fails) the cached file to the output path without touching the fbx sdk.
+	//entries are touched on every hit and evict() removes the least recently used entries until the store fits in
+	//its size budget.
+
+	class fbx_conversion_cache {
+	private:
+		std::string _dir_path;
+		uint64_t _max_size;
+		std::string _options_key;
+
+	public:
+		fbx_conversion_cache(const std::string& dir_path, uint64_t max_size, const std::string& options_key);
+
+		std::string make_key(const std::string& input_path) const; //empty if input can't be read
+		bool try_restore(const std::string& key, const std::string& output_path) const;
+		void store(const std::string& key, const std::string& output_path) const;
+		void evict() const;
+
+		static void break_hard_link(const std::string& output_path);
+
+	private:
+		std::string get_entry_path(const std::string& key) const;
+	};
+
+}
\ No newline at end of file
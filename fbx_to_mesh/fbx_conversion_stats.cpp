@@ -0,0 +1,71 @@
+#include "fbx_conversion_stats.h"
+
+namespace solar {
+
+	namespace {
+
+		float bytes_to_mb(uint64_t bytes) {
+			//archives have no 64 bit integers, megabytes fit a float with plenty of precision.
+			return static_cast<float>(static_cast<double>(bytes) / (1024.0 * 1024.0));
+		}
+
+		float bytes_to_mb(int64_t bytes) {
+			return static_cast<float>(static_cast<double>(bytes) / (1024.0 * 1024.0));
+		}
+
+	}
+
+	fbx_conversion_stats::fbx_conversion_stats() {
+		clear();
+	}
+
+	void fbx_conversion_stats::clear() {
+		_stages.clear();
+		_polygon_vertex_count = 0;
+		_triangle_count = 0;
+		_vertex_count = 0;
+		_welded_vertex_count = 0;
+		_output_vertex_count = 0;
+		_output_triangle_count = 0;
+		_scratch_memory_bytes = 0;
+		_instanced_mesh_count = 0;
+		_instance_count = 0;
+		_instancing_saved_bytes = 0;
+	}
+
+	void fbx_conversion_stats::add_stage(const std::string& name, double milliseconds, uint64_t scratch_memory_bytes) {
+		stage new_stage;
+		new_stage._name = name;
+		new_stage._milliseconds = milliseconds;
+		new_stage._scratch_memory_bytes = scratch_memory_bytes;
+		_stages.push_back(new_stage);
+	}
+
+	double fbx_conversion_stats::get_total_milliseconds() const {
+		double milliseconds = 0.0;
+		for (const auto& stage : _stages) {
+			milliseconds += stage._milliseconds;
+		}
+		return milliseconds;
+	}
+
+	void fbx_conversion_stats::write_to_archive(archive_writer& writer) const {
+		writer.write_float("milliseconds", static_cast<float>(get_total_milliseconds()));
+		writer.write_int("polygon_vertex_count", _polygon_vertex_count);
+		writer.write_int("triangle_count", _triangle_count);
+		writer.write_int("vertex_count", _vertex_count);
+		writer.write_int("welded_vertex_count", _welded_vertex_count);
+		writer.write_int("output_vertex_count", _output_vertex_count);
+		writer.write_int("output_triangle_count", _output_triangle_count);
+		writer.write_float("scratch_memory_mb", bytes_to_mb(_scratch_memory_bytes));
+		writer.write_int("instanced_mesh_count", _instanced_mesh_count);
+		writer.write_int("instance_count", _instance_count);
+		writer.write_float("instancing_saved_mb", bytes_to_mb(_instancing_saved_bytes));
+		writer.write_objects("stages", static_cast<unsigned int>(_stages.size()), [this](archive_writer& writer, unsigned int i) {
+			writer.write_string("name", _stages[i]._name);
+			writer.write_float("milliseconds", static_cast<float>(_stages[i]._milliseconds));
+			writer.write_float("scratch_memory_mb", bytes_to_mb(_stages[i]._scratch_memory_bytes));
+		});
+	}
+
+}
\ No newline at end of file
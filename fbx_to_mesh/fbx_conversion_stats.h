@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "solar/archiving/archive_writer.h"
+
+namespace solar {
+
+	//timings, memory and counts of one conversion, see --stats.
+	//
+	//memory is the conversion's own scratch memory, taken from its converter's arena, so it doesn't depend on what
+	//other batch workers are doing. the arena only grows during a conversion, each stage's value is the total so
+	//far. the process's peak is written once per batch, see fbx_batch_converter::write_stats_to_archive.
+
+	class fbx_conversion_stats {
+	public:
+		class stage {
+		public:
+			std::string _name;
+			double _milliseconds;
+			uint64_t _scratch_memory_bytes; //taken from the arena by the end of the stage
+		};
+
+	public:
+		std::vector<stage> _stages; //in the order they ran
+		int _polygon_vertex_count; //vertices before dedup
+		int _triangle_count; //triangles before dedup
+		int _vertex_count; //vertices after dedup and welding
+		int _welded_vertex_count; //merged by welding, 0 unless enabled
+		int _output_vertex_count; //after 16 bit submesh splitting, which duplicates vertices shared across submeshes
+		int _output_triangle_count; //of the full detail mesh
+		uint64_t _scratch_memory_bytes; //taken from the pipeline's arena, see fbx_scratch_arena
+		int _instanced_mesh_count; //the counts above don't include instanced meshes
+		int _instance_count; //mesh nodes drawn as instances instead of merged into the mesh
+		int64_t _instancing_saved_bytes; //geometry bytes the instances would have added to the mesh minus their transforms, can be negative
+
+	public:
+		fbx_conversion_stats();
+
+		void clear();
+		void add_stage(const std::string& name, double milliseconds, uint64_t scratch_memory_bytes);
+		double get_total_milliseconds() const;
+
+		void write_to_archive(archive_writer& writer) const;
+	};
+
+}
\ No newline at end of file
@@ -1,13 +1,12 @@
 #include "fbx_converter.h"
 
+#include <unordered_map>
 #include "solar/utility/assert.h"
-#include "solar/utility/alert.h"
-#include "solar/utility/trace.h"
-#include "solar/utility/type_convert.h"
 #include "solar/strings/string_build.h"
-#include "solar/math/mat33.h"
-#include "solar/io/file_path_helpers.h"
 #include "fbx_enum_helpers.h"
+#include "fbx_coordinate_converter.h"
+#include "fbx_mesh_fingerprint.h"
+#include "fbx_parallel_for.h"
 
 //useful references
 //---
@@ -17,378 +16,471 @@
 
 namespace solar {
 
-	fbx_converter::fbx_converter() 
-		: _is_verbose(true) 
-		, _is_warnings_as_errors_enabled(false) {
+	fbx_converter::fbx_converter()
+		: fbx_converter(fbx_converter_params()) {
 	}
 
-	void fbx_converter::reset_internals() {
-		_mesh_def.reset();
-		_mesh_data = fbx_converter_mesh_data();
-		_unduped_vertices.clear();
+	fbx_converter::fbx_converter(const fbx_converter_params& params)
+		: fbx_mesh_pipeline(params)
+		, _manager(nullptr)
+		, _instance_pipeline(params) {
+
+		_manager = FbxManager::Create();
+		FbxIOSettings* ios = FbxIOSettings::Create(_manager, IOSROOT);
+		_manager->SetIOSettings(ios);
+	}
+
+	fbx_converter::~fbx_converter() {
+		_manager->Destroy();
 	}
 
-	std::shared_ptr<mesh_def> fbx_converter::convert_fbx_to_mesh_def(std::string path) {
+	std::shared_ptr<fbx_output_mesh> fbx_converter::convert_fbx_to_output_mesh(std::string path) {
 		
 		reset_internals();
 
-		FbxManager* manager = FbxManager::Create();
-		FbxIOSettings* ios = FbxIOSettings::Create(manager, IOSROOT);
-		manager->SetIOSettings(ios);
-
-		FbxImporter* importer = FbxImporter::Create(manager, "");
-		if (!importer->Initialize(path.c_str(), -1, manager->GetIOSettings())) {
-			ALERT("FbxImporter::Initialize error : {}", importer->GetStatus().GetErrorString());
-		}
-		else {
-			FbxScene* scene = FbxScene::Create(manager, "");
-			importer->Import(scene);
-
-			FbxGeometryConverter geometry_converter(manager);
-			if (!geometry_converter.Triangulate(scene, true)) {
-				add_error_message("Failed to triangulate scene.");
+		FbxImporter* importer = FbxImporter::Create(_manager, "");
+		FbxScene* scene = nullptr;
+		run_stage("import", [&]() {
+			if (!importer->Initialize(path.c_str(), -1, _manager->GetIOSettings())) {
+				add_error_message(build_string("FbxImporter::Initialize error : {}", importer->GetStatus().GetErrorString()));
+			}
+			else {
+				scene = FbxScene::Create(_manager, "");
+				importer->Import(scene);
 			}
+		});
 
-			find_and_process_fbx_mesh(scene);
+		if (scene != nullptr) {
+			run_stage("triangulate", [&]() {
+				FbxGeometryConverter geometry_converter(_manager);
+				if (!geometry_converter.Triangulate(scene, true)) {
+					add_error_message("Failed to triangulate scene.");
+				}
+			});
+
+			find_and_process_fbx_meshes(scene);
 			
 			scene->Destroy();
 		}
 
 		importer->Destroy();
-		manager->Destroy();
 
-		return _mesh_def;
+		return _output_mesh;
 	}
 
-	void fbx_converter::find_and_process_fbx_mesh(FbxScene* scene) {
-		std::vector<FbxMesh*> fbx_meshes;
-		find_fbx_meshes_recursive(fbx_meshes, scene->GetRootNode());
-		if (fbx_meshes.size() == 0) {
+	void fbx_converter::find_and_process_fbx_meshes(FbxScene* scene) {
+		std::vector<mesh_node> mesh_nodes;
+		find_mesh_nodes_recursive(mesh_nodes, scene->GetRootNode());
+		if (mesh_nodes.size() == 0) {
 			add_error_message("No Mesh Node found in Scene.");
 		}
 		else {
-			if (fbx_meshes.size() > 1) {
-				add_warning_message("Multiple Mesh Nodes found in Scene. Ignoring exta nodes.");
+			if (mesh_nodes.size() > 1) {
+				add_verbose_message(build_string("merging {} mesh nodes", mesh_nodes.size()));
+			}
+			run_stage("prepare_mesh_nodes", [&]() { prepare_mesh_nodes(mesh_nodes); });
+
+			std::vector<fbx_output_instanced_mesh> instanced_meshes;
+			if (_params._is_instancing_enabled) {
+				std::vector<std::vector<int>> instance_groups;
+				run_stage("find_instances", [&]() { find_instances(mesh_nodes, instance_groups); });
+				run_stage("build_instanced_meshes", [&]() { build_instanced_meshes(mesh_nodes, instance_groups, instanced_meshes); });
+				mesh_nodes.erase(std::remove_if(mesh_nodes.begin(), mesh_nodes.end(), [](const mesh_node& mesh_node) { return mesh_node._is_instanced; }), mesh_nodes.end());
+			}
+
+			run_stage("build_mesh_data", [&]() { build_mesh_data(mesh_nodes); });
+			run_stage("read_mesh_elements", [&]() { read_mesh_elements(mesh_nodes); });
+			process_mesh_data();
+
+			if (_output_mesh != nullptr) {
+				_output_mesh->_instanced_meshes.swap(instanced_meshes);
 			}
-			process_fbx_mesh(fbx_meshes.at(0));
 		}
 	}
 
-	void fbx_converter::find_fbx_meshes_recursive(std::vector<FbxMesh*>& meshes, FbxNode* node) {
+	void fbx_converter::find_mesh_nodes_recursive(std::vector<mesh_node>& mesh_nodes, FbxNode* node) {
 		auto attribute = node->GetNodeAttribute();
 		if (attribute != nullptr && attribute->GetAttributeType() == FbxNodeAttribute::eMesh) {
-			meshes.push_back(FbxCast<FbxMesh>(attribute));
+			mesh_node new_mesh_node;
+			new_mesh_node._node = node;
+			new_mesh_node._mesh = FbxCast<FbxMesh>(attribute);
+			new_mesh_node._triangle_begin = 0;
+			new_mesh_node._triangle_count = 0;
+			new_mesh_node._control_point_begin = 0;
+			new_mesh_node._control_point_count = 0;
+			new_mesh_node._is_winding_flipped = false;
+			new_mesh_node._is_instanced = false;
+			mesh_nodes.push_back(new_mesh_node);
 		}
 
 		for (int i = 0; i < node->GetChildCount(); ++i) {
-			find_fbx_meshes_recursive(meshes, node->GetChild(i));
+			find_mesh_nodes_recursive(mesh_nodes, node->GetChild(i));
 		}
 	}
 
-	void fbx_converter::process_fbx_mesh(FbxMesh* mesh) {
-		build_mesh_data(mesh);
-		handle_missing_mesh_data();
-		build_unduped_vertices();
-		sort_polygons_by_material_index();
-		build_mesh_def();
+	void fbx_converter::prepare_mesh_nodes(std::vector<mesh_node>& mesh_nodes) {
+		//everything touching the scene (transform evaluation, materials) stays on this thread. nodes that can't be
+		//read keep empty ranges, so the rest of the scene still converts.
+		std::vector<FbxSurfaceMaterial*> fbx_materials;
+		for (auto& mesh_node : mesh_nodes) {
+			add_node_materials(mesh_node, fbx_materials);
+			mesh_node._transform = fbx_node_transform::make_global(mesh_node._node);
+			mesh_node._is_winding_flipped = mesh_node._transform.is_mirrored();
+
+			FbxMesh* mesh = mesh_node._mesh;
+			add_verbose_message(build_string("found {} polygons in {}", mesh->GetPolygonCount(), mesh_node._node->GetName()));
+			if (is_triangle_mesh(mesh)) {
+				mesh_node._triangle_count = mesh->GetPolygonCount();
+				mesh_node._control_point_count = mesh->GetControlPointsCount();
+			}
+		}
 	}
 
-	void fbx_converter::build_mesh_data(FbxMesh* mesh) {
-		ASSERT(_mesh_data._polygons.empty());
-		ASSERT(_mesh_data._polygon_vertices.empty());
-		ASSERT(_mesh_data._control_points.empty());
-
-		_mesh_data._materials.reserve(mesh->GetNode()->GetMaterialCount());
-		_mesh_data._polygons.reserve(mesh->GetPolygonCount());
-		_mesh_data._polygon_vertices.reserve(mesh->GetPolygonVertexCount());
-		_mesh_data._control_points.reserve(mesh->GetControlPointsCount());
+	void fbx_converter::add_node_materials(mesh_node& mesh_node, std::vector<FbxSurfaceMaterial*>& fbx_materials) {
+		//nodes sharing a material object share its entry in the mesh data.
+		FbxNode* node = mesh_node._node;
+		mesh_node._material_indices.resize(node->GetMaterialCount());
+		for (int i_material = 0; i_material < node->GetMaterialCount(); ++i_material) {
+			FbxSurfaceMaterial* fbx_material = node->GetMaterial(i_material);
+			auto found = std::find(fbx_materials.begin(), fbx_materials.end(), fbx_material);
+			if (found != fbx_materials.end()) {
+				mesh_node._material_indices[i_material] = static_cast<int>(found - fbx_materials.begin());
+				continue;
+			}
 
-		for (int i_material = 0; i_material < mesh->GetNode()->GetMaterialCount(); ++i_material) {
-			auto material = make_mesh_data_material(mesh->GetNode()->GetMaterial(i_material));
+			auto material = make_mesh_data_material(fbx_material);
 			add_verbose_message(build_string("found material : {}", material.to_string()));
+			mesh_node._material_indices[i_material] = static_cast<int>(_mesh_data._materials.size());
 			_mesh_data._materials.push_back(material);
+			fbx_materials.push_back(fbx_material);
 		}
+	}
 
-		for (int i_control_point = 0; i_control_point < mesh->GetControlPointsCount(); ++i_control_point) {
-			auto cp = std::make_shared<fbx_converter_mesh_data::control_point>();
-			_mesh_data._control_points.push_back(cp);
-		}
-
-		add_verbose_message(build_string("found {} polygons", mesh->GetPolygonCount()));
+	bool fbx_converter::is_triangle_mesh(FbxMesh* mesh) {
 		for (int i_polygon = 0; i_polygon < mesh->GetPolygonCount(); ++i_polygon) {
 			if (mesh->GetPolygonSize(i_polygon) != 3) {
 				add_error_message(build_string("Polygon of size {} found. Only triangles are supported.", mesh->GetPolygonSize(i_polygon)));
-				break;
+				return false;
 			}
+		}
+		return true;
+	}
 
-			auto new_polygon = std::make_shared<fbx_converter_mesh_data::polygon>();
-			_mesh_data._polygons.push_back(new_polygon);
-
-			for (int i_polygon_vertex = 0; i_polygon_vertex < mesh->GetPolygonSize(i_polygon); ++i_polygon_vertex) {
-				auto pv = std::make_shared<fbx_converter_mesh_data::polygon_vertex>();
-				int control_point_index = mesh->GetPolygonVertex(i_polygon, i_polygon_vertex);
-				pv->_data._position = convert_fbx_to_vec3(mesh->GetControlPointAt(control_point_index));
-
-				_mesh_data._polygon_vertices.push_back(pv);
-				new_polygon->_vertices.at(i_polygon_vertex) = pv;
-				_mesh_data._control_points.at(control_point_index)->_vertices.push_back(pv);
+	void fbx_converter::find_instances(std::vector<mesh_node>& mesh_nodes, std::vector<std::vector<int>>& instance_groups) {
+		//meshes are fingerprinted in parallel, once each however many nodes use them. a node is grouped with the
+		//first node of the same geometry, materials and mirroring, groups of a single node stay merged.
+		std::vector<FbxMesh*> meshes;
+		std::vector<int> node_mesh_indices(mesh_nodes.size(), -1);
+		std::unordered_map<FbxMesh*, int> mesh_indices;
+		for (size_t i_node = 0; i_node < mesh_nodes.size(); ++i_node) {
+			if (mesh_nodes[i_node]._triangle_count == 0) {
+				continue;
 			}
+			auto inserted = mesh_indices.insert(std::make_pair(mesh_nodes[i_node]._mesh, static_cast<int>(meshes.size())));
+			if (inserted.second) {
+				meshes.push_back(mesh_nodes[i_node]._mesh);
+			}
+			node_mesh_indices[i_node] = inserted.first->second;
 		}
 
-		process_mesh_element_per_polygon_vertex<FbxLayerElementNormal, FbxVector4>(
-			mesh,
-			"ElementNormal",
-			[](FbxMesh* mesh) { return mesh->GetElementNormalCount(); },
-			[](FbxMesh* mesh, int i_element) { return mesh->GetElementNormal(i_element); },
-			[&](fbx_converter_mesh_data::polygon_vertex* vertex, FbxVector4 value) {
-				if (vertex->_data._normal.has_value()) {
-					add_error_message("Vertex already has Normal!");
-				}
-				else {
-					vertex->_data._normal = convert_fbx_to_vec3(value);
-				}
-			});
-
-		process_mesh_element_per_polygon_vertex<FbxLayerElementTangent, FbxVector4>(
-			mesh,
-			"ElementTangent",
-			[](FbxMesh* mesh) { return mesh->GetElementTangentCount(); },
-			[](FbxMesh* mesh, int i_element) { return mesh->GetElementTangent(i_element); },
-			[&](fbx_converter_mesh_data::polygon_vertex* vertex, FbxVector4 value) {
-				if (vertex->_data._tangent.has_value()) {
-					add_error_message("Vertex already has Tangent!");
-				}
-				else {
-					vertex->_data._tangent = convert_fbx_to_vec3(value);
-				}
-			});
-
-		process_mesh_element_per_polygon_vertex<FbxLayerElementUV, FbxVector2>(
-			mesh,
-			"ElementUV",
-			[](FbxMesh* mesh) { return mesh->GetElementUVCount(FbxLayerElement::eTextureDiffuse); },
-			[](FbxMesh* mesh, int i_element) { return mesh->GetElementUV(i_element, FbxLayerElement::eTextureDiffuse); },
-			[&](fbx_converter_mesh_data::polygon_vertex* vertex, FbxVector2 value) {
-				if (vertex->_data._uv.has_value()) {
-					add_error_message("Vertex already has UV!");
-				}
-				else {
-					vertex->_data._uv = convert_fbx_to_uv(value);
+		std::vector<std::unique_ptr<fbx_mesh_fingerprint>> fingerprints(meshes.size());
+		fbx_parallel_for(_params._thread_count, static_cast<int>(meshes.size()), MIN_NODES_PER_THREAD, [&](int begin, int end) {
+			for (int i_mesh = begin; i_mesh < end; ++i_mesh) {
+				fingerprints[i_mesh].reset(new fbx_mesh_fingerprint(meshes[i_mesh]));
+			}
+		});
+
+		auto is_same_geometry = [&](int i_node, int i_other_node) {
+			const mesh_node& a = mesh_nodes[i_node];
+			const mesh_node& b = mesh_nodes[i_other_node];
+			int a_mesh_index = node_mesh_indices[i_node];
+			int b_mesh_index = node_mesh_indices[i_other_node];
+			return
+				a._is_winding_flipped == b._is_winding_flipped &&
+				a._material_indices == b._material_indices &&
+				(a_mesh_index == b_mesh_index || fingerprints[a_mesh_index]->is_identical(*fingerprints[b_mesh_index]));
+		};
+
+		std::unordered_multimap<uint64_t, int> first_nodes; //by fingerprint hash
+		std::vector<int> node_first_nodes(mesh_nodes.size(), -1);
+		std::vector<int> node_counts(mesh_nodes.size(), 0); //per first node
+		for (int i_node = 0; i_node < static_cast<int>(mesh_nodes.size()); ++i_node) {
+			if (node_mesh_indices[i_node] < 0) {
+				continue;
+			}
+			uint64_t hash = fingerprints[node_mesh_indices[i_node]]->get_hash();
+			auto candidates = first_nodes.equal_range(hash);
+			for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+				if (is_same_geometry(i_node, candidate->second)) {
+					node_first_nodes[i_node] = candidate->second;
+					break;
 				}
-			});
+			}
+			if (node_first_nodes[i_node] < 0) {
+				first_nodes.insert(std::make_pair(hash, i_node));
+				node_first_nodes[i_node] = i_node;
+			}
+			++node_counts[node_first_nodes[i_node]];
+		}
 
-		process_mesh_element_per_polygon_with_index_to_direct<FbxLayerElementMaterial>(
-			mesh,
-			"ElementMaterial",
-			[](FbxMesh* mesh) { return mesh->GetElementMaterialCount(); },
-			[](FbxMesh* mesh, int i_element) { return mesh->GetElementMaterial(i_element); },
-			[&](fbx_converter_mesh_data::polygon* polygon, int index_to_direct) {
-				if (polygon->_material_index.has_value()) {
-					add_error_message("Polygon already has MaterialIndex!");
-				}
-				else {
-					polygon->_material_index = index_to_direct;
-				}
-			});
+		std::vector<int> first_node_groups(mesh_nodes.size(), -1);
+		for (int i_node = 0; i_node < static_cast<int>(mesh_nodes.size()); ++i_node) {
+			int first_node = node_first_nodes[i_node];
+			if (first_node < 0 || node_counts[first_node] < 2) {
+				continue;
+			}
+			if (first_node_groups[first_node] < 0) {
+				first_node_groups[first_node] = static_cast<int>(instance_groups.size());
+				instance_groups.push_back(std::vector<int>());
+			}
+			instance_groups[first_node_groups[first_node]].push_back(i_node);
+			mesh_nodes[i_node]._is_instanced = true;
+		}
 	}
 
-	fbx_converter_mesh_data::material fbx_converter::make_mesh_data_material(FbxSurfaceMaterial* in_material) {
-
-		fbx_converter_mesh_data::material out_material;
+	void fbx_converter::build_instanced_meshes(const std::vector<mesh_node>& mesh_nodes, const std::vector<std::vector<int>>& instance_groups, std::vector<fbx_output_instanced_mesh>& instanced_meshes) {
+		//the first node of each group is extracted in its local space, then goes through the whole pipeline on its
+		//own. the mesh data's materials are kept for the merged mesh, every instanced mesh gets a copy of them so
+		//material indices mean the same thing everywhere.
+		std::vector<fbx_converter_mesh_data::material> materials;
+		materials.swap(_mesh_data._materials);
+
+		int instance_count = 0;
+		int64_t saved_bytes = 0;
+		for (const auto& instance_group : instance_groups) {
+			std::vector<mesh_node> local_mesh_nodes(1, mesh_nodes[instance_group[0]]);
+			local_mesh_nodes[0]._transform = fbx_node_transform();
+			_mesh_data._materials = materials;
+			build_mesh_data(local_mesh_nodes);
+			read_mesh_elements(local_mesh_nodes);
+
+			fbx_output_instanced_mesh instanced_mesh;
+			instanced_mesh._mesh = _instance_pipeline.convert_mesh_data_to_output_mesh(_mesh_data);
+			_error_count += _instance_pipeline.get_error_count();
+			_warning_count += _instance_pipeline.get_warning_count();
+			_mesh_data.clear();
+			if (instanced_mesh._mesh == nullptr) {
+				continue;
+			}
 
-		//http://docs.autodesk.com/FBX/2014/ENU/FBX-SDK-Documentation/index.html
-		//ImportScene/DisplayMaterial.cxx
+			for (int i_node : instance_group) {
+				fbx_output_instance_transform transform;
+				mesh_nodes[i_node]._transform.get_converted_rows(transform._x_axis, transform._y_axis, transform._z_axis, transform._translation);
+				instanced_mesh._transforms.push_back(transform);
+			}
+			instanced_meshes.push_back(instanced_mesh);
 
-		if (in_material->GetClassId().Is(FbxSurfacePhong::ClassId)) {
-			auto phong = static_cast<FbxSurfacePhong*>(in_material);
-			out_material._diffuse_map_file_name = get_texture_file_name(phong->Diffuse.GetSrcObject<FbxFileTexture>(), "DIFFUSE");
-			out_material._normal_map_file_name = get_texture_file_name(phong->NormalMap.GetSrcObject<FbxFileTexture>(), "NORMAL_MAP");
+			int group_size = static_cast<int>(instance_group.size());
+			instance_count += group_size;
+			saved_bytes += static_cast<int64_t>(instanced_mesh._mesh->get_geometry_bytes()) * (group_size - 1) - static_cast<int64_t>(sizeof(fbx_output_instance_transform)) * group_size;
 		}
-		else if (in_material->GetClassId().Is(FbxSurfaceLambert::ClassId)) {
-			auto lambert = static_cast<FbxSurfaceLambert*>(in_material);
-			out_material._diffuse_map_file_name = get_texture_file_name(lambert->Diffuse.GetSrcObject<FbxFileTexture>(), "DIFFUSE");
-			out_material._normal_map_file_name = get_texture_file_name(lambert->NormalMap.GetSrcObject<FbxFileTexture>(), "NORMAL_MAP");
-		}
-		else {
-			add_error_message(build_string("Unknown Material class type : {}", in_material->GetName()));
-		}
-
-		return out_material;
-	}
 
-	std::string fbx_converter::get_texture_file_name(FbxFileTexture* fbx_file_texture, const char* texture_type) {
-		if (fbx_file_texture == nullptr) {
-			add_error_message(build_string("No {} texture found on material.", texture_type));
-			return "";
+		_mesh_data._materials.swap(materials);
+		_stats._instanced_mesh_count = static_cast<int>(instanced_meshes.size());
+		_stats._instance_count = instance_count;
+		_stats._instancing_saved_bytes = saved_bytes;
+		if (!instanced_meshes.empty()) {
+			add_verbose_message(build_string("instanced {} mesh nodes as {} meshes : {} bytes saved", instance_count, instanced_meshes.size(), saved_bytes));
 		}
-		return fbx_file_texture->GetFileName();
 	}
 
-	void fbx_converter::handle_missing_mesh_data() {
-		
-		if (_mesh_data._materials.empty()) {
-			add_error_message("No materials found");
-			_mesh_data._materials.push_back(fbx_converter_mesh_data::material()); //add a dummy material so material indices can always be valid.
+	void fbx_converter::build_mesh_data(std::vector<mesh_node>& mesh_nodes) {
+		ASSERT(_mesh_data._triangles.empty());
+		ASSERT(_mesh_data._positions.empty());
+		ASSERT(_mesh_data._control_point_vertex_offsets.empty());
+
+		int triangle_count = 0;
+		int control_point_count = 0;
+		for (auto& mesh_node : mesh_nodes) {
+			mesh_node._triangle_begin = triangle_count;
+			mesh_node._control_point_begin = control_point_count;
+			triangle_count += mesh_node._triangle_count;
+			control_point_count += mesh_node._control_point_count;
 		}
 
-		int no_normal_count = 0;
-		int no_tangent_count = 0;
-		int no_uv_count = 0;
-
-		for (auto pv : _mesh_data._polygon_vertices) {
-			if (!pv->_data._normal.has_value()) {
-				no_normal_count++;
-				pv->_data._normal = vec3(1.f, 0.f, 0.f);
-			}
-
-			if (!pv->_data._tangent.has_value()) {
-				no_tangent_count++;
-				pv->_data._tangent = vec3(1.f, 0.f, 0.f);
+		_mesh_data.resize(triangle_count, triangle_count * 3);
+		fbx_parallel_for(_params._thread_count, static_cast<int>(mesh_nodes.size()), MIN_NODES_PER_THREAD, [&](int begin, int end) {
+			extraction_scratch scratch;
+			for (int i_node = begin; i_node < end; ++i_node) {
+				build_node_geometry(mesh_nodes[i_node], scratch);
 			}
+		});
 
-			if (!pv->_data._uv.has_value()) {
-				no_uv_count++;
-				pv->_data._tangent = vec3(1.f, 0.f, 0.f);
-			}
-		}
+		_mesh_data.build_control_point_vertices(control_point_count);
+	}
 
-		if (no_normal_count > 0) {
-			add_warning_message(build_string("{} vertices are missing normals", no_normal_count));
-		}
-		if (no_tangent_count > 0) {
-			add_warning_message(build_string("{} vertices are missing tangents", no_tangent_count));
+	void fbx_converter::build_node_geometry(const mesh_node& mesh_node, extraction_scratch& scratch) {
+		//runs on a worker thread, writes only the node's ranges.
+		if (mesh_node._triangle_count == 0) {
+			return;
 		}
-		if (no_uv_count > 0) {
-			add_warning_message(build_string("{} vertices are missing uvs", no_uv_count));
-		}
-
-		int no_material_count = 0;
 
-		for (auto p : _mesh_data._polygons) {
-			if (!p->_material_index.has_value()) {
-				no_material_count++;
-				p->_material_index = 0;
-			}
-			else if (p->_material_index.value() >= _mesh_data._materials.size()) {
-				add_error_message(build_string("Polygon Material Index is invalid : {}", p->_material_index.value()));
-				p->_material_index = 0;
+		//converted once per control point in one batch, not once per polygon vertex using it.
+		FbxMesh* mesh = mesh_node._mesh;
+		int control_point_count = mesh_node._control_point_count;
+		const vec3* control_points = convert_fbx_values(mesh->GetControlPoints(), control_point_count, mesh_node._transform, fbx_node_transform::POINT, scratch);
+
+		//a mirroring transform turns the triangles inside out, swapping two corners turns them back.
+		const int* polygon_vertices = mesh->GetPolygonVertices();
+		int second_corner = mesh_node._is_winding_flipped ? 2 : 1;
+		int third_corner = mesh_node._is_winding_flipped ? 1 : 2;
+		bool is_any_index_invalid = false;
+		for (int i_triangle = 0; i_triangle < mesh_node._triangle_count; ++i_triangle) {
+			int polygon_vertex_begin = (mesh_node._triangle_begin + i_triangle) * 3;
+			for (int i_corner = 0; i_corner < 3; ++i_corner) {
+				int i_polygon_vertex = polygon_vertex_begin + i_corner;
+				int control_point_index = polygon_vertices[i_triangle * 3 + i_corner];
+				if (control_point_index < 0 || control_point_index >= control_point_count) {
+					is_any_index_invalid = true;
+					control_point_index = 0;
+				}
+				_mesh_data._positions[i_polygon_vertex] = control_points[control_point_index];
+				_mesh_data._control_point_indices[i_polygon_vertex] = mesh_node._control_point_begin + control_point_index;
 			}
+
+			auto& triangle = _mesh_data._triangles[mesh_node._triangle_begin + i_triangle];
+			triangle[0] = polygon_vertex_begin;
+			triangle[second_corner] = polygon_vertex_begin + 1;
+			triangle[third_corner] = polygon_vertex_begin + 2;
 		}
 
-		if (no_material_count > 0) {
-			add_warning_message("{} polygons are missing material index");
+		if (is_any_index_invalid) {
+			add_error_message(build_string("Invalid control point index in {}", mesh_node._node->GetName()));
 		}
 	}
 
-	void fbx_converter::build_unduped_vertices() {
-		//want all vertices that have the exact same data (position,normal,etc) to not be duplicated.
-		ASSERT(_unduped_vertices.empty());
-
-		std::unordered_map<checksum, std::shared_ptr<fbx_converter_mesh_data::polygon_vertex>> checksum_map;
+	void fbx_converter::read_mesh_elements(const std::vector<mesh_node>& mesh_nodes) {
+		fbx_parallel_for(_params._thread_count, static_cast<int>(mesh_nodes.size()), MIN_NODES_PER_THREAD, [&](int begin, int end) {
+			extraction_scratch scratch;
+			for (int i_node = begin; i_node < end; ++i_node) {
+				read_node_elements(mesh_nodes[i_node], scratch);
+			}
+		});
+	}
 
-		for (auto v : _mesh_data._polygon_vertices) {
-			auto checksum = v->_data.get_checksum();
+	void fbx_converter::read_node_elements(const mesh_node& mesh_node, extraction_scratch& scratch) {
+		//runs on a worker thread, the sinks only get the node's own polygon vertices and triangles.
+		if (mesh_node._triangle_count == 0) {
+			return;
+		}
 
-			bool is_dup = false;
-			auto dup_iter = checksum_map.find(checksum);
-			if (dup_iter != checksum_map.end()) {
-				//potential duplicate vertex
-				is_dup = (v->_data == dup_iter->second->_data);
-				if (!is_dup) {
-					add_warning_message("false positive duplicate vertex checksum detected.");
-				}
+		//one sink per attribute, inlined into the specialized loops so they index the arrays directly. the first
+		//element of a kind wins, any later one is reported where it overlaps.
+		auto normal_sink = [&](int i_polygon_vertex, const vec3& value) {
+			unsigned char& flags = _mesh_data._attribute_flags[i_polygon_vertex];
+			if ((flags & fbx_converter_mesh_data::HAS_NORMAL) != 0) {
+				add_error_message("Vertex already has Normal!");
 			}
 			else {
-				checksum_map[checksum] = v;
+				_mesh_data._normals[i_polygon_vertex] = value;
+				flags |= fbx_converter_mesh_data::HAS_NORMAL;
 			}
-
-			if (is_dup) {
-				v->_unduped_vertex_index = dup_iter->second->_unduped_vertex_index;
+		};
+		auto tangent_sink = [&](int i_polygon_vertex, const vec3& value) {
+			unsigned char& flags = _mesh_data._attribute_flags[i_polygon_vertex];
+			if ((flags & fbx_converter_mesh_data::HAS_TANGENT) != 0) {
+				add_error_message("Vertex already has Tangent!");
 			}
 			else {
-				_unduped_vertices.push_back(v->_data);
-				v->_unduped_vertex_index = _unduped_vertices.size() - 1;
+				_mesh_data._tangents[i_polygon_vertex] = value;
+				flags |= fbx_converter_mesh_data::HAS_TANGENT;
 			}
-		}
+		};
+		auto uv_sink = [&](int i_polygon_vertex, const uv& value) {
+			unsigned char& flags = _mesh_data._attribute_flags[i_polygon_vertex];
+			if ((flags & fbx_converter_mesh_data::HAS_UV) != 0) {
+				add_error_message("Vertex already has UV!");
+			}
+			else {
+				_mesh_data._uvs[i_polygon_vertex] = value;
+				flags |= fbx_converter_mesh_data::HAS_UV;
+			}
+		};
+		auto material_sink = [&](int i_triangle, int index_to_direct) {
+			if (_mesh_data._material_indices[i_triangle] != fbx_converter_mesh_data::NO_MATERIAL_INDEX) {
+				add_error_message("Polygon already has MaterialIndex!");
+			}
+			else if (index_to_direct < 0 || index_to_direct >= static_cast<int>(mesh_node._material_indices.size())) {
+				add_error_message(build_string("Polygon Material Index is invalid : {}", index_to_direct));
+			}
+			else {
+				_mesh_data._material_indices[i_triangle] = mesh_node._material_indices[index_to_direct];
+			}
+		};
 
-		add_verbose_message(build_string("found {} unique vertices", _unduped_vertices.size()));
+		FbxMesh* mesh = mesh_node._mesh;
+		int normal_count = mesh->GetElementNormalCount();
+		for (int i_element = 0; i_element < normal_count; ++i_element) {
+			read_polygon_vertex_element(mesh_node, mesh->GetElementNormal(i_element), "ElementNormal", fbx_node_transform::NORMAL, scratch, normal_sink);
+		}
+		int tangent_count = mesh->GetElementTangentCount();
+		for (int i_element = 0; i_element < tangent_count; ++i_element) {
+			read_polygon_vertex_element(mesh_node, mesh->GetElementTangent(i_element), "ElementTangent", fbx_node_transform::DIRECTION, scratch, tangent_sink);
+		}
+		int uv_count = mesh->GetElementUVCount(FbxLayerElement::eTextureDiffuse);
+		for (int i_element = 0; i_element < uv_count; ++i_element) {
+			read_polygon_vertex_element(mesh_node, mesh->GetElementUV(i_element, FbxLayerElement::eTextureDiffuse), "ElementUV", fbx_node_transform::POINT, scratch, uv_sink);
+		}
+		int material_count = mesh->GetElementMaterialCount();
+		for (int i_element = 0; i_element < material_count; ++i_element) {
+			read_polygon_element_indices(mesh_node, mesh->GetElementMaterial(i_element), "ElementMaterial", material_sink);
+		}
 	}
 
-	void fbx_converter::sort_polygons_by_material_index() {
-		//want all triangles with the same material index grouped together to reduce render state changes.
-		std::sort(
-			std::begin(_mesh_data._polygons), 
-			std::end(_mesh_data._polygons),
-			[](std::shared_ptr<fbx_converter_mesh_data::polygon> a, std::shared_ptr<fbx_converter_mesh_data::polygon> b) {
-				return a->_material_index.value() < b->_material_index.value();
-			});
-	}
+	fbx_converter_mesh_data::material fbx_converter::make_mesh_data_material(FbxSurfaceMaterial* in_material) {
 
-	void fbx_converter::build_mesh_def() {
-		auto md = std::make_shared<mesh_def>();
+		fbx_converter_mesh_data::material out_material;
 
-		for (auto material : _mesh_data._materials) {
-			mesh_material mat;
-			mat._diffuse_map = get_file_name_no_path_no_extension(material._diffuse_map_file_name);
-			mat._normal_map = get_file_name_no_path_no_extension(material._normal_map_file_name);
-			md->_materials.push_back(mat);
-		}
+		//http://docs.autodesk.com/FBX/2014/ENU/FBX-SDK-Documentation/index.html
+		//ImportScene/DisplayMaterial.cxx
 
-		for (auto polygon : _mesh_data._polygons) {
-			mesh_triangle tri;
-			//NOTE: reverse winding order due to RH->LH coordinate system.
-			tri._vertex_index_0 = int_to_ushort(polygon->_vertices.at(0)->_unduped_vertex_index.value());
-			tri._vertex_index_1 = int_to_ushort(polygon->_vertices.at(2)->_unduped_vertex_index.value());
-			tri._vertex_index_2 = int_to_ushort(polygon->_vertices.at(1)->_unduped_vertex_index.value());
-			tri._material_index = int_to_ushort(polygon->_material_index.value());
-			md->_triangles.push_back(tri);
+		if (in_material->GetClassId().Is(FbxSurfacePhong::ClassId)) {
+			auto phong = static_cast<FbxSurfacePhong*>(in_material);
+			out_material._diffuse_map_file_name = get_texture_file_name(phong->Diffuse.GetSrcObject<FbxFileTexture>(), "DIFFUSE");
+			out_material._normal_map_file_name = get_texture_file_name(phong->NormalMap.GetSrcObject<FbxFileTexture>(), "NORMAL_MAP");
 		}
-
-		for (auto vertex : _unduped_vertices) {
-			mesh_vertex mesh_vertex;
-			mesh_vertex._position = vertex._position.value();
-			mesh_vertex._normal = vertex._normal.value();
-			mesh_vertex._tangent = vertex._tangent.value();
-			mesh_vertex._uv = vertex._uv.value();
-			md->_vertices.push_back(mesh_vertex);
+		else if (in_material->GetClassId().Is(FbxSurfaceLambert::ClassId)) {
+			auto lambert = static_cast<FbxSurfaceLambert*>(in_material);
+			out_material._diffuse_map_file_name = get_texture_file_name(lambert->Diffuse.GetSrcObject<FbxFileTexture>(), "DIFFUSE");
+			out_material._normal_map_file_name = get_texture_file_name(lambert->NormalMap.GetSrcObject<FbxFileTexture>(), "NORMAL_MAP");
+		}
+		else {
+			add_error_message(build_string("Unknown Material class type : {}", in_material->GetName()));
 		}
 
-		_mesh_def = md;
+		return out_material;
 	}
 
-	void fbx_converter::add_verbose_message(const std::string& message) {
-		if (_is_verbose) {
-			TRACE(message.c_str());
+	std::string fbx_converter::get_texture_file_name(FbxFileTexture* fbx_file_texture, const char* texture_type) {
+		if (fbx_file_texture == nullptr) {
+			add_error_message(build_string("No {} texture found on material.", texture_type));
+			return "";
 		}
+		return fbx_file_texture->GetFileName();
 	}
 
-	void fbx_converter::add_warning_message(const std::string& message) {
-		if (_is_warnings_as_errors_enabled) {
-			ALERT(message.c_str());
-		}
-		else {
-			TRACE("WARNING : {}", message);
+	const vec3* fbx_converter::convert_fbx_values(const FbxVector4* values, int count, const fbx_node_transform& transform, fbx_node_transform::value_kind kind, extraction_scratch& scratch) {
+		static_assert(sizeof(FbxVector4) == 4 * sizeof(double), "FbxVector4 arrays are read as packed doubles");
+		scratch._vec3s.resize(count);
+		if (count > 0) {
+			const double* doubles = reinterpret_cast<const double*>(values);
+			if (!transform.is_identity()) {
+				scratch._transformed.resize(count * 4);
+				transform.transform_values(doubles, count, kind, scratch._transformed.data());
+				doubles = scratch._transformed.data();
+			}
+			fbx_coordinate_converter::convert_vec3s(doubles, count, scratch._vec3s.data());
 		}
+		return scratch._vec3s.data();
 	}
 
-	void fbx_converter::add_error_message(const std::string& message) {
-		ALERT(message.c_str());
-	}
-
-	vec3 fbx_converter::convert_fbx_to_vec3(const FbxVector4& v) {
-		//RH->LH
-		return make_mat33_rotation_on_y(deg(180.f)).transform_vec3(
-			vec3(
-				double_to_float(v[0]), 
-				double_to_float(v[1]), 
-				-double_to_float(v[2])));
-	}
-
-	uv fbx_converter::convert_fbx_to_uv(const FbxVector2& v) {
-		//RH->LH
-		return uv(
-			double_to_float(v[0]), 
-			double_to_float(1.0 - v[1]));
+	const uv* fbx_converter::convert_fbx_values(const FbxVector2* values, int count, const fbx_node_transform& /*transform*/, fbx_node_transform::value_kind /*kind*/, extraction_scratch& scratch) {
+		static_assert(sizeof(FbxVector2) == 2 * sizeof(double), "FbxVector2 arrays are read as packed doubles");
+		scratch._uvs.resize(count);
+		if (count > 0) {
+			fbx_coordinate_converter::convert_uvs(reinterpret_cast<const double*>(values), count, scratch._uvs.data());
+		}
+		return scratch._uvs.data();
 	}
 
 }
\ No newline at end of file
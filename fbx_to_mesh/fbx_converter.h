@@ -1,144 +1,201 @@
 #pragma once
 
 #include "solar/rendering/textures/uv.h"
-#include "solar/rendering/meshes/mesh_def.h"
-#include "solar/utility/optional.h"
 #include <fbxsdk.h>
+#include <algorithm>
 #include <memory>
-#include <unordered_map>
-#include "fbx_converter_mesh_data.h"
-#include "fbx_polygon_vertex_data.h"
+#include "fbx_mesh_pipeline.h"
+#include "fbx_node_transform.h"
 
 namespace solar {
 
-	class fbx_converter {
-	private:
-		bool _is_verbose;
-		bool _is_warnings_as_errors_enabled;
+	//converts one .fbx file at a time. the FbxManager is created once and reused by every conversion, so keep a
+	//converter around when converting many files. a converter must only be used by one thread at a time.
+	//
+	//only the import is done here, everything after it is the fbx_mesh_pipeline.
+	//
+	//every mesh node of the scene is merged into one mesh, with its global transform baked in and its materials
+	//remapped to one table shared by all nodes. each node gets its own range of polygon vertices, triangles and
+	//control points up front, then the nodes' arrays are read into their ranges in parallel. the scene, transforms
+	//and materials are only touched from the calling thread, worker threads only read their own node's mesh.
+	//
+	//with instancing enabled, nodes whose meshes have identical arrays (see fbx_mesh_fingerprint), materials and
+	//mirroring are written once as an fbx_output_instanced_mesh in their local space, with one transform per node,
+	//instead of being merged. each instanced mesh goes through its own pipeline run.
+
+	class fbx_converter : public fbx_mesh_pipeline {
+	public:
+		static const int VERSION = 13; //bump whenever the output for the same input changes, cached conversions are keyed on it.
+		static const int MIN_NODES_PER_THREAD = 1;
 
-		std::shared_ptr<mesh_def> _mesh_def;
-		fbx_converter_mesh_data _mesh_data;
-		std::vector<fbx_polygon_vertex_data> _unduped_vertices;
+	private:
+		class mesh_node {
+		public:
+			FbxNode* _node;
+			FbxMesh* _mesh;
+			fbx_node_transform _transform;
+			std::vector<int> _material_indices; //node material index -> mesh data material index
+			int _triangle_begin; //polygon vertices begin at _triangle_begin * 3, 3 per triangle
+			int _triangle_count;
+			int _control_point_begin;
+			int _control_point_count;
+			bool _is_winding_flipped; //the transform mirrors, see fbx_node_transform::is_mirrored
+			bool _is_instanced;
+		};
+
+		class extraction_scratch {
+		public:
+			std::vector<double> _transformed; //4 per vector like FbxVector4
+			std::vector<vec3> _vec3s;
+			std::vector<uv> _uvs;
+		};
+
+		FbxManager* _manager;
+		fbx_mesh_pipeline _instance_pipeline; //converts the instanced meshes, so they don't disturb the merged mesh
 
 	public:
 		fbx_converter();
-		std::shared_ptr<mesh_def> convert_fbx_to_mesh_def(std::string path);
+		fbx_converter(const fbx_converter_params& params);
+		~fbx_converter();
+		fbx_converter(const fbx_converter&) = delete;
+		fbx_converter& operator=(const fbx_converter&) = delete;
+
+		std::shared_ptr<fbx_output_mesh> convert_fbx_to_output_mesh(std::string path);
 
 	private:
-		void reset_internals();
-		void find_and_process_fbx_mesh(FbxScene* scene);
-		void find_fbx_meshes_recursive(std::vector<FbxMesh*>& mesh_nodes, FbxNode* node);
-		void process_fbx_mesh(FbxMesh* mesh);
-		void build_mesh_data(FbxMesh* mesh);
+		void find_and_process_fbx_meshes(FbxScene* scene);
+		void find_mesh_nodes_recursive(std::vector<mesh_node>& mesh_nodes, FbxNode* node);
+		void prepare_mesh_nodes(std::vector<mesh_node>& mesh_nodes);
+		void add_node_materials(mesh_node& mesh_node, std::vector<FbxSurfaceMaterial*>& fbx_materials);
+		bool is_triangle_mesh(FbxMesh* mesh);
+		void find_instances(std::vector<mesh_node>& mesh_nodes, std::vector<std::vector<int>>& instance_groups);
+		void build_instanced_meshes(const std::vector<mesh_node>& mesh_nodes, const std::vector<std::vector<int>>& instance_groups, std::vector<fbx_output_instanced_mesh>& instanced_meshes);
+		void build_mesh_data(std::vector<mesh_node>& mesh_nodes);
+		void build_node_geometry(const mesh_node& mesh_node, extraction_scratch& scratch);
+		void read_mesh_elements(const std::vector<mesh_node>& mesh_nodes);
+		void read_node_elements(const mesh_node& mesh_node, extraction_scratch& scratch);
 		fbx_converter_mesh_data::material make_mesh_data_material(FbxSurfaceMaterial* in_material);
 		std::string get_texture_file_name(FbxFileTexture* fbx_file_texture, const char* texture_type);
-		void handle_missing_mesh_data();
-		void build_unduped_vertices();
-		void sort_polygons_by_material_index();
-		void build_mesh_def();
-
-		template<typename ElementT>
-		void process_mesh_element_per_polygon_with_index_to_direct(
-			FbxMesh* mesh,
-			const char* element_name,
-			std::function<int(FbxMesh*)> get_element_count,
-			std::function<ElementT*(FbxMesh*, int)> get_element,
-			std::function<void(fbx_converter_mesh_data::polygon* polygon, int index_to_direct)> process_polygon);
-
-		template<typename ElementT, typename ValueT> 
-		void process_mesh_element_per_polygon_vertex(
-			FbxMesh* mesh,
-			const char* element_name,
-			std::function<int(FbxMesh*)> get_element_count,
-			std::function<ElementT*(FbxMesh*, int)> get_element,
-			std::function<void(fbx_converter_mesh_data::polygon_vertex* vertex, ValueT value)> process_vertex);
-
-		void add_verbose_message(const std::string& message);
-		void add_warning_message(const std::string& message);
-		void add_error_message(const std::string& message);
+
+		template<typename ElementT, typename SinkT>
+		void read_polygon_vertex_element(const mesh_node& mesh_node, ElementT* element, const char* element_name, fbx_node_transform::value_kind kind, extraction_scratch& scratch, SinkT& sink);
+
+		template<FbxLayerElement::EMappingMode MappingModeT, FbxLayerElement::EReferenceMode ReferenceModeT, typename ValueT, typename SinkT>
+		void read_polygon_vertex_values(const mesh_node& mesh_node, const ValueT* direct_values, int direct_count, const int* indices, int index_count, const char* element_name, SinkT& sink);
+
+		template<typename ElementT, typename SinkT>
+		void read_polygon_element_indices(const mesh_node& mesh_node, ElementT* element, const char* element_name, SinkT& sink);
 
 	private:
-		static vec3 convert_fbx_to_vec3(const FbxVector4& v);
-		static uv convert_fbx_to_uv(const FbxVector2& v);
+		//node transform then RH->LH for a whole array with fbx_coordinate_converter. uvs aren't transformed. the
+		//result is valid until the next call with the same scratch for the same type.
+		static const vec3* convert_fbx_values(const FbxVector4* values, int count, const fbx_node_transform& transform, fbx_node_transform::value_kind kind, extraction_scratch& scratch);
+		static const uv* convert_fbx_values(const FbxVector2* values, int count, const fbx_node_transform& transform, fbx_node_transform::value_kind kind, extraction_scratch& scratch);
 	};
 
 
-	template<typename ElementT>
-	void fbx_converter::process_mesh_element_per_polygon_with_index_to_direct(
-		FbxMesh* mesh,
-		const char* element_name,
-		std::function<int(FbxMesh*)> get_element_count,
-		std::function<ElementT*(FbxMesh*, int)> get_element,
-		std::function<void(fbx_converter_mesh_data::polygon* polygon, int index_to_direct)> process_polygon) {
-
-		for (int i_element = 0; i_element < get_element_count(mesh); ++i_element) {
-			auto element = get_element(mesh, i_element);
+	template<typename ElementT, typename SinkT>
+	void fbx_converter::read_polygon_vertex_element(const mesh_node& mesh_node, ElementT* element, const char* element_name, fbx_node_transform::value_kind kind, extraction_scratch& scratch, SinkT& sink) {
+		//the mapping and reference modes are checked once here, the loops over the values are specialized on them so
+		//they run on locked raw arrays without per value dispatch. the direct array is converted in one batch first,
+		//which also converts values shared through the index array or control points only once.
+		auto mapping_mode = element->GetMappingMode();
+		auto reference_mode = element->GetReferenceMode();
+
+		auto& direct_array = element->GetDirectArray();
+		auto& index_array = element->GetIndexArray();
+		int direct_count = direct_array.GetCount();
+		int index_count = (reference_mode == FbxLayerElement::eIndexToDirect) ? index_array.GetCount() : 0;
+		auto locked_direct_values = direct_array.GetLocked(FbxLayerElementArray::eReadLock);
+		auto direct_values = convert_fbx_values(locked_direct_values, direct_count, mesh_node._transform, kind, scratch);
+		direct_array.Release(&locked_direct_values);
+		int* indices = (index_count > 0) ? index_array.GetLocked(FbxLayerElementArray::eReadLock) : nullptr;
+
+		if (mapping_mode == FbxLayerElement::eByControlPoint && reference_mode == FbxLayerElement::eDirect) {
+			read_polygon_vertex_values<FbxLayerElement::eByControlPoint, FbxLayerElement::eDirect>(mesh_node, direct_values, direct_count, indices, index_count, element_name, sink);
+		}
+		else if (mapping_mode == FbxLayerElement::eByPolygonVertex && reference_mode == FbxLayerElement::eDirect) {
+			read_polygon_vertex_values<FbxLayerElement::eByPolygonVertex, FbxLayerElement::eDirect>(mesh_node, direct_values, direct_count, indices, index_count, element_name, sink);
+		}
+		else if (mapping_mode == FbxLayerElement::eByPolygonVertex && reference_mode == FbxLayerElement::eIndexToDirect) {
+			read_polygon_vertex_values<FbxLayerElement::eByPolygonVertex, FbxLayerElement::eIndexToDirect>(mesh_node, direct_values, direct_count, indices, index_count, element_name, sink);
+		}
+		else {
+			add_error_message(build_string("Unhandled reference_mode and mapping_mode combination in {} : {} - {}", element_name, fbx_reference_mode_to_string(reference_mode), fbx_mapping_mode_to_string(mapping_mode)));
+		}
 
-			auto mapping_mode = element->GetMappingMode();
-			auto reference_mode = element->GetReferenceMode();
+		if (indices != nullptr) {
+			index_array.Release(&indices);
+		}
+	}
 
-			if (mapping_mode == FbxLayerElement::eByPolygon && reference_mode == FbxLayerElement::eIndexToDirect) {
-				for (int i_polygon = 0; i_polygon < element->GetIndexArray().GetCount(); ++i_polygon) {
-					int direct_index = element->GetIndexArray().GetAt(i_polygon);
-					process_polygon(_mesh_data._polygons.at(i_polygon).get(), direct_index);
+	template<FbxLayerElement::EMappingMode MappingModeT, FbxLayerElement::EReferenceMode ReferenceModeT, typename ValueT, typename SinkT>
+	void fbx_converter::read_polygon_vertex_values(const mesh_node& mesh_node, const ValueT* direct_values, int direct_count, const int* indices, int index_count, const char* element_name, SinkT& sink) {
+		//indices into the element are the node's own, the sink gets mesh data polygon vertex indices.
+		int polygon_vertex_begin = mesh_node._triangle_begin * 3;
+		int polygon_vertex_count = mesh_node._triangle_count * 3;
+
+		if (MappingModeT == FbxLayerElement::eByControlPoint) {
+			int count = std::min(direct_count, mesh_node._control_point_count);
+			for (int i_control_point = 0; i_control_point < count; ++i_control_point) {
+				int begin = _mesh_data._control_point_vertex_offsets[mesh_node._control_point_begin + i_control_point];
+				int end = _mesh_data._control_point_vertex_offsets[mesh_node._control_point_begin + i_control_point + 1];
+				for (int i_cp_vertex = begin; i_cp_vertex < end; ++i_cp_vertex) {
+					sink(_mesh_data._control_point_vertices[i_cp_vertex], direct_values[i_control_point]);
 				}
 			}
-			else if (mapping_mode == FbxLayerElement::eAllSame && reference_mode == FbxLayerElement::eIndexToDirect) {
-				if (element->GetIndexArray().GetCount() != 1) {
-					add_error_message(build_string("eAllSame IndexArrayCount expected to be one in {}", element_name));
-				}
-				else {
-					int direct_index = element->GetIndexArray().GetAt(0);
-					for (auto polygon : _mesh_data._polygons) {
-						process_polygon(polygon.get(), direct_index);
-					}
-				}
+		}
+		else if (ReferenceModeT == FbxLayerElement::eDirect) {
+			//straight copy, the sink only converts.
+			int count = std::min(direct_count, polygon_vertex_count);
+			for (int i_polygon_vertex = 0; i_polygon_vertex < count; ++i_polygon_vertex) {
+				sink(polygon_vertex_begin + i_polygon_vertex, direct_values[i_polygon_vertex]);
 			}
-			else {
-				add_error_message(build_string("Unhandled reference_mode and mapping_mode combination in {} : {} - {}", element_name, fbx_reference_mode_to_string(reference_mode), fbx_mapping_mode_to_string(mapping_mode)));
+		}
+		else {
+			int count = std::min(index_count, polygon_vertex_count);
+			for (int i_polygon_vertex = 0; i_polygon_vertex < count; ++i_polygon_vertex) {
+				int direct_index = indices[i_polygon_vertex];
+				if (direct_index < 0 || direct_index >= direct_count) {
+					add_error_message(build_string("Invalid index in {} : {}", element_name, direct_index));
+					break;
+				}
+				sink(polygon_vertex_begin + i_polygon_vertex, direct_values[direct_index]);
 			}
 		}
 	}
 
-	template<typename ElementT, typename ValueT>
-	void fbx_converter::process_mesh_element_per_polygon_vertex(
-		FbxMesh* mesh,
-		const char* element_name,
-		std::function<int(FbxMesh*)> get_element_count,
-		std::function<ElementT*(FbxMesh*, int)> get_element,
-		std::function<void(fbx_converter_mesh_data::polygon_vertex* vertex, ValueT value)> process_vertex) {
-
-		for (int i_element = 0; i_element < get_element_count(mesh); ++i_element) {
-			auto element = get_element(mesh, i_element);
-
-			auto mapping_mode = element->GetMappingMode();
-			auto reference_mode = element->GetReferenceMode();
-
-			if (mapping_mode == FbxLayerElement::eByControlPoint && reference_mode == FbxLayerElement::eDirect) {
-				for (int i_control_point = 0; i_control_point < element->GetDirectArray().GetCount(); ++i_control_point) {
-					auto cp = _mesh_data._control_points.at(i_control_point);
-					for (auto pv : cp->_vertices) {
-						process_vertex(pv.get(), element->GetDirectArray().GetAt(i_control_point));
-					}
-				}
+	template<typename ElementT, typename SinkT>
+	void fbx_converter::read_polygon_element_indices(const mesh_node& mesh_node, ElementT* element, const char* element_name, SinkT& sink) {
+		//the sink gets mesh data triangle indices and the node's own direct indices.
+		auto mapping_mode = element->GetMappingMode();
+		auto reference_mode = element->GetReferenceMode();
+
+		auto& index_array = element->GetIndexArray();
+		int index_count = index_array.GetCount();
+		int triangle_count = mesh_node._triangle_count;
+
+		if (mapping_mode == FbxLayerElement::eByPolygon && reference_mode == FbxLayerElement::eIndexToDirect) {
+			int* indices = index_array.GetLocked(FbxLayerElementArray::eReadLock);
+			int count = std::min(index_count, triangle_count);
+			for (int i_triangle = 0; i_triangle < count; ++i_triangle) {
+				sink(mesh_node._triangle_begin + i_triangle, indices[i_triangle]);
 			}
-			else if (mapping_mode == FbxLayerElement::eByPolygonVertex && reference_mode == FbxLayerElement::eDirect) {
-				for (int i_polygon_vertex = 0; i_polygon_vertex < element->GetDirectArray().GetCount(); ++i_polygon_vertex) {
-					auto pv = _mesh_data._polygon_vertices.at(i_polygon_vertex);
-					process_vertex(pv.get(), element->GetDirectArray().GetAt(i_polygon_vertex));
-				}
-			}
-			else if (mapping_mode == FbxLayerElement::eByPolygonVertex && reference_mode == FbxLayerElement::eIndexToDirect) {
-				for (int i_polygon_vertex = 0; i_polygon_vertex < element->GetIndexArray().GetCount(); ++i_polygon_vertex) {
-					int direct_index = element->GetIndexArray().GetAt(i_polygon_vertex);
-					auto pv = _mesh_data._polygon_vertices.at(i_polygon_vertex);
-					process_vertex(pv.get(), element->GetDirectArray().GetAt(direct_index));
-				}
+			index_array.Release(&indices);
+		}
+		else if (mapping_mode == FbxLayerElement::eAllSame && reference_mode == FbxLayerElement::eIndexToDirect) {
+			if (index_count != 1) {
+				add_error_message(build_string("eAllSame IndexArrayCount expected to be one in {}", element_name));
 			}
 			else {
-				add_error_message(build_string("Unhandled reference_mode and mapping_mode combination in {} : {} - {}", element_name, fbx_reference_mode_to_string(reference_mode), fbx_mapping_mode_to_string(mapping_mode)));
+				int direct_index = index_array.GetAt(0);
+				for (int i_triangle = 0; i_triangle < triangle_count; ++i_triangle) {
+					sink(mesh_node._triangle_begin + i_triangle, direct_index);
+				}
 			}
-
+		}
+		else {
+			add_error_message(build_string("Unhandled reference_mode and mapping_mode combination in {} : {} - {}", element_name, fbx_reference_mode_to_string(reference_mode), fbx_mapping_mode_to_string(mapping_mode)));
 		}
 	}
 
@@ -2,30 +2,33 @@
 
 #include <array>
 #include <vector>
-#include <memory>
 #include "fbx_polygon_vertex_data.h"
-#include "solar/utility/optional.h"
 #include "solar/strings/string_build.h"
 
 namespace solar {
 
+	//flat structure-of-arrays representation of the imported mesh.
+	//
+	//polygon vertices : every per polygon vertex array is indexed by the same polygon vertex index.
+	//triangles : every per triangle array is indexed by the same triangle index. each triangle references 3 polygon vertices.
+	//control points : the polygon vertices sharing control point i are
+	//  _control_point_vertices[_control_point_vertex_offsets[i] ... _control_point_vertex_offsets[i + 1]]
+
 	class fbx_converter_mesh_data {
 	public:
-		class polygon_vertex {
-		public:
-			fbx_polygon_vertex_data _data;
-			optional<int> _unduped_vertex_index; //index into unduped_vertices
+		enum attribute_flags : unsigned char {
+			HAS_NORMAL = 1 << 0,
+			HAS_TANGENT = 1 << 1,
+			HAS_UV = 1 << 2
 		};
 
-		class polygon {
-		public:
-			std::array<std::shared_ptr<polygon_vertex>, 3> _vertices;
-			optional<unsigned int> _material_index;
-		};
+		static const int NO_MATERIAL_INDEX = -1;
 
-		class control_point {
+		class triangle_range {
 		public:
-			std::vector<std::shared_ptr<polygon_vertex>> _vertices;
+			int _material_index;
+			int _begin;
+			int _end;
 		};
 
 		class material {
@@ -41,9 +44,157 @@ namespace solar {
 
 	public:
 		std::vector<material> _materials;
-		std::vector<std::shared_ptr<polygon_vertex>> _polygon_vertices;
-		std::vector<std::shared_ptr<polygon>> _polygons;
-		std::vector<std::shared_ptr<control_point>> _control_points;
+
+		//per polygon vertex
+		std::vector<vec3> _positions;
+		std::vector<vec3> _normals;
+		std::vector<vec3> _tangents;
+		std::vector<float> _tangent_signs; //see fbx_polygon_vertex_data::_tangent_sign
+		std::vector<uv> _uvs;
+		std::vector<unsigned char> _attribute_flags;
+		std::vector<int> _control_point_indices;
+		std::vector<int> _unduped_vertex_indices; //index into unduped_vertices, -1 once welding removed its triangle
+
+		//per triangle
+		std::vector<std::array<int, 3>> _triangles; //polygon vertex indices
+		std::vector<int> _material_indices;
+
+		//per control point
+		std::vector<int> _control_point_vertex_offsets;
+		std::vector<int> _control_point_vertices;
+
+	public:
+		int get_polygon_vertex_count() const {
+			return static_cast<int>(_positions.size());
+		}
+
+		int get_triangle_count() const {
+			return static_cast<int>(_triangles.size());
+		}
+
+		int get_control_point_count() const {
+			return _control_point_vertex_offsets.empty() ? 0 : static_cast<int>(_control_point_vertex_offsets.size()) - 1;
+		}
+
+		void clear() {
+			//keeps the capacity, for converting several meshes in a row.
+			_materials.clear();
+			_positions.clear();
+			_normals.clear();
+			_tangents.clear();
+			_tangent_signs.clear();
+			_uvs.clear();
+			_attribute_flags.clear();
+			_control_point_indices.clear();
+			_unduped_vertex_indices.clear();
+			_triangles.clear();
+			_material_indices.clear();
+			_control_point_vertex_offsets.clear();
+			_control_point_vertices.clear();
+		}
+
+		void reserve(int triangle_count, int polygon_vertex_count) {
+			_positions.reserve(polygon_vertex_count);
+			_normals.reserve(polygon_vertex_count);
+			_tangents.reserve(polygon_vertex_count);
+			_tangent_signs.reserve(polygon_vertex_count);
+			_uvs.reserve(polygon_vertex_count);
+			_attribute_flags.reserve(polygon_vertex_count);
+			_control_point_indices.reserve(polygon_vertex_count);
+			_triangles.reserve(triangle_count);
+			_material_indices.reserve(triangle_count);
+		}
+
+		void resize(int triangle_count, int polygon_vertex_count) {
+			//new polygon vertices and triangles get the same defaults as from add_polygon_vertex and add_triangle, so
+			//ranges of them can be filled from several threads.
+			_positions.resize(polygon_vertex_count);
+			_normals.resize(polygon_vertex_count);
+			_tangents.resize(polygon_vertex_count);
+			_tangent_signs.resize(polygon_vertex_count, 1.f);
+			_uvs.resize(polygon_vertex_count);
+			_attribute_flags.resize(polygon_vertex_count, 0);
+			_control_point_indices.resize(polygon_vertex_count, 0);
+			_triangles.resize(triangle_count);
+			_material_indices.resize(triangle_count, int(NO_MATERIAL_INDEX));
+		}
+
+		int add_polygon_vertex(const vec3& position, int control_point_index) {
+			_positions.push_back(position);
+			_normals.push_back(vec3());
+			_tangents.push_back(vec3());
+			_tangent_signs.push_back(1.f);
+			_uvs.push_back(uv());
+			_attribute_flags.push_back(0);
+			_control_point_indices.push_back(control_point_index);
+			return get_polygon_vertex_count() - 1;
+		}
+
+		void add_triangle(const std::array<int, 3>& polygon_vertices) {
+			_triangles.push_back(polygon_vertices);
+			_material_indices.push_back(int(NO_MATERIAL_INDEX)); //a copy, push_back would odr-use it and gcc wants a definition
+		}
+
+		bool has_attribute(int polygon_vertex_index, attribute_flags flag) const {
+			return (_attribute_flags.at(polygon_vertex_index) & flag) != 0;
+		}
+
+		void set_attribute_flag(int polygon_vertex_index, attribute_flags flag) {
+			_attribute_flags.at(polygon_vertex_index) |= flag;
+		}
+
+		fbx_polygon_vertex_data get_polygon_vertex_data(int polygon_vertex_index) const {
+			fbx_polygon_vertex_data data;
+			data._position = _positions[polygon_vertex_index];
+			data._normal = _normals[polygon_vertex_index];
+			data._tangent = _tangents[polygon_vertex_index];
+			data._tangent_sign = _tangent_signs[polygon_vertex_index];
+			data._uv = _uvs[polygon_vertex_index];
+			return data;
+		}
+
+		void get_unduped_indices(std::vector<unsigned int>& indices) const {
+			//3 per triangle, in triangle order, indexing unduped_vertices.
+			indices.resize(_triangles.size() * 3);
+			for (size_t i_triangle = 0; i_triangle < _triangles.size(); ++i_triangle) {
+				for (int k = 0; k < 3; ++k) {
+					indices[i_triangle * 3 + k] = static_cast<unsigned int>(_unduped_vertex_indices[_triangles[i_triangle][k]]);
+				}
+			}
+		}
+
+		std::vector<triangle_range> get_material_triangle_ranges() const {
+			//runs of triangles sharing a material. only one range per material once triangles are sorted by material.
+			std::vector<triangle_range> ranges;
+			for (int i_triangle = 0; i_triangle < get_triangle_count(); ++i_triangle) {
+				if (ranges.empty() || ranges.back()._material_index != _material_indices[i_triangle]) {
+					triangle_range range;
+					range._material_index = _material_indices[i_triangle];
+					range._begin = i_triangle;
+					range._end = i_triangle;
+					ranges.push_back(range);
+				}
+				ranges.back()._end++;
+			}
+			return ranges;
+		}
+
+		void build_control_point_vertices(int control_point_count) {
+			//counting pass then prefix sum, so the adjacency is two flat arrays instead of a vector per control point.
+			_control_point_vertex_offsets.assign(control_point_count + 1, 0);
+			for (int control_point_index : _control_point_indices) {
+				_control_point_vertex_offsets[control_point_index + 1]++;
+			}
+			for (int i = 0; i < control_point_count; ++i) {
+				_control_point_vertex_offsets[i + 1] += _control_point_vertex_offsets[i];
+			}
+
+			std::vector<int> cursors(_control_point_vertex_offsets.begin(), _control_point_vertex_offsets.end() - 1);
+			_control_point_vertices.resize(_control_point_indices.size());
+			for (int i_pv = 0; i_pv < get_polygon_vertex_count(); ++i_pv) {
+				_control_point_vertices[cursors[_control_point_indices[i_pv]]++] = i_pv;
+			}
+		}
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "solar/strings/string_build.h"
+#include "fbx_parallel_for.h"
+
+namespace solar {
+
+	class fbx_converter_params {
+	public:
+		bool _is_verbose;
+		bool _is_warnings_as_errors_enabled;
+		unsigned int _thread_count; //threads used inside a single conversion (dedup, etc.)
+		bool _is_overdraw_optimization_enabled;
+		float _overdraw_cache_threshold; //max ACMR of the overdraw order relative to the vertex cache order, 1.05 allows 5% worse.
+		bool _is_32_bit_index_enabled; //otherwise 16 bit, meshes with too many vertices are split into submeshes
+		bool _is_vertex_packing_enabled; //quantized 16 byte vertices, see fbx_packed_vertex
+		int _lod_count; //simplified LODs generated after the full detail mesh, the chain stops early once simplification stalls
+		float _lod_triangle_ratio; //triangle count of each LOD relative to the previous one
+		float _lod_max_error; //max simplification error relative to the mesh's bounding sphere radius
+		bool _is_meshlet_generation_enabled; //clusters with culling bounds, see fbx_meshlet_builder
+		bool _is_bvh_enabled; //triangle BVH for raycasts, see fbx_bvh
+		int _raycast_benchmark_ray_count; //compares BVH and brute force raycasts on each converted mesh when > 0, output is unchanged
+		bool _is_instancing_enabled; //mesh nodes with identical geometry are written once with their transforms, see fbx_output_instanced_mesh
+		bool _is_position_stream_enabled; //positions deduped on their own with their own indices, for depth and shadow passes
+		bool _is_vertex_welding_enabled; //merges vertices within the weld tolerances after exact dedup, see fbx_vertex_welder
+		float _weld_position_tolerance; //max distance in output units
+		float _weld_normal_degrees;
+		float _weld_tangent_degrees;
+		float _weld_uv_tolerance;
+
+	public:
+		fbx_converter_params()
+			: _is_verbose(true)
+			, _is_warnings_as_errors_enabled(false)
+			, _thread_count(get_default_fbx_thread_count())
+			, _is_overdraw_optimization_enabled(false)
+			, _overdraw_cache_threshold(1.05f)
+			, _is_32_bit_index_enabled(false)
+			, _is_vertex_packing_enabled(false)
+			, _lod_count(0)
+			, _lod_triangle_ratio(0.5f)
+			, _lod_max_error(0.05f)
+			, _is_meshlet_generation_enabled(false)
+			, _is_bvh_enabled(false)
+			, _raycast_benchmark_ray_count(0)
+			, _is_instancing_enabled(false)
+			, _is_position_stream_enabled(false)
+			, _is_vertex_welding_enabled(false)
+			, _weld_position_tolerance(1e-4f)
+			, _weld_normal_degrees(1.f)
+			, _weld_tangent_degrees(2.f)
+			, _weld_uv_tolerance(1e-4f) {
+		}
+
+		fbx_converter_params& set_is_verbose(bool is_verbose) {
+			_is_verbose = is_verbose;
+			return *this;
+		}
+
+		fbx_converter_params& set_is_warnings_as_errors_enabled(bool is_enabled) {
+			_is_warnings_as_errors_enabled = is_enabled;
+			return *this;
+		}
+
+		fbx_converter_params& set_thread_count(unsigned int thread_count) {
+			_thread_count = thread_count;
+			return *this;
+		}
+
+		fbx_converter_params& set_is_overdraw_optimization_enabled(bool is_enabled) {
+			_is_overdraw_optimization_enabled = is_enabled;
+			return *this;
+		}
+
+		fbx_converter_params& set_overdraw_cache_threshold(float threshold) {
+			_overdraw_cache_threshold = threshold;
+			return *this;
+		}
+
+		fbx_converter_params& set_is_32_bit_index_enabled(bool is_enabled) {
+			_is_32_bit_index_enabled = is_enabled;
+			return *this;
+		}
+
+		fbx_converter_params& set_is_vertex_packing_enabled(bool is_enabled) {
+			_is_vertex_packing_enabled = is_enabled;
+			return *this;
+		}
+
+		fbx_converter_params& set_lod_count(int lod_count) {
+			_lod_count = lod_count;
+			return *this;
+		}
+
+		fbx_converter_params& set_lod_triangle_ratio(float ratio) {
+			_lod_triangle_ratio = ratio;
+			return *this;
+		}
+
+		fbx_converter_params& set_lod_max_error(float max_error) {
+			_lod_max_error = max_error;
+			return *this;
+		}
+
+		fbx_converter_params& set_is_meshlet_generation_enabled(bool is_enabled) {
+			_is_meshlet_generation_enabled = is_enabled;
+			return *this;
+		}
+
+		fbx_converter_params& set_is_bvh_enabled(bool is_enabled) {
+			_is_bvh_enabled = is_enabled;
+			return *this;
+		}
+
+		fbx_converter_params& set_raycast_benchmark_ray_count(int ray_count) {
+			_raycast_benchmark_ray_count = ray_count;
+			return *this;
+		}
+
+		fbx_converter_params& set_is_instancing_enabled(bool is_enabled) {
+			_is_instancing_enabled = is_enabled;
+			return *this;
+		}
+
+		fbx_converter_params& set_is_position_stream_enabled(bool is_enabled) {
+			_is_position_stream_enabled = is_enabled;
+			return *this;
+		}
+
+		fbx_converter_params& set_is_vertex_welding_enabled(bool is_enabled) {
+			_is_vertex_welding_enabled = is_enabled;
+			return *this;
+		}
+
+		fbx_converter_params& set_weld_tolerances(float position, float normal_degrees, float tangent_degrees, float uv) {
+			_weld_position_tolerance = position;
+			_weld_normal_degrees = normal_degrees;
+			_weld_tangent_degrees = tangent_degrees;
+			_weld_uv_tolerance = uv;
+			return *this;
+		}
+
+		//converter options that change the output, the conversion cache key. verbose, warnings_as_errors and
+		//raycast_benchmark only change what is reported, so batch and watch runs share entries.
+		std::string to_string() const {
+			return build_string("{{ overdraw:{} , overdraw_cache_threshold:{} , index_32_bit:{} , packed_vertices:{} , lods:{} , lod_ratio:{} , lod_max_error:{} , meshlets:{} , bvh:{} , instancing:{} , position_stream:{} , weld:{} , weld_tolerances:{} {} {} {} }}",
+				_is_overdraw_optimization_enabled, _overdraw_cache_threshold, _is_32_bit_index_enabled,
+				_is_vertex_packing_enabled, _lod_count, _lod_triangle_ratio, _lod_max_error,
+				_is_meshlet_generation_enabled, _is_bvh_enabled, _is_instancing_enabled, _is_position_stream_enabled,
+				_is_vertex_welding_enabled, _weld_position_tolerance, _weld_normal_degrees, _weld_tangent_degrees, _weld_uv_tolerance);
+		}
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "fbx_coordinate_converter.h"
+
+#include <cstring>
+#include <limits>
+#include "solar/math/mat33.h"
+#include "solar/utility/type_convert.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define FBX_COORDINATE_CONVERTER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace solar {
+
+	namespace {
+
+		//namespace scope so they are set before main, function statics aren't thread safe with every compiler we use.
+		const mat33 s_rh_to_lh_rotation = make_mat33_rotation_on_y(deg(180.f));
+		bool s_is_simd_enabled = false; //see simd_check at the end
+
+		bool is_bit_identical(const void* a, const void* b, size_t size) {
+			return std::memcmp(a, b, size) == 0; //not ==, -0 and 0 must differ and nans must match
+		}
+
+		//with two nan operands an add or multiply returns the first one, and the compiler is free to swap operands,
+		//so which nan comes out of the matrix transform depends on how it was compiled. every nan becomes the same
+		//one so each conversion path gives the same bits.
+		float to_canonical_nan(float value) {
+			return (value != value) ? std::numeric_limits<float>::quiet_NaN() : value;
+		}
+
+#ifdef FBX_COORDINATE_CONVERTER_SSE2
+		__m128 to_canonical_nan(__m128 values) {
+			__m128 is_nan = _mm_cmpunord_ps(values, values);
+			return _mm_or_ps(_mm_andnot_ps(is_nan, values), _mm_and_ps(is_nan, _mm_set1_ps(std::numeric_limits<float>::quiet_NaN())));
+		}
+#endif
+
+	}
+
+	void fbx_coordinate_converter::convert_vec3s(const double* values, int count, vec3* out) {
+		if (s_is_simd_enabled) {
+			convert_vec3s_simd(values, count, out);
+		}
+		else {
+			convert_vec3s_scalar(values, count, out);
+		}
+	}
+
+	void fbx_coordinate_converter::convert_uvs(const double* values, int count, uv* out) {
+		if (s_is_simd_enabled) {
+			convert_uvs_simd(values, count, out);
+		}
+		else {
+			convert_uvs_scalar(values, count, out);
+		}
+	}
+
+	vec3 fbx_coordinate_converter::convert_vec3(const double* value) {
+		//RH->LH
+		vec3 result = s_rh_to_lh_rotation.transform_vec3(
+			vec3(
+				double_to_float(value[0]),
+				double_to_float(value[1]),
+				-double_to_float(value[2])));
+		return vec3(to_canonical_nan(result._x), to_canonical_nan(result._y), to_canonical_nan(result._z));
+	}
+
+	uv fbx_coordinate_converter::convert_uv(const double* value) {
+		//RH->LH
+		return uv(
+			double_to_float(value[0]),
+			double_to_float(1.0 - value[1]));
+	}
+
+	bool fbx_coordinate_converter::is_simd_enabled() {
+		return s_is_simd_enabled;
+	}
+
+	void fbx_coordinate_converter::convert_vec3s_scalar(const double* values, int count, vec3* out) {
+		for (int i = 0; i < count; ++i) {
+			out[i] = convert_vec3(&values[i * 4]);
+		}
+	}
+
+	void fbx_coordinate_converter::convert_uvs_scalar(const double* values, int count, uv* out) {
+		for (int i = 0; i < count; ++i) {
+			out[i] = convert_uv(&values[i * 2]);
+		}
+	}
+
+#ifdef FBX_COORDINATE_CONVERTER_SSE2
+
+	void fbx_coordinate_converter::convert_vec3s_simd(const double* values, int count, vec3* out) {
+		static_assert(sizeof(vec3) == 3 * sizeof(float), "4 vec3s are stored as 3 packed float4s");
+
+		//4 vectors per iteration, transposed so each lane is one vector : x' = x * m00 + y * m10 + z * m20, etc. the
+		//same multiplies and adds in the same order as mat33::transform_vec3.
+		const mat33& m = s_rh_to_lh_rotation;
+		const __m128 sign = _mm_set1_ps(-0.f);
+
+		int simd_count = count & ~3;
+		for (int i = 0; i < simd_count; i += 4) {
+			const double* value = &values[i * 4];
+			__m128 v0 = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(value + 0)), _mm_cvtpd_ps(_mm_loadu_pd(value + 2)));
+			__m128 v1 = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(value + 4)), _mm_cvtpd_ps(_mm_loadu_pd(value + 6)));
+			__m128 v2 = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(value + 8)), _mm_cvtpd_ps(_mm_loadu_pd(value + 10)));
+			__m128 v3 = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(value + 12)), _mm_cvtpd_ps(_mm_loadu_pd(value + 14)));
+			_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+			__m128 x = v0;
+			__m128 y = v1;
+			__m128 z = _mm_xor_ps(v2, sign);
+
+			__m128 out_x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m._m[0][0])), _mm_mul_ps(y, _mm_set1_ps(m._m[1][0]))), _mm_mul_ps(z, _mm_set1_ps(m._m[2][0])));
+			__m128 out_y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m._m[0][1])), _mm_mul_ps(y, _mm_set1_ps(m._m[1][1]))), _mm_mul_ps(z, _mm_set1_ps(m._m[2][1])));
+			__m128 out_z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m._m[0][2])), _mm_mul_ps(y, _mm_set1_ps(m._m[1][2]))), _mm_mul_ps(z, _mm_set1_ps(m._m[2][2])));
+			out_x = to_canonical_nan(out_x);
+			out_y = to_canonical_nan(out_y);
+			out_z = to_canonical_nan(out_z);
+
+			//back to x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+			__m128 xy_low = _mm_unpacklo_ps(out_x, out_y);
+			__m128 xy_high = _mm_unpackhi_ps(out_x, out_y);
+			__m128 z0_x1 = _mm_shuffle_ps(out_z, xy_low, _MM_SHUFFLE(2, 2, 0, 0));
+			__m128 y1_z1 = _mm_shuffle_ps(xy_low, out_z, _MM_SHUFFLE(1, 1, 3, 3));
+			__m128 z2_x3 = _mm_shuffle_ps(out_z, xy_high, _MM_SHUFFLE(2, 2, 2, 2));
+			__m128 y3_z3 = _mm_shuffle_ps(xy_high, out_z, _MM_SHUFFLE(3, 3, 3, 3));
+
+			float* out_floats = reinterpret_cast<float*>(&out[i]);
+			_mm_storeu_ps(out_floats + 0, _mm_shuffle_ps(xy_low, z0_x1, _MM_SHUFFLE(2, 0, 1, 0)));
+			_mm_storeu_ps(out_floats + 4, _mm_shuffle_ps(y1_z1, xy_high, _MM_SHUFFLE(1, 0, 2, 0)));
+			_mm_storeu_ps(out_floats + 8, _mm_shuffle_ps(z2_x3, y3_z3, _MM_SHUFFLE(2, 0, 2, 0)));
+		}
+		convert_vec3s_scalar(values + simd_count * 4, count - simd_count, out + simd_count);
+	}
+
+	void fbx_coordinate_converter::convert_uvs_simd(const double* values, int count, uv* out) {
+		static_assert(sizeof(uv) == 2 * sizeof(float), "2 uvs are stored as one float4");
+
+		//u is kept as is rather than added to 0, which would turn -0 into 0.
+		const __m128d one = _mm_set1_pd(1.0);
+		int simd_count = count & ~1;
+		for (int i = 0; i < simd_count; i += 2) {
+			__m128d value0 = _mm_loadu_pd(&values[i * 2]);
+			__m128d value1 = _mm_loadu_pd(&values[i * 2 + 2]);
+			__m128 uv0 = _mm_cvtpd_ps(_mm_move_sd(_mm_sub_pd(one, value0), value0));
+			__m128 uv1 = _mm_cvtpd_ps(_mm_move_sd(_mm_sub_pd(one, value1), value1));
+			_mm_storeu_ps(reinterpret_cast<float*>(&out[i]), _mm_movelh_ps(uv0, uv1));
+		}
+		convert_uvs_scalar(values + simd_count * 2, count - simd_count, out + simd_count);
+	}
+
+#else
+
+	void fbx_coordinate_converter::convert_vec3s_simd(const double* values, int count, vec3* out) {
+		convert_vec3s_scalar(values, count, out);
+	}
+
+	void fbx_coordinate_converter::convert_uvs_simd(const double* values, int count, uv* out) {
+		convert_uvs_scalar(values, count, out);
+	}
+
+#endif
+
+	bool fbx_coordinate_converter::is_simd_bit_identical() {
+#ifdef FBX_COORDINATE_CONVERTER_SSE2
+		//signs, zeros, rounding boundaries, denormals, large and tiny values in every lane.
+		const double probes[] = {
+			0.0, -0.0, 1.0, -1.0, 0.5, -0.5, 0.1, -0.1, 1.0 / 3.0, -2.0 / 3.0, 123.456, -98765.4321,
+			1e-3, -1e-7, 1e-40, -1e-45, 3.4e38, -3.4e38, 16777217.0, 0.1 + 1e-17, 1.0 - 1e-9, 2.5e6, -7.25, 1e10
+		};
+		const int probe_count = static_cast<int>(sizeof(probes) / sizeof(probes[0]));
+		const int vector_count = probe_count * 3;
+
+		double vec4_values[vector_count * 4];
+		double uv_values[vector_count * 2];
+		for (int i = 0; i < vector_count; ++i) {
+			for (int k = 0; k < 4; ++k) {
+				vec4_values[i * 4 + k] = probes[(i + k * 7) % probe_count];
+			}
+			for (int k = 0; k < 2; ++k) {
+				uv_values[i * 2 + k] = probes[(i + k * 5) % probe_count];
+			}
+		}
+
+		vec3 scalar_vec3s[vector_count];
+		vec3 simd_vec3s[vector_count];
+		uv scalar_uvs[vector_count];
+		uv simd_uvs[vector_count];
+		convert_vec3s_scalar(vec4_values, vector_count, scalar_vec3s);
+		convert_vec3s_simd(vec4_values, vector_count, simd_vec3s);
+		convert_uvs_scalar(uv_values, vector_count, scalar_uvs);
+		convert_uvs_simd(uv_values, vector_count, simd_uvs);
+
+		for (int i = 0; i < vector_count; ++i) {
+			if (!is_bit_identical(&scalar_vec3s[i], &simd_vec3s[i], sizeof(vec3)) ||
+				!is_bit_identical(&scalar_uvs[i], &simd_uvs[i], sizeof(uv))) {
+				return false;
+			}
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	namespace {
+
+		//defined after s_rh_to_lh_rotation, so it is built first.
+		class simd_check {
+		public:
+			simd_check() {
+				s_is_simd_enabled = fbx_coordinate_converter::is_simd_bit_identical();
+			}
+		};
+
+		simd_check s_simd_check;
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "solar/math/vec3.h"
+#include "solar/rendering/textures/uv.h"
+
+namespace solar {
+
+	//.fbx right handed coordinates to the engine's left handed ones, for whole arrays at once.
+	//
+	//vectors are flipped on z then rotated 180 degrees on y, uvs are flipped on v. the rotation matrix is built once
+	//instead of per vector and the arrays are converted with SSE2 where available (x64 and x86 /arch:SSE2), with a
+	//scalar fallback. the SSE2 path is checked against the scalar one at startup and only used when every result is
+	//bit identical, so it can never change the output. every nan result is the same quiet nan, whatever the inputs,
+	//see tests/fbx_coordinate_converter_test.cpp.
+	//
+	//inputs are the raw doubles of FbxVector4 (4 per vector, w is ignored) and FbxVector2 (2 per uv), so this has no
+	//FBX SDK dependency.
+
+	class fbx_coordinate_converter {
+	public:
+		static void convert_vec3s(const double* values, int count, vec3* out);
+		static void convert_uvs(const double* values, int count, uv* out);
+
+		//one at a time, the reference the batch conversions must match.
+		static vec3 convert_vec3(const double* value);
+		static uv convert_uv(const double* value);
+
+		static bool is_simd_enabled();
+		static bool is_simd_bit_identical(); //the startup check, always false without SSE2
+
+	private:
+		static void convert_vec3s_scalar(const double* values, int count, vec3* out);
+		static void convert_uvs_scalar(const double* values, int count, uv* out);
+		static void convert_vec3s_simd(const double* values, int count, vec3* out);
+		static void convert_uvs_simd(const double* values, int count, uv* out);
+	};
+
+}
\ No newline at end of file
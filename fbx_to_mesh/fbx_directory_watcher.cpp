@@ -0,0 +1,298 @@
+#include "fbx_directory_watcher.h"
+
+#include <algorithm>
+#include <cctype>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace solar {
+
+#ifdef _WIN32
+
+	class fbx_directory_watcher::directory {
+	public:
+		std::string _path;
+		HANDLE _handle;
+		HANDLE _event;
+		OVERLAPPED _overlapped;
+		std::vector<DWORD> _buffer; //DWORD aligned, as ReadDirectoryChangesW requires
+
+	public:
+		directory(const std::string& path)
+			: _path(path)
+			, _handle(INVALID_HANDLE_VALUE)
+			, _event(nullptr)
+			, _buffer(EVENT_BUFFER_SIZE / sizeof(DWORD)) {
+			ZeroMemory(&_overlapped, sizeof(_overlapped));
+		}
+
+		~directory() {
+			if (_handle != INVALID_HANDLE_VALUE) {
+				::CancelIo(_handle);
+				::CloseHandle(_handle);
+			}
+			if (_event != nullptr) {
+				::CloseHandle(_event);
+			}
+		}
+
+		bool open() {
+			_handle = ::CreateFileA(
+				_path.c_str(),
+				FILE_LIST_DIRECTORY,
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+				nullptr,
+				OPEN_EXISTING,
+				FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+				nullptr);
+			if (_handle == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+			_event = ::CreateEventA(nullptr, TRUE, FALSE, nullptr);
+			return _event != nullptr && read_changes();
+		}
+
+		bool read_changes() {
+			::ResetEvent(_event);
+			_overlapped.hEvent = _event;
+			return ::ReadDirectoryChangesW(
+				_handle,
+				_buffer.data(),
+				static_cast<DWORD>(_buffer.size() * sizeof(DWORD)),
+				FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+				nullptr,
+				&_overlapped,
+				nullptr) != FALSE;
+		}
+
+		bool collect_changes(std::vector<std::string>& changed_paths) {
+			DWORD byte_count = 0;
+			if (!::GetOverlappedResult(_handle, &_overlapped, &byte_count, FALSE)) {
+				return false;
+			}
+
+			if (byte_count == 0) {
+				list_fbx_files(_path, changed_paths); //the buffer overflowed
+			}
+			else {
+				const auto* bytes = reinterpret_cast<const unsigned char*>(_buffer.data());
+				for (;;) {
+					const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(bytes);
+					if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+						int wide_length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+						int length = ::WideCharToMultiByte(CP_ACP, 0, info->FileName, wide_length, nullptr, 0, nullptr, nullptr);
+						std::string file_name(length, '\0');
+						::WideCharToMultiByte(CP_ACP, 0, info->FileName, wide_length, &file_name[0], length, nullptr, nullptr);
+						if (is_fbx_path(file_name)) {
+							changed_paths.push_back(join_path(_path, file_name));
+						}
+					}
+					if (info->NextEntryOffset == 0) {
+						break;
+					}
+					bytes += info->NextEntryOffset;
+				}
+			}
+			return read_changes();
+		}
+	};
+
+	fbx_directory_watcher::fbx_directory_watcher() {
+	}
+
+	fbx_directory_watcher::~fbx_directory_watcher() {
+	}
+
+	bool fbx_directory_watcher::add_directory(const std::string& dir_path) {
+		if (_directories.size() >= MAXIMUM_WAIT_OBJECTS) {
+			return false; //one event per directory in WaitForMultipleObjects
+		}
+		std::unique_ptr<directory> new_directory(new directory(dir_path));
+		if (!new_directory->open()) {
+			return false;
+		}
+		_directories.push_back(std::move(new_directory));
+		return true;
+	}
+
+	bool fbx_directory_watcher::wait_for_changes(int timeout_milliseconds, std::vector<std::string>& changed_paths) {
+		std::vector<HANDLE> events;
+		for (const auto& directory : _directories) {
+			events.push_back(directory->_event);
+		}
+		if (events.empty()) {
+			::Sleep(static_cast<DWORD>(timeout_milliseconds));
+			return true;
+		}
+
+		DWORD result = ::WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, static_cast<DWORD>(timeout_milliseconds));
+		if (result == WAIT_TIMEOUT) {
+			return true;
+		}
+		if (result >= WAIT_OBJECT_0 + events.size()) {
+			return false;
+		}
+
+		//the first signaled directory woke us, any other one with changes is collected now rather than next call.
+		for (size_t i = result - WAIT_OBJECT_0; i < events.size(); ++i) {
+			if (::WaitForSingleObject(events[i], 0) == WAIT_OBJECT_0 && !_directories[i]->collect_changes(changed_paths)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool fbx_directory_watcher::wait_until_closed(const std::string& path, int timeout_milliseconds) {
+		//ReadDirectoryChangesW reports writes as they happen, an exporter may still be writing. opening without
+		//sharing fails with a sharing violation until every other handle is closed.
+		auto start = ::GetTickCount();
+		for (;;) {
+			HANDLE handle = ::CreateFileA(path.c_str(), GENERIC_READ, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (handle != INVALID_HANDLE_VALUE) {
+				::CloseHandle(handle);
+				return true;
+			}
+			DWORD error = ::GetLastError();
+			if (error != ERROR_SHARING_VIOLATION && error != ERROR_LOCK_VIOLATION) {
+				return true; //deleted or renamed away, the conversion reports it
+			}
+			if (static_cast<int>(::GetTickCount() - start) >= timeout_milliseconds) {
+				return false;
+			}
+			::Sleep(CLOSE_RETRY_MILLISECONDS);
+		}
+	}
+
+	void fbx_directory_watcher::list_fbx_files(const std::string& dir_path, std::vector<std::string>& paths) {
+		WIN32_FIND_DATAA find_data;
+		HANDLE find_handle = ::FindFirstFileA(join_path(dir_path, "*.fbx").c_str(), &find_data);
+		if (find_handle == INVALID_HANDLE_VALUE) {
+			return;
+		}
+		do {
+			if ((find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+				paths.push_back(join_path(dir_path, find_data.cFileName));
+			}
+		} while (::FindNextFileA(find_handle, &find_data));
+		::FindClose(find_handle);
+	}
+
+	std::string fbx_directory_watcher::join_path(const std::string& dir_path, const std::string& file_name) {
+		return dir_path + "\\" + file_name;
+	}
+
+#else
+
+	class fbx_directory_watcher::directory {
+	public:
+		std::string _path;
+		int _watch_descriptor;
+	};
+
+	fbx_directory_watcher::fbx_directory_watcher()
+		: _inotify_fd(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+		, _event_buffer(EVENT_BUFFER_SIZE) {
+	}
+
+	fbx_directory_watcher::~fbx_directory_watcher() {
+		if (_inotify_fd >= 0) {
+			::close(_inotify_fd); //removes every watch
+		}
+	}
+
+	bool fbx_directory_watcher::add_directory(const std::string& dir_path) {
+		if (_inotify_fd < 0) {
+			return false;
+		}
+		//close write rather than modify, so a save is one event once the file is complete. moved to catches the
+		//write to a temporary file then rename that some exporters do.
+		int watch_descriptor = ::inotify_add_watch(_inotify_fd, dir_path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+		if (watch_descriptor < 0) {
+			return false;
+		}
+		std::unique_ptr<directory> new_directory(new directory());
+		new_directory->_path = dir_path;
+		new_directory->_watch_descriptor = watch_descriptor;
+		_directories.push_back(std::move(new_directory));
+		return true;
+	}
+
+	bool fbx_directory_watcher::wait_for_changes(int timeout_milliseconds, std::vector<std::string>& changed_paths) {
+		pollfd poll_fd;
+		poll_fd.fd = _inotify_fd;
+		poll_fd.events = POLLIN;
+		poll_fd.revents = 0;
+		int result = ::poll(&poll_fd, 1, timeout_milliseconds);
+		if (result <= 0) {
+			return result == 0;
+		}
+
+		for (;;) {
+			ssize_t byte_count = ::read(_inotify_fd, _event_buffer.data(), _event_buffer.size());
+			if (byte_count <= 0) {
+				return true; //drained, EAGAIN
+			}
+
+			for (ssize_t offset = 0; offset < byte_count;) {
+				const auto* event = reinterpret_cast<const inotify_event*>(_event_buffer.data() + offset);
+				offset += sizeof(inotify_event) + event->len;
+
+				if ((event->mask & IN_Q_OVERFLOW) != 0) {
+					for (const auto& directory : _directories) {
+						list_fbx_files(directory->_path, changed_paths);
+					}
+					continue;
+				}
+				if (event->len == 0 || !is_fbx_path(event->name)) {
+					continue;
+				}
+				auto directory = std::find_if(_directories.begin(), _directories.end(), [event](const std::unique_ptr<fbx_directory_watcher::directory>& d) {
+					return d->_watch_descriptor == event->wd;
+				});
+				if (directory != _directories.end()) {
+					changed_paths.push_back(join_path((*directory)->_path, event->name));
+				}
+			}
+		}
+	}
+
+	bool fbx_directory_watcher::wait_until_closed(const std::string&, int) {
+		return true; //IN_CLOSE_WRITE and IN_MOVED_TO are only sent for complete files
+	}
+
+	void fbx_directory_watcher::list_fbx_files(const std::string& dir_path, std::vector<std::string>& paths) {
+		DIR* dir = ::opendir(dir_path.c_str());
+		if (dir == nullptr) {
+			return;
+		}
+		while (dirent* entry = ::readdir(dir)) {
+			if (entry->d_type != DT_DIR && is_fbx_path(entry->d_name)) {
+				paths.push_back(join_path(dir_path, entry->d_name));
+			}
+		}
+		::closedir(dir);
+	}
+
+	std::string fbx_directory_watcher::join_path(const std::string& dir_path, const std::string& file_name) {
+		return dir_path + "/" + file_name;
+	}
+
+#endif
+
+	bool fbx_directory_watcher::is_fbx_path(const std::string& path) {
+		if (path.size() < 4) {
+			return false;
+		}
+		std::string extension = path.substr(path.size() - 4);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+		return extension == ".fbx";
+	}
+
+}
\ No newline at end of file
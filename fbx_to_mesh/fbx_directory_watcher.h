@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace solar {
+
+	//reports .fbx files written, created or renamed into a set of directories (not their subdirectories).
+	//ReadDirectoryChangesW on windows, inotify on linux. a directory whose events overflowed reports every .fbx in
+	//it, so nothing is missed, only converted again.
+	//
+	//the same file is often reported several times for one save, callers are expected to debounce. on windows a
+	//change is reported while the file is still being written, see wait_until_closed.
+
+	class fbx_directory_watcher {
+	public:
+		static const int EVENT_BUFFER_SIZE = 64 * 1024;
+		static const int CLOSE_RETRY_MILLISECONDS = 50;
+
+	private:
+		class directory;
+
+		std::vector<std::unique_ptr<directory>> _directories;
+#ifndef _WIN32
+		int _inotify_fd;
+		std::vector<char> _event_buffer;
+#endif
+
+	public:
+		fbx_directory_watcher();
+		fbx_directory_watcher(const fbx_directory_watcher&) = delete;
+		fbx_directory_watcher& operator=(const fbx_directory_watcher&) = delete;
+		~fbx_directory_watcher();
+
+		bool add_directory(const std::string& dir_path); //false if it can't be watched
+
+		//waits until something changes or the timeout passes and appends the changed .fbx paths. false on error.
+		bool wait_for_changes(int timeout_milliseconds, std::vector<std::string>& changed_paths);
+
+		//waits until no other process has path open, false if it still does after the timeout. linux only reports
+		//files once they're closed, so there it returns true right away.
+		static bool wait_until_closed(const std::string& path, int timeout_milliseconds);
+
+		static bool is_fbx_path(const std::string& path);
+		static void list_fbx_files(const std::string& dir_path, std::vector<std::string>& paths);
+		static std::string join_path(const std::string& dir_path, const std::string& file_name);
+	};
+
+}
\ No newline at end of file
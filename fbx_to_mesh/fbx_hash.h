@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace solar {
+
+	//the raw bytes hash fbx_vertex_deduper keys its tables with, also used to fingerprint whole arrays. it's fast
+	//rather than strong (fbx_sha256 is for that), so equal hashes must always be confirmed by comparing the bytes.
+	//
+	//start from FBX_HASH_SEED, add words or bytes, then finish with mix_fbx_hash.
+
+	const uint64_t FBX_HASH_SEED = 0x9e3779b97f4a7c15ULL;
+
+	inline uint64_t add_fbx_hash_word(uint64_t h, uint32_t word) {
+		h = (h ^ word) * 0x100000001b3ULL;
+		return (h << 27) | (h >> 37);
+	}
+
+	inline uint64_t add_fbx_hash_words(uint64_t h, const uint32_t* words, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			h = add_fbx_hash_word(h, words[i]);
+		}
+		return h;
+	}
+
+	inline uint64_t add_fbx_hash_bytes(uint64_t h, const void* bytes, size_t size) {
+		//memcpy rather than casting, the bytes don't have to be aligned. a partial last word is zero padded.
+		const unsigned char* p = static_cast<const unsigned char*>(bytes);
+		for (size_t i = 0; i < size; i += sizeof(uint32_t)) {
+			uint32_t word = 0;
+			std::memcpy(&word, p + i, (size - i < sizeof(uint32_t)) ? size - i : sizeof(uint32_t));
+			h = add_fbx_hash_word(h, word);
+		}
+		return h;
+	}
+
+	inline uint64_t mix_fbx_hash(uint64_t h) {
+		//murmur3 fmix64
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+
+namespace solar {
+
+	//layout of the -f mapped .mesh file. everything is little endian and sized with fixed width types so the
+	//runtime can map the file and point the GPU at the vertex and index sections without parsing them.
+	//
+	//[fbx_mapped_mesh_header][fbx_mapped_mesh_section x section_count][section data...]
+	//
+	//section offsets are from the start of the file. vertex and index data start on 64 byte boundaries, everything
+	//else on 16 byte boundaries. this header has no dependencies so the runtime can include it as is.
+
+	const uint32_t FBX_MAPPED_MESH_MAGIC = 0x4853454d; //"MESH"
+	const uint32_t FBX_MAPPED_MESH_VERSION = 6; //bump whenever the layout of anything in this file changes
+	const uint32_t FBX_MAPPED_MESH_SECTION_ALIGNMENT = 16;
+	const uint32_t FBX_MAPPED_MESH_BUFFER_ALIGNMENT = 64;
+
+	enum class fbx_mapped_section_type : uint32_t {
+		VERTICES = 1, //vertex_stride bytes per vertex, see vertex_format
+		INDICES = 2, //index_size bytes per index, relative to the submesh's vertex_begin. LOD 0 followed by each LOD
+		SUBMESHES = 3, //fbx_mapped_submesh, index ranges are LOD 0's, vertex ranges are shared by every LOD
+		DRAW_RANGES = 4, //fbx_mapped_draw_range, one per run of triangles sharing a material within a submesh
+		MATERIALS = 5, //fbx_mapped_material
+		STRINGS = 6, //null terminated strings referenced by offset from the start of this section
+		LODS = 7, //fbx_mapped_lod, from most to least detailed. LOD 0 is the full detail mesh
+		MESHLETS = 8, //fbx_mapped_meshlet, covering LOD 0
+		MESHLET_VERTICES = 9, //uint32_t, relative to the meshlet's submesh's vertex_begin
+		MESHLET_TRIANGLES = 10, //uint8_t, 3 per triangle, into the meshlet's vertices
+		BOUNDS = 11, //fbx_mapped_bounds, the whole mesh followed by one per material
+		BVH_NODES = 12, //fbx_mapped_bvh_node, depth first, root first
+		BVH_TRIANGLES = 13, //uint32_t, LOD 0 triangle index (index_begin / 3) referenced by the BVH leaves
+		POSITIONS = 14, //float[3], LOD 0's unique positions for depth and shadow passes
+		POSITION_INDICES = 15 //uint16_t or uint32_t (element_size), 3 per LOD 0 triangle into POSITIONS, no submeshes
+	};
+
+	class fbx_mapped_mesh_header {
+	public:
+		uint32_t _magic;
+		uint32_t _version;
+		uint32_t _header_size;
+		uint32_t _section_count;
+		uint64_t _section_table_offset;
+		uint64_t _file_size;
+		uint32_t _index_size; //2 or 4
+		uint32_t _vertex_format; //0 is full float vertices (position, normal, tangent, tangent sign, uv), otherwise the fbx_vertex_packer version
+		uint32_t _vertex_stride;
+		uint32_t _reserved;
+		float _position_min[3]; //packed positions decode to min + extent * quantized / 65535
+		float _position_extent[3];
+	};
+
+	class fbx_mapped_mesh_section {
+	public:
+		fbx_mapped_section_type _type;
+		uint32_t _element_size;
+		uint64_t _element_count;
+		uint64_t _offset;
+		uint64_t _size;
+	};
+
+	class fbx_mapped_submesh {
+	public:
+		uint32_t _vertex_begin;
+		uint32_t _vertex_count;
+		uint32_t _index_begin;
+		uint32_t _index_count;
+	};
+
+	class fbx_mapped_draw_range {
+	public:
+		uint32_t _submesh_index;
+		uint32_t _material_index;
+		uint32_t _index_begin;
+		uint32_t _index_count;
+	};
+
+	class fbx_mapped_material {
+	public:
+		uint32_t _diffuse_map_offset; //into STRINGS
+		uint32_t _normal_map_offset;
+	};
+
+	class fbx_mapped_lod {
+	public:
+		uint32_t _draw_range_begin; //into DRAW_RANGES
+		uint32_t _draw_range_count;
+		float _error; //largest distance of a full detail vertex to this LOD's triangles, measured, in mesh units
+		float _relative_error; //_error / bounding sphere radius, for picking a LOD by projected screen space error
+	};
+
+	class fbx_mapped_meshlet {
+	public:
+		uint32_t _submesh_index;
+		uint32_t _material_index;
+		uint32_t _vertex_begin; //into MESHLET_VERTICES
+		uint32_t _vertex_count;
+		uint32_t _triangle_begin; //into MESHLET_TRIANGLES, in triangles
+		uint32_t _triangle_count;
+		float _center[3]; //bounding sphere
+		float _radius;
+		float _cone_apex[3]; //back facing from c when dot(normalize(apex - c), axis) >= cutoff
+		float _cone_axis[3];
+		float _cone_cutoff; //1 when the meshlet can't be cone culled
+		uint32_t _reserved;
+	};
+
+	class fbx_mapped_bounds {
+	public:
+		float _min[3];
+		float _max[3];
+		float _center[3]; //of the bounding sphere
+		float _radius;
+	};
+
+	//an interior node's first child is the next node and _offset is its second child. a leaf has _count > 0
+	//triangles starting at _offset in BVH_TRIANGLES.
+	class fbx_mapped_bvh_node {
+	public:
+		float _min[3];
+		uint32_t _offset;
+		float _max[3];
+		uint32_t _count;
+	};
+
+	static_assert(sizeof(fbx_mapped_mesh_header) == 72, "fbx_mapped_mesh_header layout is part of the file format");
+	static_assert(sizeof(fbx_mapped_mesh_section) == 32, "fbx_mapped_mesh_section layout is part of the file format");
+	static_assert(sizeof(fbx_mapped_submesh) == 16, "fbx_mapped_submesh layout is part of the file format");
+	static_assert(sizeof(fbx_mapped_draw_range) == 16, "fbx_mapped_draw_range layout is part of the file format");
+	static_assert(sizeof(fbx_mapped_material) == 8, "fbx_mapped_material layout is part of the file format");
+	static_assert(sizeof(fbx_mapped_lod) == 16, "fbx_mapped_lod layout is part of the file format");
+	static_assert(sizeof(fbx_mapped_meshlet) == 72, "fbx_mapped_meshlet layout is part of the file format");
+	static_assert(sizeof(fbx_mapped_bounds) == 40, "fbx_mapped_bounds layout is part of the file format");
+	static_assert(sizeof(fbx_mapped_bvh_node) == 32, "fbx_mapped_bvh_node layout is part of the file format");
+
+}
\ No newline at end of file
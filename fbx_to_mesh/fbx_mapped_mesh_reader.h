@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "fbx_mapped_mesh_format.h"
+
+namespace solar {
+
+	//read only view over contiguous elements of a mapped section.
+	template<typename T>
+	class fbx_mapped_span {
+	private:
+		const T* _data;
+		size_t _size;
+
+	public:
+		fbx_mapped_span()
+			: _data(nullptr)
+			, _size(0) {
+		}
+
+		fbx_mapped_span(const T* data, size_t size)
+			: _data(data)
+			, _size(size) {
+		}
+
+		const T* data() const { return _data; }
+		size_t size() const { return _size; }
+		bool empty() const { return _size == 0; }
+		const T* begin() const { return _data; }
+		const T* end() const { return _data + _size; }
+		const T& operator[](size_t i) const { return _data[i]; }
+	};
+
+	//validates a -f mapped .mesh file already in memory (typically mapped) and hands out spans over its sections.
+	//nothing is copied, the memory must outlive the reader and every span it returns. header only so the runtime
+	//can use it without linking anything from the tool.
+
+	class fbx_mapped_mesh_reader {
+	private:
+		const unsigned char* _data;
+		size_t _size;
+		std::string _error;
+
+	public:
+		fbx_mapped_mesh_reader()
+			: _data(nullptr)
+			, _size(0) {
+		}
+
+		//returns false and sets get_error() if the data is not a valid mapped mesh of a supported version.
+		bool open(const void* data, size_t size) {
+			_data = static_cast<const unsigned char*>(data);
+			_size = size;
+			_error.clear();
+
+			if (_data == nullptr || _size < sizeof(fbx_mapped_mesh_header)) {
+				return fail("file is smaller than the header");
+			}
+			if (reinterpret_cast<uintptr_t>(_data) % FBX_MAPPED_MESH_BUFFER_ALIGNMENT != 0) {
+				return fail("data is not 64 byte aligned");
+			}
+
+			const auto& header = get_header();
+			if (header._magic != FBX_MAPPED_MESH_MAGIC) {
+				return fail("not a mapped mesh");
+			}
+			if (header._version != FBX_MAPPED_MESH_VERSION) {
+				return fail("unsupported version " + std::to_string(header._version));
+			}
+			if (header._header_size != sizeof(fbx_mapped_mesh_header) || header._file_size != _size) {
+				return fail("header or file size mismatch");
+			}
+			if (header._index_size != 2 && header._index_size != 4) {
+				return fail("invalid index size");
+			}
+
+			uint64_t table_size = static_cast<uint64_t>(header._section_count) * sizeof(fbx_mapped_mesh_section);
+			if (header._section_table_offset % FBX_MAPPED_MESH_SECTION_ALIGNMENT != 0 ||
+				header._section_table_offset > _size ||
+				table_size > _size - header._section_table_offset) {
+				return fail("section table out of bounds");
+			}
+
+			for (const auto& section : get_sections()) {
+				if (section._offset % FBX_MAPPED_MESH_SECTION_ALIGNMENT != 0 ||
+					section._offset > _size ||
+					section._size > _size - section._offset) {
+					return fail("section out of bounds");
+				}
+				if (section._element_size == 0 || section._size % section._element_size != 0 || section._size / section._element_size != section._element_count) {
+					return fail("section size mismatch");
+				}
+				if (section._type == fbx_mapped_section_type::STRINGS && section._size > 0 && _data[section._offset + section._size - 1] != 0) {
+					return fail("strings are not null terminated");
+				}
+			}
+			return true;
+		}
+
+		const std::string& get_error() const {
+			return _error;
+		}
+
+		const fbx_mapped_mesh_header& get_header() const {
+			return *reinterpret_cast<const fbx_mapped_mesh_header*>(_data);
+		}
+
+		fbx_mapped_span<fbx_mapped_mesh_section> get_sections() const {
+			const auto& header = get_header();
+			return fbx_mapped_span<fbx_mapped_mesh_section>(
+				reinterpret_cast<const fbx_mapped_mesh_section*>(_data + header._section_table_offset),
+				header._section_count);
+		}
+
+		//empty if the section is missing or its elements are not sizeof(T).
+		template<typename T>
+		fbx_mapped_span<T> get_section(fbx_mapped_section_type type) const {
+			for (const auto& section : get_sections()) {
+				if (section._type == type && section._element_size == sizeof(T)) {
+					return fbx_mapped_span<T>(reinterpret_cast<const T*>(_data + section._offset), static_cast<size_t>(section._element_count));
+				}
+			}
+			return fbx_mapped_span<T>();
+		}
+
+		fbx_mapped_span<unsigned char> get_section_bytes(fbx_mapped_section_type type) const {
+			for (const auto& section : get_sections()) {
+				if (section._type == type) {
+					return fbx_mapped_span<unsigned char>(_data + section._offset, static_cast<size_t>(section._size));
+				}
+			}
+			return fbx_mapped_span<unsigned char>();
+		}
+
+		const char* get_string(uint32_t offset) const {
+			auto strings = get_section_bytes(fbx_mapped_section_type::STRINGS);
+			return (offset < strings.size()) ? reinterpret_cast<const char*>(strings.data() + offset) : "";
+		}
+
+	private:
+		bool fail(const std::string& error) {
+			_error = error;
+			return false;
+		}
+	};
+
+}
\ No newline at end of file
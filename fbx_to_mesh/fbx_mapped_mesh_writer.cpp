@@ -0,0 +1,296 @@
+#include "fbx_mapped_mesh_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include "solar/utility/assert.h"
+
+namespace solar {
+
+	bool fbx_mapped_mesh_writer::write(const fbx_output_mesh& mesh, std::ostream& stream) {
+		_sections.clear();
+		add_vertices_section(mesh);
+		add_indices_section(mesh);
+		add_submeshes_draw_ranges_and_lods_sections(mesh);
+		add_materials_and_strings_sections(mesh);
+		add_meshlets_sections(mesh);
+		add_bounds_and_bvh_sections(mesh);
+		add_position_stream_sections(mesh);
+
+		fbx_mapped_mesh_header header;
+		std::memset(&header, 0, sizeof(header));
+		header._magic = FBX_MAPPED_MESH_MAGIC;
+		header._version = FBX_MAPPED_MESH_VERSION;
+		header._header_size = sizeof(fbx_mapped_mesh_header);
+		header._section_count = static_cast<uint32_t>(_sections.size());
+		header._section_table_offset = align_up(sizeof(fbx_mapped_mesh_header), FBX_MAPPED_MESH_SECTION_ALIGNMENT);
+		header._index_size = static_cast<uint32_t>(mesh._index_size);
+		header._vertex_format = mesh.is_packed() ? fbx_vertex_packer::FORMAT_VERSION : 0;
+		header._vertex_stride = static_cast<uint32_t>(mesh.is_packed() ? sizeof(fbx_packed_vertex) : sizeof(fbx_polygon_vertex_data));
+		header._position_min[0] = mesh._packed_position_min._x;
+		header._position_min[1] = mesh._packed_position_min._y;
+		header._position_min[2] = mesh._packed_position_min._z;
+		header._position_extent[0] = mesh._packed_position_extent._x;
+		header._position_extent[1] = mesh._packed_position_extent._y;
+		header._position_extent[2] = mesh._packed_position_extent._z;
+
+		uint64_t offset = header._section_table_offset + _sections.size() * sizeof(fbx_mapped_mesh_section);
+		for (auto& pending : _sections) {
+			offset = align_up(offset, pending._alignment);
+			pending._section._offset = offset;
+			offset += pending._section._size;
+		}
+		header._file_size = align_up(offset, FBX_MAPPED_MESH_SECTION_ALIGNMENT);
+
+		//padding is written as zeros so the same input always produces the same bytes.
+		fbx_block_writer writer(stream);
+		auto pad_to = [&writer](uint64_t target) {
+			ASSERT(target >= writer.get_written_bytes() && target - writer.get_written_bytes() < FBX_MAPPED_MESH_BUFFER_ALIGNMENT);
+			writer.write_zeros(target - writer.get_written_bytes());
+		};
+
+		writer.write(&header, sizeof(header));
+		pad_to(header._section_table_offset);
+		for (const auto& pending : _sections) {
+			writer.write(&pending._section, sizeof(pending._section));
+		}
+		for (const auto& pending : _sections) {
+			pad_to(pending._section._offset);
+			write_section_data(pending, writer);
+			ASSERT(writer.get_written_bytes() == pending._section._offset + pending._section._size);
+		}
+		pad_to(header._file_size);
+
+		bool is_ok = writer.flush();
+		_sections.clear(); //the source blocks point into the mesh
+		return is_ok;
+	}
+
+	void fbx_mapped_mesh_writer::add_section(fbx_mapped_section_type type, const void* data, uint32_t element_size, uint64_t element_count, uint32_t alignment) {
+		pending_section pending;
+		pending._section._type = type;
+		pending._section._element_size = element_size;
+		pending._section._element_count = element_count;
+		pending._section._offset = 0;
+		pending._section._size = element_size * element_count;
+		pending._is_narrowed_to_16_bit = false;
+		pending._alignment = alignment;
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		pending._data.assign(bytes, bytes + pending._section._size);
+		_sections.push_back(std::move(pending));
+	}
+
+	void fbx_mapped_mesh_writer::add_source_section(fbx_mapped_section_type type, const void* data, uint32_t element_size, uint64_t element_count, uint32_t alignment) {
+		pending_section pending;
+		pending._section._type = type;
+		pending._section._element_size = element_size;
+		pending._section._element_count = element_count;
+		pending._section._offset = 0;
+		pending._section._size = element_size * element_count;
+		pending._is_narrowed_to_16_bit = false;
+		pending._alignment = alignment;
+		if (element_count > 0) {
+			source_block block;
+			block._data = data;
+			block._size = pending._section._size;
+			pending._source_blocks.push_back(block);
+		}
+		_sections.push_back(std::move(pending));
+	}
+
+	void fbx_mapped_mesh_writer::write_section_data(const pending_section& pending, fbx_block_writer& writer) const {
+		writer.write(pending._data.data(), pending._data.size());
+		for (const auto& block : pending._source_blocks) {
+			if (!pending._is_narrowed_to_16_bit) {
+				writer.write(block._data, block._size);
+				continue;
+			}
+
+			const auto* indices = static_cast<const uint32_t*>(block._data);
+			uint64_t index_count = block._size / sizeof(uint32_t);
+			uint16_t narrowed[NARROWING_CHUNK_SIZE];
+			for (uint64_t begin = 0; begin < index_count; begin += NARROWING_CHUNK_SIZE) {
+				uint64_t count = std::min<uint64_t>(index_count - begin, NARROWING_CHUNK_SIZE);
+				for (uint64_t i = 0; i < count; ++i) {
+					narrowed[i] = static_cast<uint16_t>(indices[begin + i]); //submeshes guarantee they fit
+				}
+				writer.write(narrowed, count * sizeof(uint16_t));
+			}
+		}
+	}
+
+	void fbx_mapped_mesh_writer::add_vertices_section(const fbx_output_mesh& mesh) {
+		if (mesh.is_packed()) {
+			add_source_section(fbx_mapped_section_type::VERTICES, mesh._packed_vertices.data(), sizeof(fbx_packed_vertex), mesh._packed_vertices.size(), FBX_MAPPED_MESH_BUFFER_ALIGNMENT);
+		}
+		else {
+			add_source_section(fbx_mapped_section_type::VERTICES, mesh._vertices.data(), sizeof(fbx_polygon_vertex_data), mesh._vertices.size(), FBX_MAPPED_MESH_BUFFER_ALIGNMENT);
+		}
+	}
+
+	void fbx_mapped_mesh_writer::add_indices_section(const fbx_output_mesh& mesh) {
+		//LOD 0 then every LOD, one source block each rather than concatenated.
+		add_source_section(fbx_mapped_section_type::INDICES, mesh._indices.data(), sizeof(uint32_t), mesh._indices.size(), FBX_MAPPED_MESH_BUFFER_ALIGNMENT);
+		auto& pending = _sections.back();
+		for (const auto& lod : mesh._lods) {
+			if (!lod._indices.empty()) {
+				source_block block;
+				block._data = lod._indices.data();
+				block._size = lod._indices.size() * sizeof(uint32_t);
+				pending._source_blocks.push_back(block);
+				pending._section._element_count += lod._indices.size();
+			}
+		}
+
+		if (mesh._index_size == 2) {
+			pending._is_narrowed_to_16_bit = true;
+			pending._section._element_size = sizeof(uint16_t);
+		}
+		pending._section._size = pending._section._element_size * pending._section._element_count;
+	}
+
+	void fbx_mapped_mesh_writer::add_submeshes_draw_ranges_and_lods_sections(const fbx_output_mesh& mesh) {
+		std::vector<fbx_mapped_submesh> submeshes;
+		for (const auto& submesh : mesh._submeshes) {
+			fbx_mapped_submesh mapped_submesh;
+			mapped_submesh._vertex_begin = static_cast<uint32_t>(submesh._vertex_begin);
+			mapped_submesh._vertex_count = static_cast<uint32_t>(submesh._vertex_count);
+			mapped_submesh._index_begin = static_cast<uint32_t>(submesh._triangle_begin * 3);
+			mapped_submesh._index_count = static_cast<uint32_t>(submesh._triangle_count * 3);
+			submeshes.push_back(mapped_submesh);
+		}
+
+		std::vector<fbx_mapped_draw_range> draw_ranges;
+		std::vector<fbx_mapped_lod> lods;
+		auto add_lod = [&](const std::vector<fbx_output_draw_range>& lod_draw_ranges, int index_offset, float error, float relative_error) {
+			fbx_mapped_lod lod;
+			lod._draw_range_begin = static_cast<uint32_t>(draw_ranges.size());
+			lod._draw_range_count = static_cast<uint32_t>(lod_draw_ranges.size());
+			lod._error = error;
+			lod._relative_error = relative_error;
+			for (const auto& lod_draw_range : lod_draw_ranges) {
+				fbx_mapped_draw_range draw_range;
+				draw_range._submesh_index = static_cast<uint32_t>(lod_draw_range._submesh_index);
+				draw_range._material_index = static_cast<uint32_t>(lod_draw_range._material_index);
+				draw_range._index_begin = static_cast<uint32_t>(index_offset + lod_draw_range._triangle_begin * 3);
+				draw_range._index_count = static_cast<uint32_t>(lod_draw_range._triangle_count * 3);
+				draw_ranges.push_back(draw_range);
+			}
+			lods.push_back(lod);
+		};
+
+		add_lod(mesh._draw_ranges, 0, 0.f, 0.f);
+		int index_offset = static_cast<int>(mesh._indices.size());
+		for (const auto& lod : mesh._lods) {
+			add_lod(lod._draw_ranges, index_offset, lod._error, lod._relative_error);
+			index_offset += static_cast<int>(lod._indices.size());
+		}
+
+		add_section(fbx_mapped_section_type::SUBMESHES, submeshes.data(), sizeof(fbx_mapped_submesh), submeshes.size(), FBX_MAPPED_MESH_SECTION_ALIGNMENT);
+		add_section(fbx_mapped_section_type::DRAW_RANGES, draw_ranges.data(), sizeof(fbx_mapped_draw_range), draw_ranges.size(), FBX_MAPPED_MESH_SECTION_ALIGNMENT);
+		add_section(fbx_mapped_section_type::LODS, lods.data(), sizeof(fbx_mapped_lod), lods.size(), FBX_MAPPED_MESH_SECTION_ALIGNMENT);
+	}
+
+	void fbx_mapped_mesh_writer::add_materials_and_strings_sections(const fbx_output_mesh& mesh) {
+		std::vector<char> strings;
+		auto add_string = [&strings](const std::string& s) {
+			auto offset = static_cast<uint32_t>(strings.size());
+			strings.insert(strings.end(), s.begin(), s.end());
+			strings.push_back('\0');
+			return offset;
+		};
+
+		std::vector<fbx_mapped_material> materials;
+		for (const auto& material : mesh._materials) {
+			fbx_mapped_material mapped_material;
+			mapped_material._diffuse_map_offset = add_string(material._diffuse_map);
+			mapped_material._normal_map_offset = add_string(material._normal_map);
+			materials.push_back(mapped_material);
+		}
+		add_section(fbx_mapped_section_type::MATERIALS, materials.data(), sizeof(fbx_mapped_material), materials.size(), FBX_MAPPED_MESH_SECTION_ALIGNMENT);
+		add_section(fbx_mapped_section_type::STRINGS, strings.data(), 1, strings.size(), FBX_MAPPED_MESH_SECTION_ALIGNMENT);
+	}
+
+	void fbx_mapped_mesh_writer::add_meshlets_sections(const fbx_output_mesh& mesh) {
+		if (mesh._meshlets.empty()) {
+			return;
+		}
+
+		auto copy_vec3 = [](float* out, const vec3& v) {
+			out[0] = v._x;
+			out[1] = v._y;
+			out[2] = v._z;
+		};
+
+		std::vector<fbx_mapped_meshlet> meshlets;
+		for (const auto& meshlet : mesh._meshlets) {
+			fbx_mapped_meshlet mapped_meshlet;
+			std::memset(&mapped_meshlet, 0, sizeof(mapped_meshlet));
+			mapped_meshlet._submesh_index = static_cast<uint32_t>(meshlet._submesh_index);
+			mapped_meshlet._material_index = static_cast<uint32_t>(meshlet._material_index);
+			mapped_meshlet._vertex_begin = static_cast<uint32_t>(meshlet._vertex_begin);
+			mapped_meshlet._vertex_count = static_cast<uint32_t>(meshlet._vertex_count);
+			mapped_meshlet._triangle_begin = static_cast<uint32_t>(meshlet._triangle_begin);
+			mapped_meshlet._triangle_count = static_cast<uint32_t>(meshlet._triangle_count);
+			copy_vec3(mapped_meshlet._center, meshlet._center);
+			mapped_meshlet._radius = meshlet._radius;
+			copy_vec3(mapped_meshlet._cone_apex, meshlet._cone_apex);
+			copy_vec3(mapped_meshlet._cone_axis, meshlet._cone_axis);
+			mapped_meshlet._cone_cutoff = meshlet._cone_cutoff;
+			meshlets.push_back(mapped_meshlet);
+		}
+		add_section(fbx_mapped_section_type::MESHLETS, meshlets.data(), sizeof(fbx_mapped_meshlet), meshlets.size(), FBX_MAPPED_MESH_SECTION_ALIGNMENT);
+		add_source_section(fbx_mapped_section_type::MESHLET_VERTICES, mesh._meshlet_vertices.data(), sizeof(uint32_t), mesh._meshlet_vertices.size(), FBX_MAPPED_MESH_BUFFER_ALIGNMENT);
+		add_source_section(fbx_mapped_section_type::MESHLET_TRIANGLES, mesh._meshlet_triangles.data(), sizeof(uint8_t), mesh._meshlet_triangles.size(), FBX_MAPPED_MESH_BUFFER_ALIGNMENT);
+	}
+
+	void fbx_mapped_mesh_writer::add_bounds_and_bvh_sections(const fbx_output_mesh& mesh) {
+		std::vector<fbx_mapped_bounds> bounds;
+		auto add_bounds = [&bounds](const fbx_output_bounds& output_bounds) {
+			fbx_mapped_bounds mapped_bounds;
+			mapped_bounds._min[0] = output_bounds._min._x;
+			mapped_bounds._min[1] = output_bounds._min._y;
+			mapped_bounds._min[2] = output_bounds._min._z;
+			mapped_bounds._max[0] = output_bounds._max._x;
+			mapped_bounds._max[1] = output_bounds._max._y;
+			mapped_bounds._max[2] = output_bounds._max._z;
+			mapped_bounds._center[0] = output_bounds._center._x;
+			mapped_bounds._center[1] = output_bounds._center._y;
+			mapped_bounds._center[2] = output_bounds._center._z;
+			mapped_bounds._radius = output_bounds._radius;
+			bounds.push_back(mapped_bounds);
+		};
+		add_bounds(mesh._bounds);
+		for (const auto& material_bounds : mesh._material_bounds) {
+			add_bounds(material_bounds);
+		}
+		add_section(fbx_mapped_section_type::BOUNDS, bounds.data(), sizeof(fbx_mapped_bounds), bounds.size(), FBX_MAPPED_MESH_SECTION_ALIGNMENT);
+
+		if (mesh._bvh.empty()) {
+			return;
+		}
+		static_assert(sizeof(fbx_mapped_bvh_node) == sizeof(fbx_bvh_node), "fbx_bvh_node is written as is");
+		add_source_section(fbx_mapped_section_type::BVH_NODES, mesh._bvh._nodes.data(), sizeof(fbx_mapped_bvh_node), mesh._bvh._nodes.size(), FBX_MAPPED_MESH_BUFFER_ALIGNMENT);
+		add_source_section(fbx_mapped_section_type::BVH_TRIANGLES, mesh._bvh._triangle_indices.data(), sizeof(uint32_t), mesh._bvh._triangle_indices.size(), FBX_MAPPED_MESH_SECTION_ALIGNMENT);
+	}
+
+	void fbx_mapped_mesh_writer::add_position_stream_sections(const fbx_output_mesh& mesh) {
+		if (mesh._position_stream.empty()) {
+			return;
+		}
+		static_assert(sizeof(vec3) == 3 * sizeof(float), "vec3 is written as is");
+		add_source_section(fbx_mapped_section_type::POSITIONS, mesh._position_stream.data(), sizeof(vec3), mesh._position_stream.size(), FBX_MAPPED_MESH_BUFFER_ALIGNMENT);
+		add_source_section(fbx_mapped_section_type::POSITION_INDICES, mesh._position_stream_indices.data(), sizeof(uint32_t), mesh._position_stream_indices.size(), FBX_MAPPED_MESH_BUFFER_ALIGNMENT);
+		if (mesh._position_stream_index_size == 2) {
+			auto& pending = _sections.back();
+			pending._is_narrowed_to_16_bit = true;
+			pending._section._element_size = sizeof(uint16_t);
+			pending._section._size = pending._section._element_size * pending._section._element_count;
+		}
+	}
+
+	uint64_t fbx_mapped_mesh_writer::align_up(uint64_t offset, uint32_t alignment) {
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+}
\ No newline at end of file
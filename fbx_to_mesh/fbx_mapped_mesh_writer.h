@@ -0,0 +1,56 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+#include "fbx_block_writer.h"
+#include "fbx_mapped_mesh_format.h"
+#include "fbx_output_mesh.h"
+
+namespace solar {
+
+	//writes an fbx_output_mesh as a -f mapped .mesh file, see fbx_mapped_mesh_format.h for the layout.
+	//
+	//vertex, index, meshlet, BVH and position stream data are streamed from the mesh's own arrays in large blocks, only the small
+	//sections the writer builds itself (submeshes, draw ranges, materials...) are copied.
+
+	class fbx_mapped_mesh_writer {
+	public:
+		static const int NARROWING_CHUNK_SIZE = 16 * 1024; //indices converted to 16 bits at a time, on the stack
+
+	private:
+		class source_block {
+		public:
+			const void* _data;
+			uint64_t _size; //bytes, as stored in the mesh
+		};
+
+		class pending_section {
+		public:
+			fbx_mapped_mesh_section _section;
+			std::vector<unsigned char> _data; //built by the writer
+			std::vector<source_block> _source_blocks; //written in order after _data, straight from the mesh
+			bool _is_narrowed_to_16_bit; //the source blocks are uint32_t indices written as uint16_t
+			uint32_t _alignment;
+		};
+
+		std::vector<pending_section> _sections;
+
+	public:
+		//returns false if the stream failed.
+		bool write(const fbx_output_mesh& mesh, std::ostream& stream);
+
+	private:
+		void add_section(fbx_mapped_section_type type, const void* data, uint32_t element_size, uint64_t element_count, uint32_t alignment);
+		void add_source_section(fbx_mapped_section_type type, const void* data, uint32_t element_size, uint64_t element_count, uint32_t alignment);
+		void write_section_data(const pending_section& pending, fbx_block_writer& writer) const;
+		void add_vertices_section(const fbx_output_mesh& mesh);
+		void add_indices_section(const fbx_output_mesh& mesh);
+		void add_submeshes_draw_ranges_and_lods_sections(const fbx_output_mesh& mesh);
+		void add_materials_and_strings_sections(const fbx_output_mesh& mesh);
+		void add_meshlets_sections(const fbx_output_mesh& mesh);
+		void add_bounds_and_bvh_sections(const fbx_output_mesh& mesh);
+		void add_position_stream_sections(const fbx_output_mesh& mesh);
+		static uint64_t align_up(uint64_t offset, uint32_t alignment);
+	};
+
+}
\ No newline at end of file
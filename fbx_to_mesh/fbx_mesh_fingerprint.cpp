@@ -0,0 +1,106 @@
+#include "fbx_mesh_fingerprint.h"
+
+#include <cstring>
+#include "fbx_hash.h"
+
+namespace solar {
+
+	fbx_mesh_fingerprint::fbx_mesh_fingerprint(FbxMesh* mesh)
+		: _hash(0) {
+
+		int control_point_count = mesh->GetControlPointsCount();
+		int polygon_vertex_count = mesh->GetPolygonVertexCount();
+		_counts_and_modes.push_back(static_cast<uint32_t>(control_point_count));
+		_counts_and_modes.push_back(static_cast<uint32_t>(polygon_vertex_count));
+		array_view control_points = { mesh->GetControlPoints(), control_point_count * sizeof(FbxVector4) };
+		array_view polygon_vertices = { mesh->GetPolygonVertices(), polygon_vertex_count * sizeof(int) };
+		_arrays.push_back(control_points);
+		_arrays.push_back(polygon_vertices);
+
+		//the same elements read_node_elements reads. material elements only index into the node's materials, which
+		//fbx_converter compares itself.
+		_counts_and_modes.push_back(static_cast<uint32_t>(mesh->GetElementNormalCount()));
+		for (int i_element = 0; i_element < mesh->GetElementNormalCount(); ++i_element) {
+			add_element(mesh->GetElementNormal(i_element), true);
+		}
+		_counts_and_modes.push_back(static_cast<uint32_t>(mesh->GetElementTangentCount()));
+		for (int i_element = 0; i_element < mesh->GetElementTangentCount(); ++i_element) {
+			add_element(mesh->GetElementTangent(i_element), true);
+		}
+		_counts_and_modes.push_back(static_cast<uint32_t>(mesh->GetElementUVCount(FbxLayerElement::eTextureDiffuse)));
+		for (int i_element = 0; i_element < mesh->GetElementUVCount(FbxLayerElement::eTextureDiffuse); ++i_element) {
+			add_element(mesh->GetElementUV(i_element, FbxLayerElement::eTextureDiffuse), true);
+		}
+		_counts_and_modes.push_back(static_cast<uint32_t>(mesh->GetElementMaterialCount()));
+		for (int i_element = 0; i_element < mesh->GetElementMaterialCount(); ++i_element) {
+			add_element(mesh->GetElementMaterial(i_element), false);
+		}
+
+		uint64_t h = add_fbx_hash_words(FBX_HASH_SEED, _counts_and_modes.data(), _counts_and_modes.size());
+		for (const auto& array : _arrays) {
+			if (array._data != nullptr) {
+				h = add_fbx_hash_bytes(h, array._data, array._size);
+			}
+		}
+		_hash = mix_fbx_hash(h);
+	}
+
+	fbx_mesh_fingerprint::~fbx_mesh_fingerprint() {
+		for (auto& release : _releases) {
+			release();
+		}
+	}
+
+	uint64_t fbx_mesh_fingerprint::get_hash() const {
+		return _hash;
+	}
+
+	bool fbx_mesh_fingerprint::is_identical(const fbx_mesh_fingerprint& rhs) const {
+		if (_hash != rhs._hash || _counts_and_modes != rhs._counts_and_modes || _arrays.size() != rhs._arrays.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < _arrays.size(); ++i) {
+			const auto& a = _arrays[i];
+			const auto& b = rhs._arrays[i];
+			if (a._size != b._size) {
+				return false;
+			}
+			if (a._size > 0 && a._data != b._data && (a._data == nullptr || b._data == nullptr || std::memcmp(a._data, b._data, a._size) != 0)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<typename ElementT>
+	void fbx_mesh_fingerprint::add_element(ElementT* element, bool is_direct_array_added) {
+		if (element == nullptr) {
+			_counts_and_modes.push_back(0xffffffff);
+			return;
+		}
+
+		_counts_and_modes.push_back(static_cast<uint32_t>(element->GetMappingMode()));
+		_counts_and_modes.push_back(static_cast<uint32_t>(element->GetReferenceMode()));
+		if (is_direct_array_added) {
+			add_locked_array(element->GetDirectArray());
+		}
+		if (element->GetReferenceMode() != FbxLayerElement::eDirect) {
+			add_locked_array(element->GetIndexArray());
+		}
+	}
+
+	template<typename T>
+	void fbx_mesh_fingerprint::add_locked_array(FbxLayerElementArrayTemplate<T>& array) {
+		int count = array.GetCount();
+		_counts_and_modes.push_back(static_cast<uint32_t>(count));
+
+		T* locked_values = array.GetLocked(FbxLayerElementArray::eReadLock);
+		array_view view = { locked_values, count * sizeof(T) };
+		_arrays.push_back(view);
+		if (locked_values != nullptr) {
+			FbxLayerElementArrayTemplate<T>* locked_array = &array;
+			_releases.push_back([locked_array, locked_values]() mutable { locked_array->Release(&locked_values); });
+		}
+	}
+
+}
\ No newline at end of file
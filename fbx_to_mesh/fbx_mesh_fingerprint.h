@@ -0,0 +1,50 @@
+#pragma once
+
+#include <fbxsdk.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace solar {
+
+	//the raw arrays an FbxMesh's geometry is made of, in local space : control points, polygon vertices and every
+	//normal, tangent, uv and material element the converter reads, with their mapping and reference modes.
+	//
+	//two meshes with equal arrays convert to the same geometry, which is how fbx_converter finds nodes to instance.
+	//the hash (see fbx_hash.h) is only a fingerprint, is_identical confirms a match byte for byte. the arrays stay
+	//locked for reading while the fingerprint exists.
+
+	class fbx_mesh_fingerprint {
+	private:
+		class array_view {
+		public:
+			const void* _data;
+			size_t _size;
+		};
+
+	private:
+		std::vector<uint32_t> _counts_and_modes; //tells the arrays apart, so the views alone can be compared
+		std::vector<array_view> _arrays;
+		std::vector<std::function<void()>> _releases;
+		uint64_t _hash;
+
+	public:
+		explicit fbx_mesh_fingerprint(FbxMesh* mesh);
+		~fbx_mesh_fingerprint();
+
+		uint64_t get_hash() const;
+		bool is_identical(const fbx_mesh_fingerprint& rhs) const;
+
+	private:
+		fbx_mesh_fingerprint(const fbx_mesh_fingerprint&);
+		fbx_mesh_fingerprint& operator=(const fbx_mesh_fingerprint&);
+
+		template<typename ElementT>
+		void add_element(ElementT* element, bool is_direct_array_added);
+
+		template<typename T>
+		void add_locked_array(FbxLayerElementArrayTemplate<T>& array);
+	};
+
+}
\ No newline at end of file
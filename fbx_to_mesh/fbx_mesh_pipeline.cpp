@@ -0,0 +1,755 @@
+#include "fbx_mesh_pipeline.h"
+
+#include "solar/utility/assert.h"
+#include "solar/utility/alert.h"
+#include "solar/utility/trace.h"
+#include "solar/strings/string_build.h"
+#include "solar/io/file_path_helpers.h"
+#include "fbx_vertex_deduper.h"
+#include "fbx_vertex_welder.h"
+#include "fbx_vertex_cache_optimizer.h"
+#include "fbx_overdraw_optimizer.h"
+#include "fbx_mesh_simplifier.h"
+#include "fbx_meshlet_builder.h"
+#include "fbx_tangent_frame_generator.h"
+#include "fbx_hash.h"
+#include "fbx_parallel_for.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+
+namespace solar {
+
+	namespace {
+		//ALERT and TRACE are not thread safe, pipelines running on worker threads share this lock.
+		std::mutex s_message_mutex;
+	}
+
+	fbx_mesh_pipeline::fbx_mesh_pipeline()
+		: fbx_mesh_pipeline(fbx_converter_params()) {
+	}
+
+	fbx_mesh_pipeline::fbx_mesh_pipeline(const fbx_converter_params& params)
+		: _params(params)
+		, _error_count(0)
+		, _warning_count(0) {
+	}
+
+	std::shared_ptr<fbx_output_mesh> fbx_mesh_pipeline::convert_mesh_data_to_output_mesh(fbx_converter_mesh_data mesh_data) {
+		reset_internals();
+		_mesh_data = std::move(mesh_data);
+		process_mesh_data();
+		return _output_mesh;
+	}
+
+	int fbx_mesh_pipeline::get_error_count() const {
+		return _error_count;
+	}
+
+	int fbx_mesh_pipeline::get_warning_count() const {
+		return _warning_count;
+	}
+
+	void fbx_mesh_pipeline::reset_internals() {
+		_error_count = 0;
+		_warning_count = 0;
+		_output_mesh.reset();
+		_mesh_data.clear();
+		_unduped_vertices.clear();
+		_arena.reset();
+		_stats.clear();
+	}
+
+
+	const fbx_conversion_stats& fbx_mesh_pipeline::get_stats() const {
+		return _stats;
+	}
+
+	void fbx_mesh_pipeline::process_mesh_data() {
+		_stats._polygon_vertex_count = _mesh_data.get_polygon_vertex_count();
+		_stats._triangle_count = _mesh_data.get_triangle_count();
+
+		run_stage("handle_missing_mesh_data", [this]() { handle_missing_mesh_data(); });
+		run_stage("dedup_materials", [this]() { dedup_materials(); });
+		run_stage("build_unduped_vertices", [this]() { build_unduped_vertices(); });
+		run_stage("weld_vertices", [this]() { weld_vertices(); });
+		run_stage("sort_polygons_by_material_index", [this]() { sort_polygons_by_material_index(); });
+		run_stage("optimize_vertex_cache", [this]() { optimize_vertex_cache(); });
+		run_stage("optimize_overdraw", [this]() { optimize_overdraw(); });
+		run_stage("optimize_vertex_fetch", [this]() { optimize_vertex_fetch(); });
+		run_stage("build_output_mesh", [this]() { build_output_mesh(); });
+
+		_stats._vertex_count = static_cast<int>(_unduped_vertices.size());
+		_stats._scratch_memory_bytes = _arena.get_allocated_bytes();
+		if (_output_mesh != nullptr) {
+			_stats._output_vertex_count = static_cast<int>(_output_mesh->_vertices.size());
+			_stats._output_triangle_count = _output_mesh->get_triangle_count();
+		}
+	}
+
+	void fbx_mesh_pipeline::handle_missing_mesh_data() {
+		
+		if (_mesh_data._materials.empty()) {
+			add_error_message("No materials found");
+			_mesh_data._materials.push_back(fbx_converter_mesh_data::material()); //add a dummy material so material indices can always be valid.
+		}
+
+		int no_uv_count = 0;
+		for (int i_pv = 0; i_pv < _mesh_data.get_polygon_vertex_count(); ++i_pv) {
+			if (!_mesh_data.has_attribute(i_pv, fbx_converter_mesh_data::HAS_UV)) {
+				no_uv_count++;
+				_mesh_data._uvs[i_pv] = uv();
+			}
+		}
+		if (no_uv_count > 0) {
+			add_warning_message(build_string("{} vertices are missing uvs", no_uv_count));
+		}
+
+		//generated rather than left constant so the runtime doesn't have to rebuild tangent frames at load. tangents
+		//need complete normals, and every vertex gets its tangent sign from the uvs whether its tangent was imported
+		//or not.
+		//still warnings, as when they were left constant : generated frames may not be what the artist intended.
+		fbx_tangent_frame_generator generator(_params._thread_count, _arena);
+		int generated_normal_count = generator.generate_normals(_mesh_data);
+		if (generated_normal_count > 0) {
+			add_warning_message(build_string("{} vertices are missing normals , generated smooth ones", generated_normal_count));
+		}
+		int generated_tangent_count = generator.generate_tangents(_mesh_data);
+		if (generated_tangent_count > 0) {
+			add_warning_message(build_string("{} vertices are missing tangents , generated them from the uvs", generated_tangent_count));
+		}
+
+		int no_material_count = 0;
+
+		for (auto& material_index : _mesh_data._material_indices) {
+			if (material_index == fbx_converter_mesh_data::NO_MATERIAL_INDEX) {
+				no_material_count++;
+				material_index = 0;
+			}
+			else if (material_index < 0 || material_index >= static_cast<int>(_mesh_data._materials.size())) {
+				add_error_message(build_string("Polygon Material Index is invalid : {}", material_index));
+				material_index = 0;
+			}
+		}
+
+		if (no_material_count > 0) {
+			add_warning_message(build_string("{} polygons are missing material index", no_material_count));
+		}
+	}
+
+	void fbx_mesh_pipeline::dedup_materials() {
+		//materials with the same map names once written would only cost extra draw calls. the first of them is kept
+		//and the others' triangles are moved to it. material indices are all valid by now.
+		std::vector<fbx_converter_mesh_data::material> unique_materials;
+		std::map<std::pair<std::string, std::string>, int> unique_material_indices; //by output map names
+		std::vector<int> material_remap;
+		material_remap.reserve(_mesh_data._materials.size());
+		for (const auto& material : _mesh_data._materials) {
+			auto key = std::make_pair(
+				get_file_name_no_path_no_extension(material._diffuse_map_file_name),
+				get_file_name_no_path_no_extension(material._normal_map_file_name));
+			auto inserted = unique_material_indices.insert(std::make_pair(key, static_cast<int>(unique_materials.size())));
+			if (inserted.second) {
+				unique_materials.push_back(material);
+			}
+			material_remap.push_back(inserted.first->second);
+		}
+
+		if (unique_materials.size() == _mesh_data._materials.size()) {
+			return;
+		}
+		add_verbose_message(build_string("merged {} identical materials into {}", _mesh_data._materials.size(), unique_materials.size()));
+		for (auto& material_index : _mesh_data._material_indices) {
+			material_index = material_remap[material_index];
+		}
+		_mesh_data._materials.swap(unique_materials);
+	}
+
+	void fbx_mesh_pipeline::build_unduped_vertices() {
+		//want all vertices that have the exact same data (position,normal,etc) to not be duplicated.
+		ASSERT(_unduped_vertices.empty());
+
+		fbx_vertex_deduper deduper(_params._thread_count, _arena);
+		deduper.dedup(_mesh_data, _unduped_vertices, _mesh_data._unduped_vertex_indices);
+
+		add_verbose_message(build_string("found {} unique vertices", _unduped_vertices.size()));
+	}
+
+	void fbx_mesh_pipeline::weld_vertices() {
+		//exact dedup keeps vertices apart over float noise from the DCC export or the coordinate conversion.
+		if (!_params._is_vertex_welding_enabled) {
+			return;
+		}
+
+		fbx_vertex_welder::tolerances tolerances;
+		tolerances._position = _params._weld_position_tolerance;
+		tolerances._normal_degrees = _params._weld_normal_degrees;
+		tolerances._tangent_degrees = _params._weld_tangent_degrees;
+		tolerances._uv = _params._weld_uv_tolerance;
+
+		fbx_vertex_welder welder(_params._thread_count, _arena);
+		auto result = welder.weld(tolerances, _mesh_data, _unduped_vertices);
+		_stats._welded_vertex_count = result._merged_vertex_count;
+		add_verbose_message(build_string("welded {} vertices into {} , removed {} collapsed triangles",
+			result._merged_vertex_count, _unduped_vertices.size(), result._removed_triangle_count));
+	}
+
+	void fbx_mesh_pipeline::sort_polygons_by_material_index() {
+		//want all triangles with the same material index grouped together to reduce render state changes.
+		//a counting sort on the material index : linear, and stable so each material keeps its triangles' order.
+		int material_count = static_cast<int>(_mesh_data._materials.size());
+		int triangle_count = _mesh_data.get_triangle_count();
+		fbx_arena_vector<int> material_offsets(material_count + 1, 0, _arena);
+		for (int material_index : _mesh_data._material_indices) {
+			material_offsets[material_index + 1]++;
+		}
+		for (int i_material = 0; i_material < material_count; ++i_material) {
+			material_offsets[i_material + 1] += material_offsets[i_material];
+		}
+
+		//scattered into the arena and copied back, so the mesh data keeps its capacity for the next conversion.
+		fbx_arena_vector<std::array<int, 3>> sorted_triangles(triangle_count, std::array<int, 3>(), _arena);
+		for (int i_triangle = 0; i_triangle < triangle_count; ++i_triangle) {
+			sorted_triangles[material_offsets[_mesh_data._material_indices[i_triangle]]++] = _mesh_data._triangles[i_triangle];
+		}
+		_mesh_data._triangles.assign(sorted_triangles.begin(), sorted_triangles.end());
+
+		//the offsets now end each material's range.
+		int i_sorted = 0;
+		for (int i_material = 0; i_material < material_count; ++i_material) {
+			for (; i_sorted < material_offsets[i_material]; ++i_sorted) {
+				_mesh_data._material_indices[i_sorted] = i_material;
+			}
+		}
+	}
+
+	void fbx_mesh_pipeline::optimize_vertex_cache() {
+		//reorder each material's triangles for the post-transform vertex cache.
+		int vertex_count = static_cast<int>(_unduped_vertices.size());
+
+		std::vector<unsigned int> indices;
+		_mesh_data.get_unduped_indices(indices);
+		auto stats_before = fbx_vertex_cache_optimizer::measure(indices, vertex_count);
+
+		fbx_vertex_cache_optimizer optimizer;
+		std::vector<int> range_order;
+		std::vector<std::array<int, 3>> optimized_triangles;
+		optimized_triangles.reserve(_mesh_data._triangles.size());
+		for (const auto& range : _mesh_data.get_material_triangle_ranges()) {
+			optimizer.optimize_triangle_order(&indices[range._begin * 3], range._end - range._begin, vertex_count, range_order);
+			for (int offset : range_order) {
+				optimized_triangles.push_back(_mesh_data._triangles[range._begin + offset]);
+			}
+		}
+		_mesh_data._triangles.swap(optimized_triangles); //material indices are unchanged, triangles never leave their range.
+
+		_mesh_data.get_unduped_indices(indices);
+		auto stats_after = fbx_vertex_cache_optimizer::measure(indices, vertex_count);
+		add_verbose_message(build_string("vertex cache : ACMR {} -> {} , ATVR {} -> {}", stats_before._acmr, stats_after._acmr, stats_before._atvr, stats_after._atvr));
+	}
+
+	void fbx_mesh_pipeline::optimize_overdraw() {
+		//reorder clusters of each material's cache optimized triangles so the outer surfaces draw first.
+		if (!_params._is_overdraw_optimization_enabled) {
+			return;
+		}
+
+		int vertex_count = static_cast<int>(_unduped_vertices.size());
+		std::vector<vec3> positions;
+		positions.reserve(vertex_count);
+		vec3 mesh_center;
+		for (const auto& vertex : _unduped_vertices) {
+			positions.push_back(vertex._position);
+			mesh_center = mesh_center + vertex._position;
+		}
+		if (vertex_count > 0) {
+			mesh_center = mesh_center * (1.f / vertex_count);
+		}
+
+		//NOTE: reverse winding order due to RH->LH coordinate system, same as build_output_mesh, so front faces are what
+		//the renderer sees.
+		std::vector<unsigned int> indices;
+		_mesh_data.get_unduped_indices(indices);
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			std::swap(indices[i + 1], indices[i + 2]);
+		}
+		auto cache_stats_before = fbx_vertex_cache_optimizer::measure(indices, vertex_count);
+		float overdraw_before = fbx_overdraw_optimizer::measure_overdraw(indices, positions);
+
+		fbx_overdraw_optimizer optimizer;
+		std::vector<int> range_order;
+		std::vector<std::array<int, 3>> optimized_triangles;
+		std::vector<unsigned int> optimized_indices;
+		optimized_triangles.reserve(_mesh_data._triangles.size());
+		optimized_indices.reserve(indices.size());
+		for (const auto& range : _mesh_data.get_material_triangle_ranges()) {
+			optimizer.optimize_triangle_order(
+				&indices[range._begin * 3],
+				range._end - range._begin,
+				positions,
+				mesh_center,
+				_params._overdraw_cache_threshold,
+				range_order);
+
+			for (int offset : range_order) {
+				int i_triangle = range._begin + offset;
+				optimized_triangles.push_back(_mesh_data._triangles[i_triangle]);
+				optimized_indices.insert(optimized_indices.end(), &indices[i_triangle * 3], &indices[i_triangle * 3 + 3]);
+			}
+		}
+		_mesh_data._triangles.swap(optimized_triangles);
+
+		auto cache_stats_after = fbx_vertex_cache_optimizer::measure(optimized_indices, vertex_count);
+		float overdraw_after = fbx_overdraw_optimizer::measure_overdraw(optimized_indices, positions);
+		add_verbose_message(build_string("overdraw : {} -> {} , ACMR {} -> {}", overdraw_before, overdraw_after, cache_stats_before._acmr, cache_stats_after._acmr));
+	}
+
+	void fbx_mesh_pipeline::optimize_vertex_fetch() {
+		//renumber vertices in first use order so vertex fetch walks the vertex buffer mostly forward.
+		int vertex_count = static_cast<int>(_unduped_vertices.size());
+
+		std::vector<unsigned int> indices;
+		_mesh_data.get_unduped_indices(indices);
+		std::vector<int> remap;
+		fbx_vertex_cache_optimizer::build_first_use_vertex_remap(indices, vertex_count, remap);
+
+		std::vector<fbx_polygon_vertex_data> remapped_vertices(vertex_count);
+		for (int i_vertex = 0; i_vertex < vertex_count; ++i_vertex) {
+			remapped_vertices[remap[i_vertex]] = _unduped_vertices[i_vertex];
+		}
+		_unduped_vertices.swap(remapped_vertices);
+		for (auto& unduped_vertex_index : _mesh_data._unduped_vertex_indices) {
+			if (unduped_vertex_index >= 0) { //-1 when welding removed its triangle
+				unduped_vertex_index = remap[unduped_vertex_index];
+			}
+		}
+	}
+
+	void fbx_mesh_pipeline::build_output_mesh() {
+		auto output_mesh = std::make_shared<fbx_output_mesh>();
+
+		for (auto material : _mesh_data._materials) {
+			mesh_material mat;
+			mat._diffuse_map = get_file_name_no_path_no_extension(material._diffuse_map_file_name);
+			mat._normal_map = get_file_name_no_path_no_extension(material._normal_map_file_name);
+			output_mesh->_materials.push_back(mat);
+		}
+
+		const auto& unduped_indices = _mesh_data._unduped_vertex_indices;
+		output_mesh->_indices.reserve(_mesh_data._triangles.size() * 3);
+		for (const auto& triangle : _mesh_data._triangles) {
+			//NOTE: reverse winding order due to RH->LH coordinate system.
+			output_mesh->_indices.push_back(static_cast<unsigned int>(unduped_indices[triangle.at(0)]));
+			output_mesh->_indices.push_back(static_cast<unsigned int>(unduped_indices[triangle.at(2)]));
+			output_mesh->_indices.push_back(static_cast<unsigned int>(unduped_indices[triangle.at(1)]));
+		}
+		output_mesh->_material_indices = _mesh_data._material_indices;
+		output_mesh->_vertices = _unduped_vertices;
+
+		if (_params._is_32_bit_index_enabled) {
+			output_mesh->set_single_submesh(4);
+		}
+		else {
+			output_mesh->set_single_submesh(2);
+			if (static_cast<int>(output_mesh->_vertices.size()) > fbx_output_mesh::MAX_16_BIT_VERTEX_COUNT) {
+				int duplicated_vertex_count = output_mesh->split_into_16_bit_submeshes();
+				add_verbose_message(build_string("split into {} submeshes for 16 bit indices : {} vertices duplicated", output_mesh->_submeshes.size(), duplicated_vertex_count));
+			}
+		}
+
+		build_lods(*output_mesh);
+		output_mesh->build_draw_ranges();
+		build_meshlets(*output_mesh);
+		output_mesh->compute_bounds();
+		build_bvh(*output_mesh);
+		build_position_stream(*output_mesh);
+
+		if (_params._is_vertex_packing_enabled) {
+			auto error_bounds = output_mesh->pack_vertices();
+			add_verbose_message(build_string("packed vertices : max error position {} , normal {} deg , tangent {} deg , uv {}",
+				error_bounds._position, error_bounds._normal_degrees, error_bounds._tangent_degrees, error_bounds._uv));
+		}
+
+		_output_mesh = output_mesh;
+	}
+
+	void fbx_mesh_pipeline::build_lods(fbx_output_mesh& output_mesh) {
+		//each LOD simplifies the previous one and reuses the mesh's vertices so only the index buffer grows. each LOD
+		//only gets what's left of the max error after the previous one's measured error. the simplifier's own error
+		//is an RMS quadric estimate that steers the collapses, it isn't a bound, so the error that's kept is measured.
+		if (_params._lod_count <= 0 || output_mesh._vertices.empty()) {
+			return;
+		}
+
+		vec3 min = output_mesh._vertices[0]._position;
+		vec3 max = min;
+		for (const auto& vertex : output_mesh._vertices) {
+			min = vec3(std::min(min._x, vertex._position._x), std::min(min._y, vertex._position._y), std::min(min._z, vertex._position._z));
+			max = vec3(std::max(max._x, vertex._position._x), std::max(max._y, vertex._position._y), std::max(max._z, vertex._position._z));
+		}
+		vec3 center = (min + max) * 0.5f;
+		float radius = 0.f;
+		for (const auto& vertex : output_mesh._vertices) {
+			vec3 d = vertex._position - center;
+			radius = std::max(radius, std::sqrt(d._x * d._x + d._y * d._y + d._z * d._z));
+		}
+		if (radius <= 0.f) {
+			return;
+		}
+		float max_error = _params._lod_max_error * radius;
+
+		//borders between submeshes must stay put, the neighboring submesh simplifies its side independently.
+		bool is_border_locked = output_mesh._submeshes.size() > 1;
+
+		fbx_mesh_simplifier simplifier;
+		fbx_vertex_cache_optimizer optimizer;
+		std::vector<vec3> positions;
+		std::vector<unsigned int> indices;
+		std::vector<int> material_indices;
+		std::vector<unsigned int> simplified_indices;
+		std::vector<int> simplified_material_indices;
+		std::vector<int> range_order;
+
+		const auto* previous_indices = &output_mesh._indices;
+		const auto* previous_material_indices = &output_mesh._material_indices;
+		const auto* previous_submeshes = &output_mesh._submeshes;
+		float previous_error = 0.f;
+		for (int i_lod = 0; i_lod < _params._lod_count; ++i_lod) {
+			fbx_output_lod lod;
+
+			for (const auto& previous_submesh : *previous_submeshes) {
+				positions.clear();
+				for (int i_vertex = 0; i_vertex < previous_submesh._vertex_count; ++i_vertex) {
+					positions.push_back(output_mesh._vertices[previous_submesh._vertex_begin + i_vertex]._position);
+				}
+				int triangle_begin = previous_submesh._triangle_begin;
+				int triangle_end = triangle_begin + previous_submesh._triangle_count;
+				indices.assign(previous_indices->begin() + triangle_begin * 3, previous_indices->begin() + triangle_end * 3);
+				material_indices.assign(previous_material_indices->begin() + triangle_begin, previous_material_indices->begin() + triangle_end);
+
+				int target_triangle_count = static_cast<int>(previous_submesh._triangle_count * _params._lod_triangle_ratio);
+				simplifier.simplify(positions, indices, material_indices, target_triangle_count, std::max(max_error - previous_error, 0.f), is_border_locked, simplified_indices, simplified_material_indices);
+
+				fbx_output_submesh submesh = previous_submesh;
+				submesh._triangle_begin = lod.get_triangle_count();
+				submesh._triangle_count = static_cast<int>(simplified_material_indices.size());
+
+				//the simplifier keeps triangle order, so material runs are still contiguous and can be cache optimized.
+				int run_begin = 0;
+				while (run_begin < submesh._triangle_count) {
+					int run_end = run_begin + 1;
+					while (run_end < submesh._triangle_count && simplified_material_indices[run_end] == simplified_material_indices[run_begin]) {
+						++run_end;
+					}
+					optimizer.optimize_triangle_order(&simplified_indices[run_begin * 3], run_end - run_begin, submesh._vertex_count, range_order);
+					for (int offset : range_order) {
+						int i_triangle = run_begin + offset;
+						lod._indices.insert(lod._indices.end(), &simplified_indices[i_triangle * 3], &simplified_indices[i_triangle * 3 + 3]);
+						lod._material_indices.push_back(simplified_material_indices[i_triangle]);
+					}
+					run_begin = run_end;
+				}
+				lod._submeshes.push_back(submesh);
+			}
+
+			int previous_triangle_count = static_cast<int>(previous_material_indices->size());
+			if (lod.get_triangle_count() == 0 || lod.get_triangle_count() > previous_triangle_count * 0.95f) {
+				add_verbose_message(build_string("LOD {} : stopped , {} triangles can't be simplified within the max error", i_lod + 1, previous_triangle_count));
+				break;
+			}
+			//every vertex is within the bounding sphere, so none can be further than its diameter from a LOD triangle.
+			lod._error = measure_lod_error(output_mesh, lod, 2.f * radius);
+			lod._relative_error = lod._error / radius;
+			add_verbose_message(build_string("LOD {} : {} triangles , error {} ({} of radius)", i_lod + 1, lod.get_triangle_count(), lod._error, lod._relative_error));
+
+			output_mesh._lods.push_back(std::move(lod));
+			previous_indices = &output_mesh._lods.back()._indices;
+			previous_material_indices = &output_mesh._lods.back()._material_indices;
+			previous_submeshes = &output_mesh._lods.back()._submeshes;
+			previous_error = output_mesh._lods.back()._error;
+		}
+	}
+
+	float fbx_mesh_pipeline::measure_lod_error(const fbx_output_mesh& output_mesh, const fbx_output_lod& lod, float max_distance) {
+		//the largest distance of a full detail vertex to the LOD's triangles, a one sided Hausdorff distance sampled
+		//at the vertices. the LOD's vertices are full detail vertices, so only the removed ones are measured.
+		const int MIN_VERTICES_PER_THREAD = 4096;
+
+		std::vector<vec3> positions;
+		positions.reserve(output_mesh._vertices.size());
+		for (const auto& vertex : output_mesh._vertices) {
+			positions.push_back(vertex._position);
+		}
+		std::vector<unsigned int> indices;
+		indices.reserve(lod._indices.size());
+		for (const auto& submesh : lod._submeshes) {
+			for (int i = submesh._triangle_begin * 3; i < (submesh._triangle_begin + submesh._triangle_count) * 3; ++i) {
+				indices.push_back(submesh._vertex_begin + lod._indices[i]);
+			}
+		}
+		fbx_bvh bvh;
+		bvh.build(positions, indices);
+
+		int vertex_count = static_cast<int>(positions.size());
+		fbx_arena_vector<unsigned char> is_kept(vertex_count, 0, _arena);
+		for (unsigned int index : indices) {
+			is_kept[index] = 1;
+		}
+		fbx_arena_vector<float> distances(vertex_count, 0.f, _arena);
+		fbx_parallel_for(_params._thread_count, vertex_count, MIN_VERTICES_PER_THREAD, [&](int begin, int end) {
+			for (int i_vertex = begin; i_vertex < end; ++i_vertex) {
+				if (is_kept[i_vertex]) {
+					continue;
+				}
+				float distance;
+				int triangle;
+				bvh.find_closest(positions, indices, positions[i_vertex], max_distance, distance, triangle);
+				distances[i_vertex] = distance;
+			}
+		});
+
+		float error = 0.f;
+		for (float distance : distances) {
+			error = std::max(error, distance);
+		}
+		return error;
+	}
+
+	void fbx_mesh_pipeline::build_meshlets(fbx_output_mesh& output_mesh) {
+		//per submesh and material run of the final triangle order, which is cache optimized and so keeps meshlets
+		//spatially compact.
+		if (!_params._is_meshlet_generation_enabled) {
+			return;
+		}
+
+		fbx_meshlet_builder builder;
+		std::vector<vec3> positions;
+		for (size_t i_submesh = 0; i_submesh < output_mesh._submeshes.size(); ++i_submesh) {
+			const auto& submesh = output_mesh._submeshes[i_submesh];
+			positions.clear();
+			for (int i_vertex = 0; i_vertex < submesh._vertex_count; ++i_vertex) {
+				positions.push_back(output_mesh._vertices[submesh._vertex_begin + i_vertex]._position);
+			}
+
+			int triangle_end = submesh._triangle_begin + submesh._triangle_count;
+			int run_begin = submesh._triangle_begin;
+			while (run_begin < triangle_end) {
+				int material_index = output_mesh._material_indices[run_begin];
+				int run_end = run_begin + 1;
+				while (run_end < triangle_end && output_mesh._material_indices[run_end] == material_index) {
+					++run_end;
+				}
+
+				size_t meshlet_begin = output_mesh._meshlets.size();
+				builder.build(&output_mesh._indices[run_begin * 3], run_end - run_begin, positions, output_mesh._meshlets, output_mesh._meshlet_vertices, output_mesh._meshlet_triangles);
+				for (size_t i_meshlet = meshlet_begin; i_meshlet < output_mesh._meshlets.size(); ++i_meshlet) {
+					output_mesh._meshlets[i_meshlet]._submesh_index = static_cast<int>(i_submesh);
+					output_mesh._meshlets[i_meshlet]._material_index = material_index;
+				}
+				run_begin = run_end;
+			}
+		}
+
+		int cone_cullable_count = 0;
+		for (const auto& meshlet : output_mesh._meshlets) {
+			if (meshlet._cone_cutoff < 1.f) {
+				++cone_cullable_count;
+			}
+		}
+		if (!output_mesh._meshlets.empty()) {
+			float meshlet_count = static_cast<float>(output_mesh._meshlets.size());
+			add_verbose_message(build_string("meshlets : {} , {} vertices and {} triangles on average , {} cone cullable",
+				output_mesh._meshlets.size(), output_mesh._meshlet_vertices.size() / meshlet_count, output_mesh.get_triangle_count() / meshlet_count, cone_cullable_count));
+		}
+	}
+
+	void fbx_mesh_pipeline::build_bvh(fbx_output_mesh& output_mesh) {
+		if (_params._is_bvh_enabled) {
+			output_mesh.build_bvh();
+			add_verbose_message(build_string("BVH : {} nodes , {} leaves", output_mesh._bvh._nodes.size(), output_mesh._bvh.get_leaf_count()));
+		}
+		if (_params._raycast_benchmark_ray_count > 0) {
+			run_raycast_benchmark(output_mesh);
+		}
+	}
+
+	void fbx_mesh_pipeline::build_position_stream(fbx_output_mesh& output_mesh) {
+		//vertices that only differ in their attributes share a position, depth and shadow passes don't need them
+		//apart. dedup the full detail positions on their own, then cache optimize and renumber their triangles for
+		//the smaller vertex count.
+		if (!_params._is_position_stream_enabled) {
+			return;
+		}
+
+		std::vector<vec3> positions;
+		std::vector<unsigned int> indices;
+		output_mesh.get_positions(positions);
+		output_mesh.get_absolute_indices(indices);
+		int vertex_count = static_cast<int>(positions.size());
+		int triangle_count = static_cast<int>(indices.size() / 3);
+
+		//open addressing on the position bits, -0 stored as +0 so it still dedups. load factor at most 0.5.
+		const int EMPTY_SLOT = -1;
+		int table_size = 16;
+		while (table_size < vertex_count * 2) {
+			table_size <<= 1;
+		}
+		uint64_t table_mask = static_cast<uint64_t>(table_size - 1);
+		fbx_arena_vector<int> table(table_size, EMPTY_SLOT, _arena);
+		fbx_arena_vector<int> unique_indices(vertex_count, 0, _arena);
+		auto& unique_positions = output_mesh._position_stream;
+		unique_positions.clear();
+		for (int i_vertex = 0; i_vertex < vertex_count; ++i_vertex) {
+			vec3 position = positions[i_vertex];
+			position._x = (position._x == 0.f) ? 0.f : position._x;
+			position._y = (position._y == 0.f) ? 0.f : position._y;
+			position._z = (position._z == 0.f) ? 0.f : position._z;
+
+			uint64_t slot = mix_fbx_hash(add_fbx_hash_bytes(FBX_HASH_SEED, &position, sizeof(vec3))) & table_mask;
+			for (;;) {
+				int unique_index = table[slot];
+				if (unique_index == EMPTY_SLOT) {
+					unique_index = static_cast<int>(unique_positions.size());
+					unique_positions.push_back(position);
+					table[slot] = unique_index;
+					unique_indices[i_vertex] = unique_index;
+					break;
+				}
+				if (std::memcmp(&unique_positions[unique_index], &position, sizeof(vec3)) == 0) {
+					unique_indices[i_vertex] = unique_index;
+					break;
+				}
+				slot = (slot + 1) & table_mask;
+			}
+		}
+		int unique_count = static_cast<int>(unique_positions.size());
+
+		for (auto& index : indices) {
+			index = static_cast<unsigned int>(unique_indices[index]);
+		}
+		auto stats_before = fbx_vertex_cache_optimizer::measure(indices, unique_count);
+
+		//no materials to keep apart, the whole list is one range.
+		fbx_vertex_cache_optimizer optimizer;
+		std::vector<int> triangle_order;
+		optimizer.optimize_triangle_order(indices.data(), triangle_count, unique_count, triangle_order);
+		auto& stream_indices = output_mesh._position_stream_indices;
+		stream_indices.clear();
+		stream_indices.reserve(indices.size());
+		for (int i_triangle : triangle_order) {
+			stream_indices.insert(stream_indices.end(), &indices[i_triangle * 3], &indices[i_triangle * 3 + 3]);
+		}
+
+		std::vector<int> remap;
+		fbx_vertex_cache_optimizer::build_first_use_vertex_remap(stream_indices, unique_count, remap);
+		std::vector<vec3> remapped_positions(unique_count);
+		for (int i_position = 0; i_position < unique_count; ++i_position) {
+			remapped_positions[remap[i_position]] = unique_positions[i_position];
+		}
+		unique_positions.swap(remapped_positions);
+		for (auto& index : stream_indices) {
+			index = static_cast<unsigned int>(remap[index]);
+		}
+		output_mesh._position_stream_index_size = (unique_count <= fbx_output_mesh::MAX_16_BIT_VERTEX_COUNT) ? 2 : 4;
+
+		auto stats_after = fbx_vertex_cache_optimizer::measure(stream_indices, unique_count);
+		add_verbose_message(build_string("position stream : {} positions for {} vertices , ACMR {} -> {}", unique_count, vertex_count, stats_before._acmr, stats_after._acmr));
+	}
+
+	void fbx_mesh_pipeline::run_raycast_benchmark(const fbx_output_mesh& output_mesh) {
+		//rays from a sphere around the mesh towards random points in its box, most of them hit something.
+		std::vector<vec3> positions;
+		std::vector<unsigned int> indices;
+		output_mesh.get_positions(positions);
+		output_mesh.get_absolute_indices(indices);
+		if (indices.empty()) {
+			return;
+		}
+
+		fbx_bvh benchmark_bvh;
+		const fbx_bvh* bvh = &output_mesh._bvh;
+		if (bvh->empty()) {
+			benchmark_bvh.build(positions, indices);
+			bvh = &benchmark_bvh;
+		}
+
+		const auto& bounds = output_mesh._bounds;
+		std::mt19937 random(12345); //fixed so runs are comparable
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+		std::vector<vec3> origins;
+		std::vector<vec3> directions;
+		for (int i_ray = 0; i_ray < _params._raycast_benchmark_ray_count; ++i_ray) {
+			float z = unit(random) * 2.f - 1.f;
+			float angle = unit(random) * 6.2831853f;
+			float r = std::sqrt(std::max(0.f, 1.f - z * z));
+			vec3 origin = bounds._center + vec3(r * std::cos(angle), r * std::sin(angle), z) * (bounds._radius * 2.f + 1e-3f);
+			vec3 target(
+				bounds._min._x + (bounds._max._x - bounds._min._x) * unit(random),
+				bounds._min._y + (bounds._max._y - bounds._min._y) * unit(random),
+				bounds._min._z + (bounds._max._z - bounds._min._z) * unit(random));
+			origins.push_back(origin);
+			directions.push_back(target - origin);
+		}
+
+		const float MAX_T = std::numeric_limits<float>::max();
+		std::vector<float> bvh_ts(origins.size());
+		std::vector<float> brute_force_ts(origins.size());
+		int hit_count = 0;
+
+		auto bvh_start = std::chrono::high_resolution_clock::now();
+		for (size_t i_ray = 0; i_ray < origins.size(); ++i_ray) {
+			int hit_triangle;
+			hit_count += bvh->raycast(positions, indices, origins[i_ray], directions[i_ray], MAX_T, bvh_ts[i_ray], hit_triangle) ? 1 : 0;
+		}
+		auto bvh_end = std::chrono::high_resolution_clock::now();
+		for (size_t i_ray = 0; i_ray < origins.size(); ++i_ray) {
+			int hit_triangle;
+			fbx_bvh::raycast_brute_force(positions, indices, origins[i_ray], directions[i_ray], MAX_T, brute_force_ts[i_ray], hit_triangle);
+		}
+		auto brute_force_end = std::chrono::high_resolution_clock::now();
+
+		int mismatch_count = 0;
+		for (size_t i_ray = 0; i_ray < origins.size(); ++i_ray) {
+			if (bvh_ts[i_ray] != brute_force_ts[i_ray]) {
+				++mismatch_count;
+			}
+		}
+
+		double bvh_ms = std::chrono::duration<double, std::milli>(bvh_end - bvh_start).count();
+		double brute_force_ms = std::chrono::duration<double, std::milli>(brute_force_end - bvh_end).count();
+		add_verbose_message(build_string("raycast benchmark : {} rays , {} hits , BVH {} ms , brute force {} ms ({}x)",
+			origins.size(), hit_count, bvh_ms, brute_force_ms, (bvh_ms > 0.0) ? brute_force_ms / bvh_ms : 0.0));
+		if (mismatch_count > 0) {
+			add_warning_message(build_string("raycast benchmark : {} rays hit differently with the BVH", mismatch_count));
+		}
+	}
+
+	void fbx_mesh_pipeline::add_verbose_message(const std::string& message) {
+		if (_params._is_verbose) {
+			std::lock_guard<std::mutex> lock(s_message_mutex);
+			TRACE(message.c_str());
+		}
+	}
+
+	void fbx_mesh_pipeline::add_warning_message(const std::string& message) {
+		if (_params._is_warnings_as_errors_enabled) {
+			add_error_message(message);
+		}
+		else {
+			std::lock_guard<std::mutex> lock(s_message_mutex);
+			TRACE("WARNING : {}", message);
+		}
+		_warning_count++;
+	}
+
+	void fbx_mesh_pipeline::add_error_message(const std::string& message) {
+		std::lock_guard<std::mutex> lock(s_message_mutex);
+		_error_count++;
+		ALERT(message.c_str());
+	}
+
+}
\ No newline at end of file
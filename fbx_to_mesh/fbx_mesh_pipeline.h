@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "fbx_conversion_stats.h"
+#include "fbx_converter_mesh_data.h"
+#include "fbx_converter_params.h"
+#include "fbx_polygon_vertex_data.h"
+#include "fbx_output_mesh.h"
+#include "fbx_scratch_arena.h"
+
+namespace solar {
+
+	//every conversion stage after import, from fbx_converter_mesh_data to fbx_output_mesh. nothing here depends on
+	//the FBX SDK, so meshes built in memory (tests, benchmarks, other importers) go through exactly the same code
+	//as fbx_converter. a pipeline must only be used by one thread at a time.
+	//
+	//stage scratch memory comes from the pipeline's arena and the mesh data is cleared rather than replaced, so
+	//once a pipeline has converted its largest mesh later conversions barely touch the heap.
+
+	class fbx_mesh_pipeline {
+	protected:
+		fbx_converter_params _params;
+		int _error_count;
+		int _warning_count;
+		fbx_conversion_stats _stats;
+		fbx_scratch_arena _arena;
+
+		std::shared_ptr<fbx_output_mesh> _output_mesh;
+		fbx_converter_mesh_data _mesh_data;
+		std::vector<fbx_polygon_vertex_data> _unduped_vertices;
+
+	public:
+		fbx_mesh_pipeline();
+		fbx_mesh_pipeline(const fbx_converter_params& params);
+
+		//mesh_data must be complete as imported : positions, attributes with their flags, triangles, materials and
+		//control point vertices built.
+		std::shared_ptr<fbx_output_mesh> convert_mesh_data_to_output_mesh(fbx_converter_mesh_data mesh_data);
+
+		int get_error_count() const; //errors reported by the last conversion
+		int get_warning_count() const; //warnings reported by the last conversion, also counted as errors with warnings_as_errors
+		const fbx_conversion_stats& get_stats() const; //of the last conversion
+
+	protected:
+		void reset_internals();
+		void process_mesh_data();
+
+		template<typename FuncT>
+		void run_stage(const char* name, FuncT func);
+
+		void add_verbose_message(const std::string& message);
+		void add_warning_message(const std::string& message);
+		void add_error_message(const std::string& message);
+
+	private:
+		void handle_missing_mesh_data();
+		void dedup_materials();
+		void build_unduped_vertices();
+		void weld_vertices();
+		void sort_polygons_by_material_index();
+		void optimize_vertex_cache();
+		void optimize_overdraw();
+		void optimize_vertex_fetch();
+		void build_output_mesh();
+		void build_lods(fbx_output_mesh& output_mesh);
+		float measure_lod_error(const fbx_output_mesh& output_mesh, const fbx_output_lod& lod, float max_distance);
+		void build_meshlets(fbx_output_mesh& output_mesh);
+		void build_bvh(fbx_output_mesh& output_mesh);
+		void build_position_stream(fbx_output_mesh& output_mesh);
+		void run_raycast_benchmark(const fbx_output_mesh& output_mesh);
+	};
+
+
+	template<typename FuncT>
+	void fbx_mesh_pipeline::run_stage(const char* name, FuncT func) {
+		auto start = std::chrono::high_resolution_clock::now();
+		func();
+		auto end = std::chrono::high_resolution_clock::now();
+		_stats.add_stage(name, std::chrono::duration<double, std::milli>(end - start).count(), _arena.get_allocated_bytes());
+	}
+
+}
\ No newline at end of file
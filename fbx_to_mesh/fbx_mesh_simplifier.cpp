@@ -0,0 +1,534 @@
+#include "fbx_mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace solar {
+
+	namespace {
+
+		const float CONSTRAINED_EDGE_WEIGHT = 10.f; //keeps constrained vertices from sliding off their edge line
+		const float MIN_FLIP_COSINE = 0.25f;
+
+		float dot_product(const vec3& a, const vec3& b) {
+			return a._x * b._x + a._y * b._y + a._z * b._z;
+		}
+
+		vec3 cross_product(const vec3& a, const vec3& b) {
+			return vec3(
+				a._y * b._z - a._z * b._y,
+				a._z * b._x - a._x * b._z,
+				a._x * b._y - a._y * b._x);
+		}
+
+		vec3 normalized_or_zero(const vec3& v) {
+			float length = std::sqrt(dot_product(v, v));
+			return (length > 0.f) ? v * (1.f / length) : vec3();
+		}
+
+	}
+
+	fbx_mesh_simplifier::quadric::quadric()
+		: _a00(0.0), _a01(0.0), _a02(0.0), _a11(0.0), _a12(0.0), _a22(0.0)
+		, _b0(0.0), _b1(0.0), _b2(0.0)
+		, _c(0.0)
+		, _weight(0.0) {
+	}
+
+	void fbx_mesh_simplifier::quadric::add_plane(const vec3& normal, float distance, float weight) {
+		double a = normal._x;
+		double b = normal._y;
+		double c = normal._z;
+		double d = distance;
+		_a00 += weight * a * a;
+		_a01 += weight * a * b;
+		_a02 += weight * a * c;
+		_a11 += weight * b * b;
+		_a12 += weight * b * c;
+		_a22 += weight * c * c;
+		_b0 += weight * a * d;
+		_b1 += weight * b * d;
+		_b2 += weight * c * d;
+		_c += weight * d * d;
+		_weight += weight;
+	}
+
+	void fbx_mesh_simplifier::quadric::add(const quadric& rhs) {
+		_a00 += rhs._a00;
+		_a01 += rhs._a01;
+		_a02 += rhs._a02;
+		_a11 += rhs._a11;
+		_a12 += rhs._a12;
+		_a22 += rhs._a22;
+		_b0 += rhs._b0;
+		_b1 += rhs._b1;
+		_b2 += rhs._b2;
+		_c += rhs._c;
+		_weight += rhs._weight;
+	}
+
+	float fbx_mesh_simplifier::quadric::get_error(const vec3& p) const {
+		if (_weight <= 0.0) {
+			return 0.f;
+		}
+		double x = p._x;
+		double y = p._y;
+		double z = p._z;
+		double squared_distance_sum =
+			_a00 * x * x + _a11 * y * y + _a22 * z * z +
+			2.0 * (_a01 * x * y + _a02 * x * z + _a12 * y * z) +
+			2.0 * (_b0 * x + _b1 * y + _b2 * z) +
+			_c;
+		return static_cast<float>(std::sqrt(std::max(0.0, squared_distance_sum) / _weight));
+	}
+
+	fbx_mesh_simplifier::fbx_mesh_simplifier()
+		: _positions(nullptr)
+		, _neighbor_mark(0) {
+	}
+
+	float fbx_mesh_simplifier::simplify(
+		const std::vector<vec3>& positions,
+		const std::vector<unsigned int>& indices,
+		const std::vector<int>& material_indices,
+		int target_triangle_count,
+		float max_error,
+		bool is_border_locked,
+		std::vector<unsigned int>& simplified_indices,
+		std::vector<int>& simplified_material_indices) {
+
+		_positions = &positions;
+		_indices = indices;
+		_material_indices = material_indices;
+		_remap.resize(positions.size());
+		std::iota(_remap.begin(), _remap.end(), 0);
+		_neighbor_marks.assign(positions.size(), 0);
+		_neighbor_mark = 0;
+
+		build_representatives();
+		int triangle_count = compact_triangles(); //drops triangles that are already degenerate
+		build_adjacency();
+		build_quadrics();
+
+		//each pass collapses the cheapest edge of every vertex it can without two collapses touching the same
+		//triangles, then rebuilds adjacency. the error only grows so a pass that can't collapse anything is the end.
+		float error = 0.f;
+		while (triangle_count > target_triangle_count) {
+			classify_vertices(is_border_locked);
+			find_collapses();
+
+			_is_locked_this_pass.assign(positions.size(), false);
+			int removed_triangle_count = 0;
+			int collapse_count = 0;
+			for (const auto& c : _collapses) {
+				if (c._error > max_error || removed_triangle_count >= triangle_count - target_triangle_count) {
+					break;
+				}
+				int collapse_removed_triangle_count = 0;
+				if (try_collapse(c, collapse_removed_triangle_count)) {
+					removed_triangle_count += collapse_removed_triangle_count;
+					collapse_count++;
+					error = std::max(error, c._error);
+				}
+			}
+
+			if (collapse_count == 0) {
+				break;
+			}
+			triangle_count = compact_triangles();
+			build_adjacency();
+		}
+
+		simplified_indices.swap(_indices);
+		simplified_material_indices.swap(_material_indices);
+		_positions = nullptr;
+		return error;
+	}
+
+	void fbx_mesh_simplifier::build_representatives() {
+		const auto& positions = *_positions;
+		std::vector<int> sorted_vertices(positions.size());
+		std::iota(sorted_vertices.begin(), sorted_vertices.end(), 0);
+		std::sort(sorted_vertices.begin(), sorted_vertices.end(), [&positions](int a, int b) {
+			const auto& pa = positions[a];
+			const auto& pb = positions[b];
+			if (pa._x != pb._x) return pa._x < pb._x;
+			if (pa._y != pb._y) return pa._y < pb._y;
+			if (pa._z != pb._z) return pa._z < pb._z;
+			return a < b;
+		});
+
+		_representatives.resize(positions.size());
+		for (size_t i = 0; i < sorted_vertices.size(); ++i) {
+			int vertex = sorted_vertices[i];
+			bool is_same_as_previous = (i > 0 && positions[sorted_vertices[i - 1]] == positions[vertex]);
+			_representatives[vertex] = is_same_as_previous ? _representatives[sorted_vertices[i - 1]] : vertex;
+		}
+	}
+
+	void fbx_mesh_simplifier::build_adjacency() {
+		_adjacency_offsets.assign(_positions->size() + 1, 0);
+		for (unsigned int index : _indices) {
+			_adjacency_offsets[get_representative(index) + 1]++;
+		}
+		std::partial_sum(_adjacency_offsets.begin(), _adjacency_offsets.end(), _adjacency_offsets.begin());
+
+		std::vector<int> fill_offsets(_adjacency_offsets.begin(), _adjacency_offsets.end() - 1);
+		_adjacency.resize(_indices.size());
+		for (size_t i = 0; i < _indices.size(); ++i) {
+			_adjacency[fill_offsets[get_representative(_indices[i])]++] = static_cast<int>(i / 3);
+		}
+	}
+
+	fbx_mesh_simplifier::edge_kind fbx_mesh_simplifier::classify_edge(int from, int to) const {
+		int forward_count = 0;
+		int backward_count = 0;
+		unsigned int forward_from = 0, forward_to = 0, backward_from = 0, backward_to = 0;
+		int forward_material = 0, backward_material = 0;
+
+		for (int i = _adjacency_offsets[from]; i < _adjacency_offsets[from + 1]; ++i) {
+			int triangle = _adjacency[i];
+			const unsigned int* corners = &_indices[triangle * 3];
+			for (int k = 0; k < 3; ++k) {
+				if (get_representative(corners[k]) != from) {
+					continue;
+				}
+				unsigned int next = corners[(k + 1) % 3];
+				unsigned int previous = corners[(k + 2) % 3];
+				if (get_representative(next) == to) {
+					forward_count++;
+					forward_from = corners[k];
+					forward_to = next;
+					forward_material = _material_indices[triangle];
+				}
+				if (get_representative(previous) == to) {
+					backward_count++;
+					backward_from = corners[k];
+					backward_to = previous;
+					backward_material = _material_indices[triangle];
+				}
+			}
+		}
+
+		if (forward_count > 1 || backward_count > 1) {
+			return NON_MANIFOLD_EDGE;
+		}
+		if (forward_count + backward_count == 1) {
+			return BORDER_EDGE;
+		}
+		if (forward_count == 1 && (forward_from != backward_from || forward_to != backward_to || forward_material != backward_material)) {
+			return SEAM_EDGE;
+		}
+		return INTERIOR_EDGE;
+	}
+
+	void fbx_mesh_simplifier::classify_vertices(bool is_border_locked) {
+		//walking the outgoing and incoming edge of every triangle around a manifold vertex visits each of its edges
+		//once in each direction : a border vertex has one border edge each way, a vertex in the middle of a seam has
+		//two outgoing seam edges (one per side). anything else is a corner or worse and stays put.
+		_vertex_kinds.assign(_positions->size(), LOCKED);
+		for (int vertex = 0; vertex < static_cast<int>(_positions->size()); ++vertex) {
+			if (_representatives[vertex] != vertex || _adjacency_offsets[vertex] == _adjacency_offsets[vertex + 1]) {
+				continue;
+			}
+
+			int border_out_count = 0;
+			int border_in_count = 0;
+			int seam_out_count = 0;
+			bool is_non_manifold = false;
+			for (int i = _adjacency_offsets[vertex]; i < _adjacency_offsets[vertex + 1]; ++i) {
+				const unsigned int* corners = &_indices[_adjacency[i] * 3];
+				int k = 0;
+				while (get_representative(corners[k]) != vertex) {
+					++k;
+				}
+				edge_kind out_kind = classify_edge(vertex, get_representative(corners[(k + 1) % 3]));
+				edge_kind in_kind = classify_edge(vertex, get_representative(corners[(k + 2) % 3]));
+				is_non_manifold = is_non_manifold || out_kind == NON_MANIFOLD_EDGE || in_kind == NON_MANIFOLD_EDGE;
+				border_out_count += (out_kind == BORDER_EDGE) ? 1 : 0;
+				border_in_count += (in_kind == BORDER_EDGE) ? 1 : 0;
+				seam_out_count += (out_kind == SEAM_EDGE) ? 1 : 0;
+			}
+
+			bool is_border = border_out_count > 0 || border_in_count > 0;
+			if (is_non_manifold || (is_border && seam_out_count > 0)) {
+				_vertex_kinds[vertex] = LOCKED;
+			}
+			else if (is_border) {
+				_vertex_kinds[vertex] = (!is_border_locked && border_out_count == 1 && border_in_count == 1) ? BORDER : LOCKED;
+			}
+			else if (seam_out_count > 0) {
+				_vertex_kinds[vertex] = (seam_out_count == 2) ? SEAM : LOCKED;
+			}
+			else {
+				_vertex_kinds[vertex] = MANIFOLD;
+			}
+		}
+	}
+
+	void fbx_mesh_simplifier::build_quadrics() {
+		const auto& positions = *_positions;
+		_quadrics.assign(positions.size(), quadric());
+
+		for (size_t i_triangle = 0; i_triangle < _indices.size() / 3; ++i_triangle) {
+			const unsigned int* corners = &_indices[i_triangle * 3];
+			int representatives[3] = { get_representative(corners[0]), get_representative(corners[1]), get_representative(corners[2]) };
+			const vec3& p0 = positions[representatives[0]];
+			const vec3& p1 = positions[representatives[1]];
+			const vec3& p2 = positions[representatives[2]];
+
+			vec3 area_normal = cross_product(p1 - p0, p2 - p0);
+			float area = 0.5f * std::sqrt(dot_product(area_normal, area_normal));
+			if (area <= 0.f) {
+				continue;
+			}
+			vec3 normal = area_normal * (0.5f / area);
+			float distance = -dot_product(normal, p0);
+			for (int k = 0; k < 3; ++k) {
+				_quadrics[representatives[k]].add_plane(normal, distance, area);
+			}
+
+			//a plane through each constrained edge, perpendicular to the triangle, pulls collapses back onto the edge.
+			for (int k = 0; k < 3; ++k) {
+				int from = representatives[k];
+				int to = representatives[(k + 1) % 3];
+				edge_kind kind = classify_edge(from, to);
+				if (kind != BORDER_EDGE && kind != SEAM_EDGE) {
+					continue;
+				}
+				vec3 edge = positions[to] - positions[from];
+				vec3 edge_normal = normalized_or_zero(cross_product(edge, normal));
+				float edge_distance = -dot_product(edge_normal, positions[from]);
+				float weight = dot_product(edge, edge) * CONSTRAINED_EDGE_WEIGHT;
+				_quadrics[from].add_plane(edge_normal, edge_distance, weight);
+				_quadrics[to].add_plane(edge_normal, edge_distance, weight);
+			}
+		}
+	}
+
+	void fbx_mesh_simplifier::find_collapses() {
+		//the cheapest allowed collapse of every vertex, cheapest first.
+		const auto& positions = *_positions;
+		std::vector<collapse> best_collapses(positions.size());
+		for (auto& c : best_collapses) {
+			c._from = -1;
+			c._to = -1;
+			c._error = std::numeric_limits<float>::max();
+		}
+
+		for (size_t i_triangle = 0; i_triangle < _indices.size() / 3; ++i_triangle) {
+			const unsigned int* corners = &_indices[i_triangle * 3];
+			for (int k = 0; k < 3; ++k) {
+				int a = get_representative(corners[k]);
+				int b = get_representative(corners[(k + 1) % 3]);
+				for (int direction = 0; direction < 2; ++direction) {
+					int from = (direction == 0) ? a : b;
+					int to = (direction == 0) ? b : a;
+					if (!is_collapse_allowed(from, to)) {
+						continue;
+					}
+					quadric q = _quadrics[from];
+					q.add(_quadrics[to]);
+					float error = q.get_error(positions[to]);
+					if (error < best_collapses[from]._error) {
+						best_collapses[from]._from = from;
+						best_collapses[from]._to = to;
+						best_collapses[from]._error = error;
+					}
+				}
+			}
+		}
+
+		_collapses.clear();
+		for (const auto& c : best_collapses) {
+			if (c._from >= 0) {
+				_collapses.push_back(c);
+			}
+		}
+		std::sort(_collapses.begin(), _collapses.end(), [](const collapse& a, const collapse& b) {
+			return (a._error != b._error) ? (a._error < b._error) : (a._from < b._from);
+		});
+	}
+
+	bool fbx_mesh_simplifier::is_collapse_allowed(int from, int to) const {
+		switch (_vertex_kinds[from]) {
+		case MANIFOLD:
+			return true;
+		case BORDER:
+			return classify_edge(from, to) == BORDER_EDGE;
+		case SEAM:
+			return classify_edge(from, to) == SEAM_EDGE;
+		default:
+			return false;
+		}
+	}
+
+	bool fbx_mesh_simplifier::try_collapse(const collapse& c, int& removed_triangle_count) {
+		if (_is_locked_this_pass[c._from] || _is_locked_this_pass[c._to]) {
+			return false;
+		}
+		if (!is_link_condition_met(c._from, c._to) || has_flipped_triangles(c._from, c._to) || !find_wedge_remap(c._from, c._to, _wedge_remap)) {
+			return false;
+		}
+
+		for (const auto& wedge : _wedge_remap) {
+			_remap[wedge.first] = wedge.second;
+		}
+		_quadrics[c._to].add(_quadrics[c._from]);
+
+		//the triangles around from are about to change, nothing else may touch them until adjacency is rebuilt.
+		removed_triangle_count = 0;
+		for (int i = _adjacency_offsets[c._from]; i < _adjacency_offsets[c._from + 1]; ++i) {
+			const unsigned int* corners = &_indices[_adjacency[i] * 3];
+			bool has_to = false;
+			for (int k = 0; k < 3; ++k) {
+				int representative = get_representative(corners[k]);
+				_is_locked_this_pass[representative] = true;
+				has_to = has_to || (representative == c._to);
+			}
+			removed_triangle_count += has_to ? 1 : 0;
+		}
+		return true;
+	}
+
+	bool fbx_mesh_simplifier::has_flipped_triangles(int from, int to) const {
+		const auto& positions = *_positions;
+		for (int i = _adjacency_offsets[from]; i < _adjacency_offsets[from + 1]; ++i) {
+			const unsigned int* corners = &_indices[_adjacency[i] * 3];
+			vec3 old_positions[3];
+			vec3 new_positions[3];
+			bool has_to = false;
+			for (int k = 0; k < 3; ++k) {
+				int representative = get_representative(corners[k]);
+				has_to = has_to || (representative == to);
+				old_positions[k] = positions[representative];
+				new_positions[k] = (representative == from) ? positions[to] : old_positions[k];
+			}
+			if (has_to) {
+				continue; //collapses to nothing
+			}
+
+			//turning by more than ~75 degrees counts as a flip, smaller steps can still add up to one over many passes.
+			vec3 old_normal = cross_product(old_positions[1] - old_positions[0], old_positions[2] - old_positions[0]);
+			vec3 new_normal = cross_product(new_positions[1] - new_positions[0], new_positions[2] - new_positions[0]);
+			float max_turn = MIN_FLIP_COSINE * std::sqrt(dot_product(old_normal, old_normal) * dot_product(new_normal, new_normal));
+			if (dot_product(old_normal, new_normal) <= max_turn) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool fbx_mesh_simplifier::is_link_condition_met(int from, int to) {
+		//the only vertices adjacent to both ends of the edge may be the ones opposite it, otherwise the collapse
+		//pinches the surface into something non manifold.
+		int from_mark = ++_neighbor_mark;
+		int counted_mark = ++_neighbor_mark;
+		int shared_triangle_count = 0;
+		for (int i = _adjacency_offsets[from]; i < _adjacency_offsets[from + 1]; ++i) {
+			const unsigned int* corners = &_indices[_adjacency[i] * 3];
+			bool has_to = false;
+			for (int k = 0; k < 3; ++k) {
+				int representative = get_representative(corners[k]);
+				_neighbor_marks[representative] = from_mark;
+				has_to = has_to || (representative == to);
+			}
+			shared_triangle_count += has_to ? 1 : 0;
+		}
+
+		int shared_neighbor_count = 0;
+		for (int i = _adjacency_offsets[to]; i < _adjacency_offsets[to + 1]; ++i) {
+			const unsigned int* corners = &_indices[_adjacency[i] * 3];
+			for (int k = 0; k < 3; ++k) {
+				int representative = get_representative(corners[k]);
+				if (representative != from && representative != to && _neighbor_marks[representative] == from_mark) {
+					_neighbor_marks[representative] = counted_mark;
+					shared_neighbor_count++;
+				}
+			}
+		}
+		return shared_neighbor_count <= shared_triangle_count;
+	}
+
+	bool fbx_mesh_simplifier::find_wedge_remap(int from, int to, std::vector<std::pair<unsigned int, unsigned int>>& wedge_remap) const {
+		//every attribute copy at from moves onto the copy at to it shares a triangle with, so each side of a seam
+		//keeps its own uvs. a copy with no such triangle, or with two different candidates, can't move.
+		wedge_remap.clear();
+		for (int i = _adjacency_offsets[from]; i < _adjacency_offsets[from + 1]; ++i) {
+			const unsigned int* corners = &_indices[_adjacency[i] * 3];
+			unsigned int from_vertex = 0;
+			bool has_to = false;
+			unsigned int to_vertex = 0;
+			for (int k = 0; k < 3; ++k) {
+				int representative = get_representative(corners[k]);
+				if (representative == from) {
+					from_vertex = corners[k];
+				}
+				else if (representative == to) {
+					to_vertex = corners[k];
+					has_to = true;
+				}
+			}
+
+			auto existing = std::find_if(wedge_remap.begin(), wedge_remap.end(), [from_vertex](const std::pair<unsigned int, unsigned int>& wedge) {
+				return wedge.first == from_vertex;
+			});
+			if (existing == wedge_remap.end()) {
+				wedge_remap.push_back(std::make_pair(from_vertex, has_to ? to_vertex : from_vertex));
+			}
+			else if (has_to) {
+				if (existing->second == from_vertex) {
+					existing->second = to_vertex;
+				}
+				else if (existing->second != to_vertex) {
+					return false;
+				}
+			}
+		}
+
+		for (const auto& wedge : wedge_remap) {
+			if (wedge.first == wedge.second) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	int fbx_mesh_simplifier::compact_triangles() {
+		size_t write_triangle = 0;
+		for (size_t read_triangle = 0; read_triangle < _indices.size() / 3; ++read_triangle) {
+			unsigned int corners[3];
+			for (int k = 0; k < 3; ++k) {
+				unsigned int vertex = _indices[read_triangle * 3 + k];
+				while (_remap[vertex] != static_cast<int>(vertex)) {
+					vertex = static_cast<unsigned int>(_remap[vertex]);
+				}
+				corners[k] = vertex;
+			}
+
+			int r0 = get_representative(corners[0]);
+			int r1 = get_representative(corners[1]);
+			int r2 = get_representative(corners[2]);
+			if (r0 == r1 || r1 == r2 || r2 == r0) {
+				continue;
+			}
+
+			for (int k = 0; k < 3; ++k) {
+				_indices[write_triangle * 3 + k] = corners[k];
+			}
+			_material_indices[write_triangle] = _material_indices[read_triangle];
+			write_triangle++;
+		}
+
+		_indices.resize(write_triangle * 3);
+		_material_indices.resize(write_triangle);
+		return static_cast<int>(write_triangle);
+	}
+
+	int fbx_mesh_simplifier::get_representative(unsigned int index) const {
+		return _representatives[index];
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include "solar/math/vec3.h"
+
+namespace solar {
+
+	//quadric error edge collapse simplification (Garland, Heckbert, "Surface Simplification Using Quadric Error
+	//Metrics"), as half edge collapses so every output index refers to an input vertex and LODs can share one
+	//vertex buffer.
+	//
+	//vertices at the same position are treated as one point whose attribute copies (wedges) move together. edges
+	//where those copies differ (uv seams), where materials change, or with a triangle on one side only (borders)
+	//are constrained : their vertices may only slide along them, so seams, material outlines and borders keep
+	//their shape and never tear. anything non manifold is locked in place.
+
+	class fbx_mesh_simplifier {
+	private:
+		enum vertex_kind : unsigned char {
+			MANIFOLD,
+			BORDER,
+			SEAM, //uv seam or material boundary
+			LOCKED
+		};
+
+		enum edge_kind : unsigned char {
+			INTERIOR_EDGE,
+			BORDER_EDGE,
+			SEAM_EDGE,
+			NON_MANIFOLD_EDGE
+		};
+
+		class quadric {
+		public:
+			double _a00, _a01, _a02, _a11, _a12, _a22;
+			double _b0, _b1, _b2;
+			double _c;
+			double _weight;
+
+		public:
+			quadric();
+			void add_plane(const vec3& normal, float distance, float weight);
+			void add(const quadric& rhs);
+			float get_error(const vec3& p) const; //weighted RMS distance of p to the planes
+		};
+
+		class collapse {
+		public:
+			int _from; //representative vertices
+			int _to;
+			float _error;
+		};
+
+		const std::vector<vec3>* _positions;
+		std::vector<int> _representatives; //per vertex, the first vertex at the same position
+		std::vector<int> _remap; //per vertex, the vertex it collapsed onto, itself while alive
+		std::vector<quadric> _quadrics; //per representative
+		std::vector<vertex_kind> _vertex_kinds; //per representative
+		std::vector<unsigned int> _indices;
+		std::vector<int> _material_indices;
+		std::vector<int> _adjacency_offsets; //per representative, the triangles using it
+		std::vector<int> _adjacency;
+		std::vector<collapse> _collapses;
+		std::vector<bool> _is_locked_this_pass;
+		std::vector<int> _neighbor_marks;
+		int _neighbor_mark;
+		std::vector<std::pair<unsigned int, unsigned int>> _wedge_remap;
+
+	public:
+		fbx_mesh_simplifier();
+
+		//simplifies down to target_triangle_count triangles or until the next collapse's quadric error would exceed
+		//max_error (mesh units). triangles keep their relative order and material. returns the largest quadric error
+		//of any collapse, an RMS estimate of how far the surface moved and not a bound on it.
+		float simplify(
+			const std::vector<vec3>& positions,
+			const std::vector<unsigned int>& indices,
+			const std::vector<int>& material_indices,
+			int target_triangle_count,
+			float max_error,
+			bool is_border_locked,
+			std::vector<unsigned int>& simplified_indices,
+			std::vector<int>& simplified_material_indices);
+
+	private:
+		void build_representatives();
+		void build_adjacency();
+		edge_kind classify_edge(int from, int to) const;
+		void classify_vertices(bool is_border_locked);
+		void build_quadrics();
+		void find_collapses();
+		bool is_collapse_allowed(int from, int to) const;
+		bool try_collapse(const collapse& c, int& removed_triangle_count);
+		bool has_flipped_triangles(int from, int to) const;
+		bool is_link_condition_met(int from, int to);
+		bool find_wedge_remap(int from, int to, std::vector<std::pair<unsigned int, unsigned int>>& wedge_remap) const;
+		int compact_triangles();
+		int get_representative(unsigned int index) const;
+	};
+
+}
\ No newline at end of file
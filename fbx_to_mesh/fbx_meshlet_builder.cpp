@@ -0,0 +1,236 @@
+#include "fbx_meshlet_builder.h"
+
+#include <algorithm>
+#include <cmath>
+#include "solar/utility/assert.h"
+
+//useful references
+//---
+//- Wihlidal, "Optimizing the Graphics Pipeline with Compute", GDC 2016 (cluster cone culling)
+
+namespace solar {
+
+	namespace {
+
+		//below this the normals spread over more than ~84 degrees from the axis and the cone would never cull.
+		const float MIN_CONE_DOT = 0.1f;
+
+		float dot_product(const vec3& a, const vec3& b) {
+			return a._x * b._x + a._y * b._y + a._z * b._z;
+		}
+
+		vec3 cross_product(const vec3& a, const vec3& b) {
+			return vec3(
+				a._y * b._z - a._z * b._y,
+				a._z * b._x - a._x * b._z,
+				a._x * b._y - a._y * b._x);
+		}
+
+		vec3 normalized_or_zero(const vec3& v) {
+			float length = std::sqrt(dot_product(v, v));
+			return (length > 0.f) ? v * (1.f / length) : vec3();
+		}
+
+		vec3 get_triangle_normal(const vec3& p0, const vec3& p1, const vec3& p2) {
+			return normalized_or_zero(cross_product(p1 - p0, p2 - p0));
+		}
+
+	}
+
+	void fbx_meshlet_builder::build(
+		const unsigned int* indices,
+		int triangle_count,
+		const std::vector<vec3>& positions,
+		std::vector<fbx_meshlet>& meshlets,
+		std::vector<unsigned int>& meshlet_vertices,
+		std::vector<unsigned char>& meshlet_triangles) {
+
+		int vertex_count = static_cast<int>(positions.size());
+		build_adjacency(indices, triangle_count, vertex_count);
+		_is_triangle_used.assign(triangle_count, false);
+		_local_vertex_indices.assign(vertex_count, -1);
+		_triangle_normals.resize(triangle_count);
+		for (int i_triangle = 0; i_triangle < triangle_count; ++i_triangle) {
+			const unsigned int* triangle_indices = &indices[i_triangle * 3];
+			_triangle_normals[i_triangle] = get_triangle_normal(positions[triangle_indices[0]], positions[triangle_indices[1]], positions[triangle_indices[2]]);
+		}
+
+		fbx_meshlet meshlet;
+		vec3 normal_sum;
+		auto begin_meshlet = [&]() {
+			meshlet = fbx_meshlet();
+			meshlet._submesh_index = 0;
+			meshlet._material_index = 0;
+			meshlet._vertex_begin = static_cast<int>(meshlet_vertices.size());
+			meshlet._vertex_count = 0;
+			meshlet._triangle_begin = static_cast<int>(meshlet_triangles.size() / 3);
+			meshlet._triangle_count = 0;
+			normal_sum = vec3();
+		};
+		auto end_meshlet = [&]() {
+			for (int i = 0; i < meshlet._vertex_count; ++i) {
+				_local_vertex_indices[meshlet_vertices[meshlet._vertex_begin + i]] = -1;
+			}
+			if (meshlet._triangle_count > 0) {
+				compute_bounds(meshlet, positions, meshlet_vertices, meshlet_triangles);
+				meshlets.push_back(meshlet);
+			}
+			begin_meshlet();
+		};
+
+		begin_meshlet();
+		int next_unused_triangle = 0;
+		for (int remaining_count = triangle_count; remaining_count > 0; --remaining_count) {
+			int i_triangle = -1;
+			if (meshlet._triangle_count > 0) {
+				i_triangle = find_next_triangle(indices, meshlet_vertices, meshlet._vertex_begin, normalized_or_zero(normal_sum));
+				if (i_triangle < 0 && meshlet._triangle_count >= MAX_TRIANGLE_COUNT / 4) {
+					end_meshlet(); //nothing connected is left, start over somewhere else instead of scattering this one.
+				}
+			}
+			if (i_triangle < 0) {
+				//the input is cache optimized, so the next unused triangle in order is usually close by.
+				while (_is_triangle_used[next_unused_triangle]) {
+					++next_unused_triangle;
+				}
+				i_triangle = next_unused_triangle;
+			}
+
+			const unsigned int* triangle_indices = &indices[i_triangle * 3];
+			if (meshlet._triangle_count == MAX_TRIANGLE_COUNT || meshlet._vertex_count + count_new_vertices(triangle_indices) > MAX_VERTEX_COUNT) {
+				end_meshlet();
+			}
+
+			for (int i = 0; i < 3; ++i) {
+				int& local_index = _local_vertex_indices[triangle_indices[i]];
+				if (local_index < 0) {
+					local_index = meshlet._vertex_count++;
+					meshlet_vertices.push_back(triangle_indices[i]);
+				}
+				meshlet_triangles.push_back(static_cast<unsigned char>(local_index));
+			}
+			++meshlet._triangle_count;
+			_is_triangle_used[i_triangle] = true;
+			normal_sum = normal_sum + _triangle_normals[i_triangle];
+		}
+		end_meshlet();
+	}
+
+	void fbx_meshlet_builder::build_adjacency(const unsigned int* indices, int triangle_count, int vertex_count) {
+		_adjacency_offsets.assign(vertex_count + 1, 0);
+		for (int i = 0; i < triangle_count * 3; ++i) {
+			ASSERT(static_cast<int>(indices[i]) < vertex_count);
+			++_adjacency_offsets[indices[i] + 1];
+		}
+		for (int i_vertex = 0; i_vertex < vertex_count; ++i_vertex) {
+			_adjacency_offsets[i_vertex + 1] += _adjacency_offsets[i_vertex];
+		}
+
+		_adjacency.resize(triangle_count * 3);
+		std::vector<int> fill_offsets(_adjacency_offsets.begin(), _adjacency_offsets.end() - 1);
+		for (int i = 0; i < triangle_count * 3; ++i) {
+			_adjacency[fill_offsets[indices[i]]++] = i / 3;
+		}
+	}
+
+	int fbx_meshlet_builder::find_next_triangle(const unsigned int* indices, const std::vector<unsigned int>& meshlet_vertices, int vertex_begin, const vec3& meshlet_normal) const {
+		int best_triangle = -1;
+		int best_new_vertex_count = 4;
+		float best_dot = 0.f;
+		for (size_t i = vertex_begin; i < meshlet_vertices.size(); ++i) {
+			unsigned int vertex = meshlet_vertices[i];
+			for (int i_adjacency = _adjacency_offsets[vertex]; i_adjacency < _adjacency_offsets[vertex + 1]; ++i_adjacency) {
+				int i_triangle = _adjacency[i_adjacency];
+				if (_is_triangle_used[i_triangle]) {
+					continue;
+				}
+				int new_vertex_count = count_new_vertices(&indices[i_triangle * 3]);
+				float dot = dot_product(_triangle_normals[i_triangle], meshlet_normal);
+				if (new_vertex_count < best_new_vertex_count || (new_vertex_count == best_new_vertex_count && dot > best_dot)) {
+					best_triangle = i_triangle;
+					best_new_vertex_count = new_vertex_count;
+					best_dot = dot;
+				}
+			}
+		}
+		return best_triangle;
+	}
+
+	int fbx_meshlet_builder::count_new_vertices(const unsigned int* triangle_indices) const {
+		int count = 0;
+		for (int i = 0; i < 3; ++i) {
+			bool is_repeated = (i > 0 && triangle_indices[i] == triangle_indices[0]) || (i > 1 && triangle_indices[i] == triangle_indices[1]);
+			if (!is_repeated && _local_vertex_indices[triangle_indices[i]] < 0) {
+				++count;
+			}
+		}
+		return count;
+	}
+
+	void fbx_meshlet_builder::compute_bounds(
+		fbx_meshlet& meshlet,
+		const std::vector<vec3>& positions,
+		const std::vector<unsigned int>& meshlet_vertices,
+		const std::vector<unsigned char>& meshlet_triangles) {
+
+		auto get_position = [&](int i_triangle, int i) -> const vec3& {
+			int local_index = meshlet_triangles[(meshlet._triangle_begin + i_triangle) * 3 + i];
+			return positions[meshlet_vertices[meshlet._vertex_begin + local_index]];
+		};
+
+		//sphere around the bounding box center, a little looser than minimal but cheap and stable.
+		vec3 min = positions[meshlet_vertices[meshlet._vertex_begin]];
+		vec3 max = min;
+		for (int i = 0; i < meshlet._vertex_count; ++i) {
+			const vec3& p = positions[meshlet_vertices[meshlet._vertex_begin + i]];
+			min = vec3(std::min(min._x, p._x), std::min(min._y, p._y), std::min(min._z, p._z));
+			max = vec3(std::max(max._x, p._x), std::max(max._y, p._y), std::max(max._z, p._z));
+		}
+		meshlet._center = (min + max) * 0.5f;
+		float radius_squared = 0.f;
+		for (int i = 0; i < meshlet._vertex_count; ++i) {
+			vec3 d = positions[meshlet_vertices[meshlet._vertex_begin + i]] - meshlet._center;
+			radius_squared = std::max(radius_squared, dot_product(d, d));
+		}
+		meshlet._radius = std::sqrt(radius_squared);
+
+		//normal cone, the axis is the average normal and the cutoff is the sine of the widest angle to it.
+		vec3 normal_sum;
+		for (int i_triangle = 0; i_triangle < meshlet._triangle_count; ++i_triangle) {
+			normal_sum = normal_sum + get_triangle_normal(get_position(i_triangle, 0), get_position(i_triangle, 1), get_position(i_triangle, 2));
+		}
+		meshlet._cone_axis = normalized_or_zero(normal_sum);
+		meshlet._cone_apex = meshlet._center;
+		meshlet._cone_cutoff = 1.f;
+
+		float min_dot = 1.f;
+		bool has_normal = false;
+		for (int i_triangle = 0; i_triangle < meshlet._triangle_count; ++i_triangle) {
+			vec3 normal = get_triangle_normal(get_position(i_triangle, 0), get_position(i_triangle, 1), get_position(i_triangle, 2));
+			if (normal == vec3()) {
+				continue; //degenerate triangles are never visible
+			}
+			has_normal = true;
+			min_dot = std::min(min_dot, dot_product(normal, meshlet._cone_axis));
+		}
+		if (!has_normal || min_dot <= MIN_CONE_DOT) {
+			return;
+		}
+
+		//move the apex back along the axis until it is behind every triangle's plane, so the cone test is
+		//conservative for cameras anywhere, not just far away.
+		float max_t = 0.f;
+		for (int i_triangle = 0; i_triangle < meshlet._triangle_count; ++i_triangle) {
+			const vec3& p0 = get_position(i_triangle, 0);
+			vec3 normal = get_triangle_normal(p0, get_position(i_triangle, 1), get_position(i_triangle, 2));
+			if (normal == vec3()) {
+				continue;
+			}
+			float t = dot_product(meshlet._center - p0, normal) / dot_product(meshlet._cone_axis, normal);
+			max_t = std::max(max_t, t);
+		}
+		meshlet._cone_apex = meshlet._center - meshlet._cone_axis * max_t;
+		meshlet._cone_cutoff = std::sqrt(1.f - min_dot * min_dot);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include "solar/math/vec3.h"
+
+namespace solar {
+
+	//a small cluster of triangles with its own culling bounds. its vertices are a list of indices into the mesh
+	//(same convention as fbx_output_mesh::_indices) and its triangles index that list, so a GPU can fetch a meshlet
+	//without touching the rest of the mesh.
+	class fbx_meshlet {
+	public:
+		int _submesh_index;
+		int _material_index;
+		int _vertex_begin; //into the meshlet vertex list
+		int _vertex_count;
+		int _triangle_begin; //into the meshlet triangle list, 3 local indices per triangle
+		int _triangle_count;
+		vec3 _center; //bounding sphere
+		float _radius;
+		vec3 _cone_apex; //every triangle faces away from a camera at c when dot(normalize(_cone_apex - c), _cone_axis) >= _cone_cutoff
+		vec3 _cone_axis;
+		float _cone_cutoff; //1 when the normals spread too far to ever cull
+	};
+
+	//partitions a range of triangles into meshlets of at most MAX_VERTEX_COUNT vertices and MAX_TRIANGLE_COUNT
+	//triangles. meshlets grow across shared edges, preferring triangles that add the fewest vertices and then
+	//those facing the same way, so they stay connected and their normal cones stay narrow.
+	//
+	//indices are front facing when (p1 - p0) x (p2 - p0) points out of the surface.
+
+	class fbx_meshlet_builder {
+	public:
+		static const int MAX_VERTEX_COUNT = 64;
+		static const int MAX_TRIANGLE_COUNT = 124; //keeps a meshlet's local indices in 124 * 3 bytes, a multiple of 4
+
+	private:
+		std::vector<int> _adjacency_offsets; //per vertex, the triangles using it
+		std::vector<int> _adjacency;
+		std::vector<bool> _is_triangle_used;
+		std::vector<int> _local_vertex_indices; //per vertex, its index in the open meshlet or -1
+		std::vector<vec3> _triangle_normals;
+
+	public:
+		//appends the meshlets of triangle_count triangles starting at indices. _submesh_index and _material_index
+		//are left for the caller.
+		void build(
+			const unsigned int* indices,
+			int triangle_count,
+			const std::vector<vec3>& positions,
+			std::vector<fbx_meshlet>& meshlets,
+			std::vector<unsigned int>& meshlet_vertices,
+			std::vector<unsigned char>& meshlet_triangles);
+
+	private:
+		void build_adjacency(const unsigned int* indices, int triangle_count, int vertex_count);
+		int find_next_triangle(const unsigned int* indices, const std::vector<unsigned int>& meshlet_vertices, int vertex_begin, const vec3& meshlet_normal) const;
+		int count_new_vertices(const unsigned int* triangle_indices) const;
+		static void compute_bounds(
+			fbx_meshlet& meshlet,
+			const std::vector<vec3>& positions,
+			const std::vector<unsigned int>& meshlet_vertices,
+			const std::vector<unsigned char>& meshlet_triangles);
+	};
+
+}
\ No newline at end of file
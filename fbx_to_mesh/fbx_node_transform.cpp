@@ -0,0 +1,136 @@
+#include "fbx_node_transform.h"
+
+#include <cmath>
+#include "fbx_coordinate_converter.h"
+
+namespace solar {
+
+	namespace {
+
+		void normalize_or_keep(double* v) {
+			double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+			if (length > 0.0) {
+				v[0] /= length;
+				v[1] /= length;
+				v[2] /= length;
+			}
+		}
+
+	}
+
+	fbx_node_transform::fbx_node_transform()
+		: _is_identity(true)
+		, _is_mirrored(false) {
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 3; ++c) {
+				_linear[r][c] = (r == c) ? 1.0 : 0.0;
+				_normal_matrix[r][c] = _linear[r][c];
+			}
+			_translation[r] = 0.0;
+		}
+	}
+
+	fbx_node_transform::fbx_node_transform(const FbxAMatrix& matrix) {
+		//compared exactly, so the vertices of untransformed nodes stay bit identical.
+		_is_identity = true;
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 3; ++c) {
+				_linear[r][c] = matrix.Get(r, c);
+				_is_identity = _is_identity && (_linear[r][c] == ((r == c) ? 1.0 : 0.0));
+			}
+			_translation[r] = matrix.Get(3, r);
+			_is_identity = _is_identity && (_translation[r] == 0.0);
+		}
+
+		const auto& m = _linear;
+		double cofactors[3][3];
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 3; ++c) {
+				int r0 = (r + 1) % 3, r1 = (r + 2) % 3;
+				int c0 = (c + 1) % 3, c1 = (c + 2) % 3;
+				cofactors[r][c] = m[r0][c0] * m[r1][c1] - m[r0][c1] * m[r1][c0];
+			}
+		}
+		double determinant = m[0][0] * cofactors[0][0] + m[0][1] * cofactors[0][1] + m[0][2] * cofactors[0][2];
+		_is_mirrored = determinant < 0.0;
+
+		//the inverse is the transposed cofactors over the determinant, so its transpose is the cofactors. normals are
+		//renormalized anyway, only the sign of the determinant matters.
+		double sign = (determinant < 0.0) ? -1.0 : 1.0;
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 3; ++c) {
+				_normal_matrix[r][c] = cofactors[r][c] * sign;
+			}
+		}
+	}
+
+	fbx_node_transform fbx_node_transform::make_global(FbxNode* node) {
+		FbxAMatrix geometric(
+			node->GetGeometricTranslation(FbxNode::eSourcePivot),
+			node->GetGeometricRotation(FbxNode::eSourcePivot),
+			node->GetGeometricScaling(FbxNode::eSourcePivot));
+		return fbx_node_transform(node->EvaluateGlobalTransform() * geometric);
+	}
+
+	bool fbx_node_transform::is_identity() const {
+		return _is_identity;
+	}
+
+	bool fbx_node_transform::is_mirrored() const {
+		return _is_mirrored;
+	}
+
+	void fbx_node_transform::transform_values(const double* values, int count, value_kind kind, double* out) const {
+		const auto& m = (kind == NORMAL) ? _normal_matrix : _linear;
+		for (int i = 0; i < count; ++i) {
+			const double* v = values + i * 4;
+			double* o = out + i * 4;
+			for (int c = 0; c < 3; ++c) {
+				o[c] = v[0] * m[0][c] + v[1] * m[1][c] + v[2] * m[2][c];
+			}
+			if (kind == POINT) {
+				o[0] += _translation[0];
+				o[1] += _translation[1];
+				o[2] += _translation[2];
+			}
+			else {
+				normalize_or_keep(o);
+			}
+			o[3] = v[3];
+		}
+	}
+
+	void fbx_node_transform::get_converted_rows(vec3& x_axis, vec3& y_axis, vec3& z_axis, vec3& translation) const {
+		//the conversion c is a rotation (and a flip) so its inverse is its transpose. converted points are p * c, so
+		//the converted transform is c^T * _linear * c with the translation converted like a point.
+		double c[3][3];
+		for (int r = 0; r < 3; ++r) {
+			double axis[4] = { 0.0, 0.0, 0.0, 0.0 };
+			axis[r] = 1.0;
+			vec3 converted = fbx_coordinate_converter::convert_vec3(axis);
+			c[r][0] = converted._x;
+			c[r][1] = converted._y;
+			c[r][2] = converted._z;
+		}
+
+		double linear_c[3][3];
+		for (int r = 0; r < 3; ++r) {
+			for (int col = 0; col < 3; ++col) {
+				linear_c[r][col] = _linear[r][0] * c[0][col] + _linear[r][1] * c[1][col] + _linear[r][2] * c[2][col];
+			}
+		}
+
+		vec3* rows[3] = { &x_axis, &y_axis, &z_axis };
+		for (int r = 0; r < 3; ++r) {
+			double row[3];
+			for (int col = 0; col < 3; ++col) {
+				row[col] = c[0][r] * linear_c[0][col] + c[1][r] * linear_c[1][col] + c[2][r] * linear_c[2][col];
+			}
+			*rows[r] = vec3(static_cast<float>(row[0]), static_cast<float>(row[1]), static_cast<float>(row[2]));
+		}
+
+		double translation_w[4] = { _translation[0], _translation[1], _translation[2], 1.0 };
+		translation = fbx_coordinate_converter::convert_vec3(translation_w);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <fbxsdk.h>
+#include "solar/math/vec3.h"
+
+namespace solar {
+
+	//a mesh node's global transform (its geometric transform included), to bake into the node's vertices when the
+	//meshes of a scene are merged. applied in .fbx coordinates, before fbx_coordinate_converter.
+	//
+	//values are the raw doubles of FbxVector4 (4 per vector, w is copied as is). points get the full affine
+	//transform, directions the linear part and normals its inverse transpose, both renormalized. nodes that aren't
+	//transformed are detected so their values are passed through untouched.
+
+	class fbx_node_transform {
+	public:
+		enum value_kind {
+			POINT,
+			DIRECTION,
+			NORMAL
+		};
+
+	private:
+		bool _is_identity;
+		bool _is_mirrored;
+		double _linear[3][3]; //row vector convention like FbxAMatrix : p' = p * _linear + _translation
+		double _translation[3];
+		double _normal_matrix[3][3]; //inverse transpose of _linear, up to scale
+
+	public:
+		fbx_node_transform(); //identity
+		fbx_node_transform(const FbxAMatrix& matrix);
+
+		static fbx_node_transform make_global(FbxNode* node);
+
+		bool is_identity() const;
+		bool is_mirrored() const; //negative determinant, triangles must be flipped to keep facing the same way
+
+		void transform_values(const double* values, int count, value_kind kind, double* out) const;
+
+		//the same transform for values already converted by fbx_coordinate_converter, as the rows of the linear part
+		//and the translation : p' = p._x * x_axis + p._y * y_axis + p._z * z_axis + translation.
+		void get_converted_rows(vec3& x_axis, vec3& y_axis, vec3& z_axis, vec3& translation) const;
+	};
+
+}
\ No newline at end of file
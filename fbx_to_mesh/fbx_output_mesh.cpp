@@ -0,0 +1,472 @@
+#include "fbx_output_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "solar/utility/assert.h"
+#include "solar/utility/type_convert.h"
+#include "solar/archiving/archive_writer_helpers.h"
+
+namespace solar {
+
+	fbx_output_mesh::fbx_output_mesh()
+		: _index_size(4)
+		, _position_stream_index_size(4) {
+	}
+
+	int fbx_output_mesh::get_triangle_count() const {
+		return static_cast<int>(_material_indices.size());
+	}
+
+	uint64_t fbx_output_mesh::get_geometry_bytes() const {
+		uint64_t vertex_bytes = is_packed() ?
+			_packed_vertices.size() * sizeof(fbx_packed_vertex) :
+			_vertices.size() * sizeof(fbx_polygon_vertex_data);
+		return
+			vertex_bytes +
+			_indices.size() * static_cast<uint64_t>(_index_size) +
+			_position_stream.size() * sizeof(vec3) +
+			_position_stream_indices.size() * static_cast<uint64_t>(_position_stream_index_size);
+	}
+
+	void fbx_output_mesh::set_single_submesh(int index_size) {
+		ASSERT(index_size == 2 || index_size == 4);
+		fbx_output_submesh submesh;
+		submesh._vertex_begin = 0;
+		submesh._vertex_count = static_cast<int>(_vertices.size());
+		submesh._triangle_begin = 0;
+		submesh._triangle_count = get_triangle_count();
+		_submeshes.assign(1, submesh);
+		_index_size = index_size;
+	}
+
+	int fbx_output_mesh::split_into_16_bit_submeshes(int max_vertex_count) {
+		ASSERT(_submeshes.size() == 1 && _submeshes[0]._vertex_begin == 0);
+		ASSERT(max_vertex_count >= 3 && max_vertex_count <= MAX_16_BIT_VERTEX_COUNT);
+
+		std::vector<int> cuts;
+		find_submesh_cuts(max_vertex_count, cuts);
+		cuts.push_back(get_triangle_count());
+
+		std::vector<fbx_polygon_vertex_data> split_vertices;
+		split_vertices.reserve(_vertices.size());
+		std::vector<int> vertex_submesh_indices(_vertices.size(), -1);
+		std::vector<int> vertex_local_indices(_vertices.size());
+		int used_vertex_count = 0;
+
+		_submeshes.clear();
+		for (size_t i_submesh = 0; i_submesh + 1 < cuts.size(); ++i_submesh) {
+			fbx_output_submesh submesh;
+			submesh._vertex_begin = static_cast<int>(split_vertices.size());
+			submesh._triangle_begin = cuts[i_submesh];
+			submesh._triangle_count = cuts[i_submesh + 1] - cuts[i_submesh];
+
+			//local indices are assigned in first use order, which keeps the vertex fetch order of the input.
+			for (int i = submesh._triangle_begin * 3; i < (submesh._triangle_begin + submesh._triangle_count) * 3; ++i) {
+				unsigned int vertex_index = _indices[i];
+				if (vertex_submesh_indices[vertex_index] != static_cast<int>(i_submesh)) {
+					if (vertex_submesh_indices[vertex_index] < 0) {
+						used_vertex_count++;
+					}
+					vertex_submesh_indices[vertex_index] = static_cast<int>(i_submesh);
+					vertex_local_indices[vertex_index] = static_cast<int>(split_vertices.size()) - submesh._vertex_begin;
+					split_vertices.push_back(_vertices[vertex_index]);
+				}
+				_indices[i] = static_cast<unsigned int>(vertex_local_indices[vertex_index]);
+			}
+
+			submesh._vertex_count = static_cast<int>(split_vertices.size()) - submesh._vertex_begin;
+			ASSERT(submesh._vertex_count <= max_vertex_count);
+			_submeshes.push_back(submesh);
+		}
+
+		_vertices.swap(split_vertices);
+		_index_size = 2;
+		return static_cast<int>(_vertices.size()) - used_vertex_count;
+	}
+
+	void fbx_output_mesh::find_submesh_cuts(int max_vertex_count, std::vector<int>& cuts) const {
+		//greedy, a submesh takes triangles in order until the next one would not fit. the order is already vertex
+		//cache optimized so triangles close in the order share vertices and few end up duplicated.
+		//
+		//cutting at a material change or where the cache optimizer started a disjoint patch (a triangle sharing
+		//no vertex with the submesh so far) duplicates even fewer, so the cut moves back to the last such
+		//boundary unless that would waste more than a quarter of the submesh.
+		std::vector<int> vertex_submesh_indices(_vertices.size(), -1);
+		int submesh_index = 0;
+		int submesh_begin = 0;
+		int submesh_vertex_count = 0;
+		int last_boundary = 0;
+
+		cuts.clear();
+		cuts.push_back(0);
+
+		int triangle_count = get_triangle_count();
+		for (int i_triangle = 0; i_triangle < triangle_count;) {
+			const unsigned int* triangle_indices = &_indices[i_triangle * 3];
+			int new_vertex_count = 0;
+			for (int k = 0; k < 3; ++k) {
+				bool is_repeated_in_triangle = (k > 0 && triangle_indices[k] == triangle_indices[0]) || (k > 1 && triangle_indices[k] == triangle_indices[1]);
+				if (!is_repeated_in_triangle && vertex_submesh_indices[triangle_indices[k]] != submesh_index) {
+					new_vertex_count++;
+				}
+			}
+
+			if (i_triangle > submesh_begin && (new_vertex_count == 3 || _material_indices[i_triangle] != _material_indices[i_triangle - 1])) {
+				last_boundary = i_triangle;
+			}
+
+			if (submesh_vertex_count + new_vertex_count > max_vertex_count) {
+				int cut = i_triangle;
+				if (last_boundary > submesh_begin && (i_triangle - last_boundary) * 4 <= (i_triangle - submesh_begin)) {
+					cut = last_boundary;
+				}
+				cuts.push_back(cut);
+				submesh_index++;
+				submesh_begin = cut;
+				submesh_vertex_count = 0;
+				last_boundary = cut;
+				i_triangle = cut;
+				continue;
+			}
+
+			for (int k = 0; k < 3; ++k) {
+				if (vertex_submesh_indices[triangle_indices[k]] != submesh_index) {
+					vertex_submesh_indices[triangle_indices[k]] = submesh_index;
+					submesh_vertex_count++;
+				}
+			}
+			++i_triangle;
+		}
+	}
+
+	void fbx_output_mesh::build_draw_ranges() {
+		build_draw_ranges(_submeshes, _material_indices, _draw_ranges);
+		for (auto& lod : _lods) {
+			build_draw_ranges(lod._submeshes, lod._material_indices, lod._draw_ranges);
+		}
+	}
+
+	void fbx_output_mesh::build_draw_ranges(
+		const std::vector<fbx_output_submesh>& submeshes,
+		const std::vector<int>& material_indices,
+		std::vector<fbx_output_draw_range>& draw_ranges) {
+
+		//one per run of triangles sharing a material, a run never crosses into the next submesh.
+		draw_ranges.clear();
+		for (int i_submesh = 0; i_submesh < static_cast<int>(submeshes.size()); ++i_submesh) {
+			const auto& submesh = submeshes[i_submesh];
+			for (int i_triangle = submesh._triangle_begin; i_triangle < submesh._triangle_begin + submesh._triangle_count; ++i_triangle) {
+				if (i_triangle == submesh._triangle_begin || draw_ranges.back()._material_index != material_indices[i_triangle]) {
+					fbx_output_draw_range draw_range;
+					draw_range._submesh_index = i_submesh;
+					draw_range._material_index = material_indices[i_triangle];
+					draw_range._triangle_begin = i_triangle;
+					draw_range._triangle_count = 0;
+					draw_ranges.push_back(draw_range);
+				}
+				draw_ranges.back()._triangle_count++;
+			}
+		}
+	}
+
+	fbx_vertex_packer::error_bounds fbx_output_mesh::pack_vertices() {
+		fbx_vertex_packer packer;
+		packer.pack(_vertices, _packed_vertices);
+		_packed_position_min = packer.get_position_min();
+		_packed_position_extent = packer.get_position_extent();
+		return packer.measure_error_bounds(_vertices, _packed_vertices);
+	}
+
+	bool fbx_output_mesh::is_packed() const {
+		return !_packed_vertices.empty();
+	}
+
+	void fbx_output_mesh::compute_bounds() {
+		//box first, then the sphere around its center. not minimal but stable and what the runtime culled with before.
+		auto add_position = [](fbx_output_bounds& bounds, bool is_first, const vec3& p) {
+			bounds._min = is_first ? p : vec3(std::min(bounds._min._x, p._x), std::min(bounds._min._y, p._y), std::min(bounds._min._z, p._z));
+			bounds._max = is_first ? p : vec3(std::max(bounds._max._x, p._x), std::max(bounds._max._y, p._y), std::max(bounds._max._z, p._z));
+		};
+		auto add_radius = [](fbx_output_bounds& bounds, const vec3& p) {
+			vec3 d = p - bounds._center;
+			bounds._radius = std::max(bounds._radius, std::sqrt(d._x * d._x + d._y * d._y + d._z * d._z));
+		};
+
+		_bounds = fbx_output_bounds();
+		_material_bounds.assign(_materials.size(), fbx_output_bounds());
+		std::vector<bool> is_material_empty(_materials.size(), true);
+
+		for (size_t i_vertex = 0; i_vertex < _vertices.size(); ++i_vertex) {
+			add_position(_bounds, i_vertex == 0, _vertices[i_vertex]._position);
+		}
+		for (const auto& submesh : _submeshes) {
+			for (int i_triangle = submesh._triangle_begin; i_triangle < submesh._triangle_begin + submesh._triangle_count; ++i_triangle) {
+				int material_index = _material_indices[i_triangle];
+				for (int i = 0; i < 3; ++i) {
+					add_position(_material_bounds[material_index], is_material_empty[material_index], _vertices[submesh._vertex_begin + _indices[i_triangle * 3 + i]]._position);
+					is_material_empty[material_index] = false;
+				}
+			}
+		}
+
+		_bounds._center = (_bounds._min + _bounds._max) * 0.5f;
+		for (const auto& vertex : _vertices) {
+			add_radius(_bounds, vertex._position);
+		}
+		for (auto& bounds : _material_bounds) {
+			bounds._center = (bounds._min + bounds._max) * 0.5f;
+		}
+		for (const auto& submesh : _submeshes) {
+			for (int i_triangle = submesh._triangle_begin; i_triangle < submesh._triangle_begin + submesh._triangle_count; ++i_triangle) {
+				for (int i = 0; i < 3; ++i) {
+					add_radius(_material_bounds[_material_indices[i_triangle]], _vertices[submesh._vertex_begin + _indices[i_triangle * 3 + i]]._position);
+				}
+			}
+		}
+	}
+
+	void fbx_output_mesh::build_bvh() {
+		std::vector<vec3> positions;
+		std::vector<unsigned int> indices;
+		get_positions(positions);
+		get_absolute_indices(indices);
+		_bvh.build(positions, indices);
+	}
+
+	void fbx_output_mesh::get_positions(std::vector<vec3>& positions) const {
+		positions.clear();
+		positions.reserve(_vertices.size());
+		for (const auto& vertex : _vertices) {
+			positions.push_back(vertex._position);
+		}
+	}
+
+	void fbx_output_mesh::get_absolute_indices(std::vector<unsigned int>& indices) const {
+		indices.resize(_indices.size());
+		for (const auto& submesh : _submeshes) {
+			for (int i = submesh._triangle_begin * 3; i < (submesh._triangle_begin + submesh._triangle_count) * 3; ++i) {
+				indices[i] = _indices[i] + static_cast<unsigned int>(submesh._vertex_begin);
+			}
+		}
+	}
+
+	bool fbx_output_mesh::is_mesh_def_compatible() const {
+		return
+			_index_size == 2 &&
+			_submeshes.size() == 1 &&
+			static_cast<int>(_vertices.size()) <= MAX_16_BIT_VERTEX_COUNT &&
+			!is_packed() &&
+			_lods.empty() &&
+			_meshlets.empty() &&
+			_bvh.empty() &&
+			_position_stream.empty() &&
+			_instanced_meshes.empty();
+	}
+
+	std::shared_ptr<mesh_def> fbx_output_mesh::make_mesh_def() const {
+		ASSERT(is_mesh_def_compatible());
+		auto md = std::make_shared<mesh_def>();
+
+		md->_materials = _materials;
+		md->_triangles.reserve(get_triangle_count());
+		md->_vertices.reserve(_vertices.size());
+
+		for (int i_triangle = 0; i_triangle < get_triangle_count(); ++i_triangle) {
+			mesh_triangle tri;
+			tri._vertex_index_0 = int_to_ushort(_indices[i_triangle * 3 + 0]);
+			tri._vertex_index_1 = int_to_ushort(_indices[i_triangle * 3 + 1]);
+			tri._vertex_index_2 = int_to_ushort(_indices[i_triangle * 3 + 2]);
+			tri._material_index = int_to_ushort(_material_indices[i_triangle]);
+			md->_triangles.push_back(tri);
+		}
+
+		for (const auto& vertex : _vertices) {
+			mesh_vertex mesh_vertex;
+			mesh_vertex._position = vertex._position;
+			mesh_vertex._normal = vertex._normal;
+			mesh_vertex._tangent = vertex._tangent;
+			mesh_vertex._uv = vertex._uv;
+			md->_vertices.push_back(mesh_vertex);
+		}
+
+		return md;
+	}
+
+	void fbx_output_mesh::write_to_archive(archive_writer& writer) const {
+		make_mesh_def()->write_to_archive(writer);
+	}
+
+	void fbx_output_mesh::write_layout_to_archive(archive_writer& writer) const {
+		//streamed straight from the mesh's arrays, nothing is copied into an intermediate mesh first. only the top
+		//level gets the magic, nested instanced meshes start at format_version.
+		writer.write_uint("layout_magic", FORMAT_MAGIC);
+		write_layout(writer);
+	}
+
+	void fbx_output_mesh::write_layout(archive_writer& writer) const {
+		writer.write_uint("format_version", FORMAT_VERSION);
+
+		auto write_bounds = [](archive_writer& writer, const fbx_output_bounds& bounds) {
+			write_vec3(writer, "bounds_min", bounds._min);
+			write_vec3(writer, "bounds_max", bounds._max);
+			write_vec3(writer, "bounds_center", bounds._center);
+			writer.write_float("bounds_radius", bounds._radius);
+		};
+		write_bounds(writer, _bounds);
+
+		writer.write_objects("materials", static_cast<unsigned int>(_materials.size()), [this, &write_bounds](archive_writer& writer, unsigned int i) {
+			writer.write_string("diffuse_map", _materials[i]._diffuse_map);
+			writer.write_string("normal_map", _materials[i]._normal_map);
+			write_bounds(writer, _material_bounds[i]);
+		});
+
+		//0 is full float vertices, otherwise the fbx_vertex_packer version the vertices are packed with.
+		writer.write_uint("vertex_format", is_packed() ? fbx_vertex_packer::FORMAT_VERSION : 0);
+		if (is_packed()) {
+			write_vec3(writer, "position_min", _packed_position_min);
+			write_vec3(writer, "position_extent", _packed_position_extent);
+			writer.write_objects("vertices", static_cast<unsigned int>(_packed_vertices.size()), [this](archive_writer& writer, unsigned int i) {
+				const auto& vertex = _packed_vertices[i];
+				uint32_t normal_tangent;
+				std::memcpy(&normal_tangent, vertex._normal_tangent, sizeof(normal_tangent));
+				writer.write_ushort("position_x", vertex._position[0]);
+				writer.write_ushort("position_y", vertex._position[1]);
+				writer.write_ushort("position_z", vertex._position[2]);
+				writer.write_ushort("position_w", vertex._position[3]);
+				writer.write_uint("normal_tangent", normal_tangent);
+				writer.write_ushort("uv_u", vertex._uv[0]);
+				writer.write_ushort("uv_v", vertex._uv[1]);
+			});
+		}
+		else {
+			writer.write_objects("vertices", static_cast<unsigned int>(_vertices.size()), [this](archive_writer& writer, unsigned int i) {
+				write_vec3(writer, "position", _vertices[i]._position);
+				write_vec3(writer, "normal", _vertices[i]._normal);
+				write_vec3(writer, "tangent", _vertices[i]._tangent);
+				writer.write_float("tangent_sign", _vertices[i]._tangent_sign);
+				write_uv(writer, "uv", _vertices[i]._uv);
+			});
+		}
+
+		writer.write_uint("index_size", static_cast<unsigned int>(_index_size));
+
+		write_submeshes_and_triangles(writer, _submeshes, _draw_ranges, _indices, _material_indices);
+
+		writer.write_objects("lods", static_cast<unsigned int>(_lods.size()), [this](archive_writer& writer, unsigned int i) {
+			const auto& lod = _lods[i];
+			writer.write_float("error", lod._error);
+			writer.write_float("relative_error", lod._relative_error);
+			write_submeshes_and_triangles(writer, lod._submeshes, lod._draw_ranges, lod._indices, lod._material_indices);
+		});
+
+		write_meshlets(writer);
+		write_bvh(writer);
+		write_position_stream(writer);
+
+		//instanced meshes are written with the same layout, nested, even when mesh_def could represent them.
+		writer.write_objects("instanced_meshes", static_cast<unsigned int>(_instanced_meshes.size()), [this](archive_writer& writer, unsigned int i) {
+			const auto& instanced_mesh = _instanced_meshes[i];
+			writer.write_objects("transforms", static_cast<unsigned int>(instanced_mesh._transforms.size()), [&instanced_mesh](archive_writer& transform_writer, unsigned int i_transform) {
+				const auto& transform = instanced_mesh._transforms[i_transform];
+				write_vec3(transform_writer, "x_axis", transform._x_axis);
+				write_vec3(transform_writer, "y_axis", transform._y_axis);
+				write_vec3(transform_writer, "z_axis", transform._z_axis);
+				write_vec3(transform_writer, "translation", transform._translation);
+			});
+			instanced_mesh._mesh->write_layout(writer);
+		});
+	}
+
+	void fbx_output_mesh::write_position_stream(archive_writer& writer) const {
+		writer.write_uint("position_stream_index_size", static_cast<unsigned int>(_position_stream_index_size));
+		writer.write_objects("position_stream", static_cast<unsigned int>(_position_stream.size()), [this](archive_writer& writer, unsigned int i) {
+			write_vec3(writer, "position", _position_stream[i]);
+		});
+		writer.write_objects("position_stream_triangles", static_cast<unsigned int>(_position_stream_indices.size() / 3), [this](archive_writer& writer, unsigned int i) {
+			if (_position_stream_index_size == 2) {
+				writer.write_ushort("vertex_index_0", int_to_ushort(_position_stream_indices[i * 3 + 0]));
+				writer.write_ushort("vertex_index_1", int_to_ushort(_position_stream_indices[i * 3 + 1]));
+				writer.write_ushort("vertex_index_2", int_to_ushort(_position_stream_indices[i * 3 + 2]));
+			}
+			else {
+				writer.write_uint("vertex_index_0", _position_stream_indices[i * 3 + 0]);
+				writer.write_uint("vertex_index_1", _position_stream_indices[i * 3 + 1]);
+				writer.write_uint("vertex_index_2", _position_stream_indices[i * 3 + 2]);
+			}
+		});
+	}
+
+	void fbx_output_mesh::write_submeshes_and_triangles(
+		archive_writer& writer,
+		const std::vector<fbx_output_submesh>& submeshes,
+		const std::vector<fbx_output_draw_range>& draw_ranges,
+		const std::vector<unsigned int>& indices,
+		const std::vector<int>& material_indices) const {
+
+		writer.write_objects("submeshes", static_cast<unsigned int>(submeshes.size()), [&submeshes](archive_writer& writer, unsigned int i) {
+			writer.write_uint("vertex_begin", static_cast<unsigned int>(submeshes[i]._vertex_begin));
+			writer.write_uint("vertex_count", static_cast<unsigned int>(submeshes[i]._vertex_count));
+			writer.write_uint("triangle_begin", static_cast<unsigned int>(submeshes[i]._triangle_begin));
+			writer.write_uint("triangle_count", static_cast<unsigned int>(submeshes[i]._triangle_count));
+		});
+
+		writer.write_objects("draw_ranges", static_cast<unsigned int>(draw_ranges.size()), [&draw_ranges](archive_writer& writer, unsigned int i) {
+			writer.write_uint("submesh_index", static_cast<unsigned int>(draw_ranges[i]._submesh_index));
+			writer.write_uint("material_index", static_cast<unsigned int>(draw_ranges[i]._material_index));
+			writer.write_uint("triangle_begin", static_cast<unsigned int>(draw_ranges[i]._triangle_begin));
+			writer.write_uint("triangle_count", static_cast<unsigned int>(draw_ranges[i]._triangle_count));
+		});
+
+		writer.write_objects("triangles", static_cast<unsigned int>(material_indices.size()), [this, &indices, &material_indices](archive_writer& writer, unsigned int i) {
+			if (_index_size == 2) {
+				writer.write_ushort("vertex_index_0", int_to_ushort(indices[i * 3 + 0]));
+				writer.write_ushort("vertex_index_1", int_to_ushort(indices[i * 3 + 1]));
+				writer.write_ushort("vertex_index_2", int_to_ushort(indices[i * 3 + 2]));
+			}
+			else {
+				writer.write_uint("vertex_index_0", indices[i * 3 + 0]);
+				writer.write_uint("vertex_index_1", indices[i * 3 + 1]);
+				writer.write_uint("vertex_index_2", indices[i * 3 + 2]);
+			}
+			writer.write_ushort("material_index", int_to_ushort(material_indices[i]));
+		});
+	}
+
+	void fbx_output_mesh::write_meshlets(archive_writer& writer) const {
+		writer.write_objects("meshlets", static_cast<unsigned int>(_meshlets.size()), [this](archive_writer& writer, unsigned int i) {
+			const auto& meshlet = _meshlets[i];
+			writer.write_uint("submesh_index", static_cast<unsigned int>(meshlet._submesh_index));
+			writer.write_ushort("material_index", int_to_ushort(meshlet._material_index));
+			write_vec3(writer, "center", meshlet._center);
+			writer.write_float("radius", meshlet._radius);
+			write_vec3(writer, "cone_apex", meshlet._cone_apex);
+			write_vec3(writer, "cone_axis", meshlet._cone_axis);
+			writer.write_float("cone_cutoff", meshlet._cone_cutoff);
+
+			writer.write_objects("vertices", static_cast<unsigned int>(meshlet._vertex_count), [this, &meshlet](archive_writer& writer, unsigned int i) {
+				writer.write_uint("vertex_index", _meshlet_vertices[meshlet._vertex_begin + i]);
+			});
+			writer.write_objects("triangles", static_cast<unsigned int>(meshlet._triangle_count), [this, &meshlet](archive_writer& writer, unsigned int i) {
+				const unsigned char* triangle = &_meshlet_triangles[(meshlet._triangle_begin + i) * 3];
+				writer.write_ushort("local_index_0", triangle[0]);
+				writer.write_ushort("local_index_1", triangle[1]);
+				writer.write_ushort("local_index_2", triangle[2]);
+			});
+		});
+	}
+
+	void fbx_output_mesh::write_bvh(archive_writer& writer) const {
+		writer.write_objects("bvh_nodes", static_cast<unsigned int>(_bvh._nodes.size()), [this](archive_writer& writer, unsigned int i) {
+			const auto& node = _bvh._nodes[i];
+			write_vec3(writer, "min", vec3(node._min[0], node._min[1], node._min[2]));
+			write_vec3(writer, "max", vec3(node._max[0], node._max[1], node._max[2]));
+			writer.write_uint("offset", node._offset);
+			writer.write_uint("count", node._count);
+		});
+		writer.write_objects("bvh_triangles", static_cast<unsigned int>(_bvh._triangle_indices.size()), [this](archive_writer& writer, unsigned int i) {
+			writer.write_uint("triangle_index", _bvh._triangle_indices[i]);
+		});
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "solar/rendering/meshes/mesh_def.h" //mesh_material
+#include "solar/archiving/archive_writer.h"
+#include "fbx_polygon_vertex_data.h"
+#include "fbx_vertex_packer.h"
+#include "fbx_meshlet_builder.h"
+#include "fbx_bvh.h"
+
+namespace solar {
+
+	//a contiguous part of fbx_output_mesh that is drawn with one base vertex. its indices are relative to
+	//_vertex_begin so each submesh of a 16 bit mesh can address up to MAX_16_BIT_VERTEX_COUNT vertices.
+	class fbx_output_submesh {
+	public:
+		int _vertex_begin;
+		int _vertex_count;
+		int _triangle_begin;
+		int _triangle_count;
+	};
+
+	//the triangles of one material within one submesh, what a single draw call covers. triangles are sorted by
+	//material so it's one range per material each submesh uses, stored so the runtime doesn't scan for them.
+	class fbx_output_draw_range {
+	public:
+		int _submesh_index;
+		int _material_index;
+		int _triangle_begin; //absolute, not submesh relative
+		int _triangle_count;
+	};
+
+	//a lower detail version of fbx_output_mesh drawn from the same vertices. the submeshes have the same vertex
+	//ranges as the mesh's and their own triangle ranges.
+	class fbx_output_lod {
+	public:
+		std::vector<unsigned int> _indices; //same convention as fbx_output_mesh::_indices
+		std::vector<int> _material_indices;
+		std::vector<fbx_output_submesh> _submeshes;
+		std::vector<fbx_output_draw_range> _draw_ranges;
+		float _error; //largest distance of a full detail vertex to this LOD's triangles, measured, in mesh units
+		float _relative_error; //_error / bounding sphere radius, times the radius projected in pixels is the screen space error
+
+	public:
+		int get_triangle_count() const {
+			return static_cast<int>(_material_indices.size());
+		}
+	};
+
+	//axis aligned box and the sphere around its center that contains every vertex, zero when empty.
+	class fbx_output_bounds {
+	public:
+		vec3 _min;
+		vec3 _max;
+		vec3 _center;
+		float _radius;
+
+	public:
+		fbx_output_bounds()
+			: _radius(0.f) {
+		}
+	};
+
+	class fbx_output_mesh;
+
+	//where an instance of an fbx_output_instanced_mesh is drawn : p' = p._x * _x_axis + p._y * _y_axis + p._z * _z_axis + _translation,
+	//in the same (LH) coordinates as the mesh. normals need the inverse transpose of the axes.
+	class fbx_output_instance_transform {
+	public:
+		vec3 _x_axis;
+		vec3 _y_axis;
+		vec3 _z_axis;
+		vec3 _translation;
+	};
+
+	//geometry a scene uses more than once, stored once in its local space and drawn once per transform. instances
+	//with a mirroring transform get their own instanced mesh with the winding reversed, so they face outwards once
+	//transformed.
+	class fbx_output_instanced_mesh {
+	public:
+		std::shared_ptr<fbx_output_mesh> _mesh; //same materials as the mesh holding it, no instanced meshes of its own
+		std::vector<fbx_output_instance_transform> _transforms;
+	};
+
+	//the converter's final output. json and binary write it as a mesh_def, the same archive as before the layout
+	//existed, so readers of those formats are unaffected. packed vertices and the rest of what mesh_def can't hold
+	//are only written by json_layout and binary_layout, with the layout in write_layout_to_archive.
+	//
+	//the layout starts with "layout_magic" (FORMAT_MAGIC) then "format_version", which only versions the layout. a
+	//reader taking both tells them apart : binary by peeking the first uint, json by whether
+	//"layout_magic" is there. the magic is far above any count a mesh_def can hold with its 16 bit indices, and as a
+	//float it's ~5.7e7, so a mesh_def never starts with it.
+
+	class fbx_output_mesh {
+	public:
+		static const unsigned int FORMAT_MAGIC = 0x4c584246; //"FBXL"
+		static const int FORMAT_VERSION = 9; //of the layout write_layout_to_archive writes, mesh_def output has none
+		static const int MAX_16_BIT_VERTEX_COUNT = 65536;
+
+	public:
+		std::vector<mesh_material> _materials;
+		std::vector<fbx_polygon_vertex_data> _vertices;
+		std::vector<fbx_packed_vertex> _packed_vertices; //written instead of _vertices by the layout when not empty
+		vec3 _packed_position_min;
+		vec3 _packed_position_extent;
+		std::vector<unsigned int> _indices; //3 per triangle, front faces are clockwise (LH)
+		std::vector<int> _material_indices; //per triangle
+		std::vector<fbx_output_submesh> _submeshes;
+		std::vector<fbx_output_draw_range> _draw_ranges;
+		int _index_size; //bytes per index, 2 or 4
+		std::vector<fbx_output_lod> _lods; //from most to least detailed, not including the mesh itself
+		std::vector<fbx_meshlet> _meshlets; //cover the full detail triangles, never crossing a submesh or material
+		std::vector<unsigned int> _meshlet_vertices; //same convention as _indices
+		std::vector<unsigned char> _meshlet_triangles; //3 per triangle, into the meshlet's vertices
+		fbx_output_bounds _bounds;
+		std::vector<fbx_output_bounds> _material_bounds; //per material, of the full detail triangles using it
+		fbx_bvh _bvh; //over the full detail triangles, empty unless built
+		std::vector<vec3> _position_stream; //unique positions of _vertices for depth and shadow passes, empty unless built
+		std::vector<unsigned int> _position_stream_indices; //3 per full detail triangle into _position_stream, in their own order
+		int _position_stream_index_size; //bytes per index, 2 or 4, no submeshes
+		std::vector<fbx_output_instanced_mesh> _instanced_meshes; //drawn along with this mesh, empty unless instancing is enabled
+
+	public:
+		fbx_output_mesh();
+
+		int get_triangle_count() const;
+
+		//vertices, full detail indices and the position stream as written, what instancing saves for every instance
+		//past the first.
+		uint64_t get_geometry_bytes() const;
+
+		//resets to one submesh covering everything, _indices must be relative to the first vertex.
+		void set_single_submesh(int index_size);
+
+		//splits a single submesh mesh into submeshes of at most max_vertex_count vertices and switches to 16 bit
+		//indices. returns the number of vertices duplicated because they are used by more than one submesh.
+		int split_into_16_bit_submeshes(int max_vertex_count = MAX_16_BIT_VERTEX_COUNT);
+
+		//fills _packed_vertices from _vertices and returns the worst error each attribute picked up.
+		fbx_vertex_packer::error_bounds pack_vertices();
+
+		//of the mesh and its LODs, once their submeshes and triangle order are final.
+		void build_draw_ranges();
+		static void build_draw_ranges(
+			const std::vector<fbx_output_submesh>& submeshes,
+			const std::vector<int>& material_indices,
+			std::vector<fbx_output_draw_range>& draw_ranges);
+		bool is_packed() const;
+
+		void compute_bounds();
+		void build_bvh();
+
+		//positions of _vertices and _indices offset by their submesh's _vertex_begin, what fbx_bvh works with.
+		void get_positions(std::vector<vec3>& positions) const;
+		void get_absolute_indices(std::vector<unsigned int>& indices) const;
+
+		//mesh_def can't hold more than MAX_16_BIT_VERTEX_COUNT vertices, submeshes, packed vertices, LODs, meshlets,
+		//a BVH, a position stream or instanced meshes. bounds, draw ranges and tangent signs are left out, its readers
+		//compute the first two from the vertices and the material sorted triangles and assume positive tangent signs,
+		//as they always have.
+		bool is_mesh_def_compatible() const;
+		std::shared_ptr<mesh_def> make_mesh_def() const;
+
+		//as a mesh_def, what -f json and -f binary write. is_mesh_def_compatible() must be true.
+		void write_to_archive(archive_writer& writer) const;
+
+		//the layout, what -f json_layout and -f binary_layout write. holds everything the mesh has.
+		void write_layout_to_archive(archive_writer& writer) const;
+
+	private:
+		void write_layout(archive_writer& writer) const;
+		void find_submesh_cuts(int max_vertex_count, std::vector<int>& cuts) const;
+		void write_meshlets(archive_writer& writer) const;
+		void write_bvh(archive_writer& writer) const;
+		void write_position_stream(archive_writer& writer) const;
+		void write_submeshes_and_triangles(
+			archive_writer& writer,
+			const std::vector<fbx_output_submesh>& submeshes,
+			const std::vector<fbx_output_draw_range>& draw_ranges,
+			const std::vector<unsigned int>& indices,
+			const std::vector<int>& material_indices) const;
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "fbx_overdraw_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "solar/utility/assert.h"
+
+namespace solar {
+
+	namespace {
+
+		float dot_product(const vec3& a, const vec3& b) {
+			return a._x * b._x + a._y * b._y + a._z * b._z;
+		}
+
+		vec3 cross_product(const vec3& a, const vec3& b) {
+			return vec3(
+				a._y * b._z - a._z * b._y,
+				a._z * b._x - a._x * b._z,
+				a._x * b._y - a._y * b._x);
+		}
+
+		vec3 normalized_or_zero(const vec3& v) {
+			float length = std::sqrt(dot_product(v, v));
+			return (length > 0.f) ? v * (1.f / length) : vec3();
+		}
+
+		class raster_vertex {
+		public:
+			float _x;
+			float _y;
+			float _z;
+		};
+
+		float edge_function(const raster_vertex& a, const raster_vertex& b, float x, float y) {
+			return (b._x - a._x) * (y - a._y) - (b._y - a._y) * (x - a._x);
+		}
+
+	}
+
+	fbx_overdraw_optimizer::fbx_overdraw_optimizer()
+		: _timestamp(0) {
+	}
+
+	void fbx_overdraw_optimizer::optimize_triangle_order(
+		const unsigned int* indices,
+		int triangle_count,
+		const std::vector<vec3>& positions,
+		const vec3& mesh_center,
+		float threshold,
+		std::vector<int>& triangle_order) {
+
+		triangle_order.clear();
+		if (triangle_count == 0) {
+			return;
+		}
+
+		reserve_cache(static_cast<int>(positions.size()));
+		build_hard_boundaries(indices, triangle_count);
+		build_soft_boundaries(indices, triangle_count, threshold);
+
+		//area weighted centroid and normal of each cluster. a cluster whose surface faces away from the mesh center
+		//is on the outside and likely occludes the rest, so it sorts first.
+		_clusters.clear();
+		for (size_t i = 0; i < _soft_boundaries.size(); ++i) {
+			cluster c;
+			c._begin = _soft_boundaries[i];
+			c._end = (i + 1 < _soft_boundaries.size()) ? _soft_boundaries[i + 1] : triangle_count;
+
+			vec3 centroid;
+			vec3 normal;
+			float area_sum = 0.f;
+			for (int i_triangle = c._begin; i_triangle < c._end; ++i_triangle) {
+				const vec3& p0 = positions[indices[i_triangle * 3 + 0]];
+				const vec3& p1 = positions[indices[i_triangle * 3 + 1]];
+				const vec3& p2 = positions[indices[i_triangle * 3 + 2]];
+				vec3 area_normal = cross_product(p1 - p0, p2 - p0); //length is twice the area
+				float area = std::sqrt(dot_product(area_normal, area_normal));
+				centroid = centroid + (p0 + p1 + p2) * (area / 3.f);
+				normal = normal + area_normal;
+				area_sum += area;
+			}
+			if (area_sum > 0.f) {
+				centroid = centroid * (1.f / area_sum);
+			}
+
+			c._sort_key = dot_product(centroid - mesh_center, normalized_or_zero(normal));
+			_clusters.push_back(c);
+		}
+
+		std::stable_sort(_clusters.begin(), _clusters.end(), [](const cluster& a, const cluster& b) {
+			return a._sort_key > b._sort_key;
+		});
+
+		triangle_order.reserve(triangle_count);
+		for (const auto& c : _clusters) {
+			for (int i_triangle = c._begin; i_triangle < c._end; ++i_triangle) {
+				triangle_order.push_back(i_triangle);
+			}
+		}
+	}
+
+	void fbx_overdraw_optimizer::reserve_cache(int vertex_count) {
+		//timestamps only grow, jumping CACHE_SIZE + 1 ahead empties the cache without touching every vertex.
+		if (static_cast<int>(_cache_timestamps.size()) < vertex_count) {
+			_cache_timestamps.resize(vertex_count, 0);
+		}
+	}
+
+	int fbx_overdraw_optimizer::update_cache(const unsigned int* triangle_indices) {
+		//FIFO cache, same model as fbx_vertex_cache_optimizer::measure.
+		int miss_count = 0;
+		for (int k = 0; k < 3; ++k) {
+			auto& timestamp = _cache_timestamps[triangle_indices[k]];
+			if (_timestamp - timestamp > static_cast<unsigned int>(CACHE_SIZE)) {
+				timestamp = _timestamp++;
+				miss_count++;
+			}
+		}
+		return miss_count;
+	}
+
+	void fbx_overdraw_optimizer::build_hard_boundaries(const unsigned int* indices, int triangle_count) {
+		//a triangle missing all 3 vertices is where the cache optimizer restarted on a disjoint patch. cutting there
+		//costs no cache efficiency at all.
+		_hard_boundaries.clear();
+		_timestamp += CACHE_SIZE + 1;
+		for (int i_triangle = 0; i_triangle < triangle_count; ++i_triangle) {
+			int miss_count = update_cache(&indices[i_triangle * 3]);
+			if (i_triangle == 0 || miss_count == 3) {
+				_hard_boundaries.push_back(i_triangle);
+			}
+		}
+	}
+
+	void fbx_overdraw_optimizer::build_soft_boundaries(const unsigned int* indices, int triangle_count, float threshold) {
+		//within each hard cluster, cut as soon as the triangles since the last cut, starting from a cold cache, reach
+		//an ACMR within threshold of the whole hard cluster's. the cache is cold at every cut so the ACMR of the
+		//final order stays close to threshold * the cache optimized ACMR whatever order the clusters end up in.
+		_soft_boundaries.clear();
+		for (size_t i = 0; i < _hard_boundaries.size(); ++i) {
+			int begin = _hard_boundaries[i];
+			int end = (i + 1 < _hard_boundaries.size()) ? _hard_boundaries[i + 1] : triangle_count;
+
+			_timestamp += CACHE_SIZE + 1;
+			int cluster_miss_count = 0;
+			for (int i_triangle = begin; i_triangle < end; ++i_triangle) {
+				cluster_miss_count += update_cache(&indices[i_triangle * 3]);
+			}
+			float target_acmr = threshold * cluster_miss_count / (end - begin);
+
+			_soft_boundaries.push_back(begin);
+			_timestamp += CACHE_SIZE + 1;
+			int running_miss_count = 0;
+			int running_triangle_count = 0;
+			for (int i_triangle = begin; i_triangle < end; ++i_triangle) {
+				running_miss_count += update_cache(&indices[i_triangle * 3]);
+				running_triangle_count++;
+				if (static_cast<float>(running_miss_count) / running_triangle_count <= target_acmr) {
+					_soft_boundaries.push_back(i_triangle + 1);
+					_timestamp += CACHE_SIZE + 1;
+					running_miss_count = 0;
+					running_triangle_count = 0;
+				}
+			}
+
+			//whatever is left after the last cut is rarely a good cluster on its own, merge it into the previous one.
+			//this also drops the cut at end when the last cluster happened to close exactly there.
+			if (_soft_boundaries.back() != begin) {
+				_soft_boundaries.pop_back();
+			}
+		}
+	}
+
+	float fbx_overdraw_optimizer::measure_overdraw(const std::vector<unsigned int>& indices, const std::vector<vec3>& positions) {
+		if (indices.empty() || positions.empty()) {
+			return 0.f;
+		}
+
+		vec3 min_position = positions.front();
+		vec3 max_position = positions.front();
+		for (const auto& p : positions) {
+			min_position = vec3(std::min(min_position._x, p._x), std::min(min_position._y, p._y), std::min(min_position._z, p._z));
+			max_position = vec3(std::max(max_position._x, p._x), std::max(max_position._y, p._y), std::max(max_position._z, p._z));
+		}
+		vec3 center = (min_position + max_position) * 0.5f;
+		vec3 half_extent = (max_position - min_position) * 0.5f;
+		float radius = std::sqrt(dot_product(half_extent, half_extent));
+		if (radius <= 0.f) {
+			return 0.f;
+		}
+
+		//the 6 axes and the 8 cube diagonals.
+		std::vector<vec3> view_directions = {
+			vec3(1.f, 0.f, 0.f), vec3(-1.f, 0.f, 0.f),
+			vec3(0.f, 1.f, 0.f), vec3(0.f, -1.f, 0.f),
+			vec3(0.f, 0.f, 1.f), vec3(0.f, 0.f, -1.f)
+		};
+		for (float x : { -1.f, 1.f }) {
+			for (float y : { -1.f, 1.f }) {
+				for (float z : { -1.f, 1.f }) {
+					view_directions.push_back(normalized_or_zero(vec3(x, y, z)));
+				}
+			}
+		}
+
+		const float pixels_per_unit = RASTER_SIZE / (2.f * radius);
+		std::vector<float> depth_buffer;
+		std::vector<raster_vertex> raster_vertices(positions.size());
+		long long shaded_pixel_count = 0;
+		long long covered_pixel_count = 0;
+
+		for (const auto& view_direction : view_directions) {
+			vec3 up = (std::abs(view_direction._y) < 0.9f) ? vec3(0.f, 1.f, 0.f) : vec3(1.f, 0.f, 0.f);
+			vec3 right = normalized_or_zero(cross_product(up, view_direction));
+			up = cross_product(view_direction, right);
+
+			for (size_t i = 0; i < positions.size(); ++i) {
+				vec3 p = positions[i] - center;
+				auto& v = raster_vertices[i];
+				v._x = (dot_product(p, right) + radius) * pixels_per_unit;
+				v._y = (dot_product(p, up) + radius) * pixels_per_unit;
+				v._z = dot_product(p, view_direction);
+			}
+
+			depth_buffer.assign(RASTER_SIZE * RASTER_SIZE, std::numeric_limits<float>::max());
+			for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+				const vec3& p0 = positions[indices[i + 0]];
+				const vec3& p1 = positions[indices[i + 1]];
+				const vec3& p2 = positions[indices[i + 2]];
+				if (dot_product(cross_product(p1 - p0, p2 - p0), view_direction) >= 0.f) {
+					continue; //back facing
+				}
+
+				raster_vertex v0 = raster_vertices[indices[i + 0]];
+				raster_vertex v1 = raster_vertices[indices[i + 1]];
+				raster_vertex v2 = raster_vertices[indices[i + 2]];
+				float area = edge_function(v0, v1, v2._x, v2._y);
+				if (area == 0.f) {
+					continue;
+				}
+				if (area < 0.f) {
+					std::swap(v1, v2);
+					area = -area;
+				}
+
+				int min_x = std::max(0, static_cast<int>(std::floor(std::min({ v0._x, v1._x, v2._x }))));
+				int min_y = std::max(0, static_cast<int>(std::floor(std::min({ v0._y, v1._y, v2._y }))));
+				int max_x = std::min(RASTER_SIZE - 1, static_cast<int>(std::ceil(std::max({ v0._x, v1._x, v2._x }))));
+				int max_y = std::min(RASTER_SIZE - 1, static_cast<int>(std::ceil(std::max({ v0._y, v1._y, v2._y }))));
+
+				for (int y = min_y; y <= max_y; ++y) {
+					for (int x = min_x; x <= max_x; ++x) {
+						float sample_x = x + 0.5f;
+						float sample_y = y + 0.5f;
+						float w0 = edge_function(v1, v2, sample_x, sample_y);
+						float w1 = edge_function(v2, v0, sample_x, sample_y);
+						float w2 = edge_function(v0, v1, sample_x, sample_y);
+						if (w0 < 0.f || w1 < 0.f || w2 < 0.f) {
+							continue;
+						}
+
+						float z = (w0 * v0._z + w1 * v1._z + w2 * v2._z) / area;
+						float& depth = depth_buffer[y * RASTER_SIZE + x];
+						if (z < depth) {
+							depth = z;
+							shaded_pixel_count++;
+						}
+					}
+				}
+			}
+
+			covered_pixel_count += std::count_if(depth_buffer.begin(), depth_buffer.end(), [](float depth) {
+				return depth != std::numeric_limits<float>::max();
+			});
+		}
+
+		if (covered_pixel_count == 0) {
+			return 0.f;
+		}
+		return static_cast<float>(static_cast<double>(shaded_pixel_count) / covered_pixel_count);
+	}
+
+}
\ No newline at end of file
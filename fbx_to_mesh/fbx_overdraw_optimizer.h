@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include "solar/math/vec3.h"
+
+namespace solar {
+
+	//reorders an already vertex cache optimized range of triangles to reduce overdraw (Sander, Nehab, Barczak,
+	//"Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+	//
+	//the range is split into clusters wherever the vertex cache would restart anyway, then split further as long as
+	//each cluster's ACMR stays within threshold of its parent's. clusters are sorted so those facing out from the
+	//mesh center draw first, which lets early z reject more of what is drawn after them from any view direction.
+	//
+	//indices are front facing when (p1 - p0) x (p2 - p0) points out of the surface.
+
+	class fbx_overdraw_optimizer {
+	public:
+		static const int CACHE_SIZE = 16;
+		static const int RASTER_SIZE = 128; //resolution of each view used to estimate overdraw
+
+	private:
+		class cluster {
+		public:
+			int _begin;
+			int _end;
+			float _sort_key;
+		};
+
+		std::vector<unsigned int> _cache_timestamps;
+		unsigned int _timestamp;
+		std::vector<int> _hard_boundaries;
+		std::vector<int> _soft_boundaries;
+		std::vector<cluster> _clusters;
+
+	public:
+		fbx_overdraw_optimizer();
+
+		//triangle_order receives the new order as offsets from the first triangle of the range.
+		void optimize_triangle_order(
+			const unsigned int* indices,
+			int triangle_count,
+			const std::vector<vec3>& positions,
+			const vec3& mesh_center,
+			float threshold,
+			std::vector<int>& triangle_order);
+
+		//pixels shaded / pixels covered, summed over a fixed set of orthographic views rendered with early z and back
+		//face culling. 1 means no overdraw.
+		static float measure_overdraw(const std::vector<unsigned int>& indices, const std::vector<vec3>& positions);
+
+	private:
+		void reserve_cache(int vertex_count);
+		int update_cache(const unsigned int* triangle_indices);
+		void build_hard_boundaries(const unsigned int* indices, int triangle_count);
+		void build_soft_boundaries(const unsigned int* indices, int triangle_count, float threshold);
+	};
+
+}
\ No newline at end of file
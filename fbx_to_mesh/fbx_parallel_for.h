@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace solar {
+
+	inline unsigned int get_default_fbx_thread_count() {
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	//splits [0, count) into contiguous ranges and calls func(begin, end) for each range on its own thread.
+	//the calling thread runs the first range. ranges are never smaller than min_range_size so small inputs
+	//don't pay for thread creation. func must not throw.
+	template<typename FuncT>
+	void fbx_parallel_for(unsigned int thread_count, int count, int min_range_size, FuncT func) {
+		if (count <= 0) {
+			return;
+		}
+
+		int range_count = std::max(1, std::min(static_cast<int>(thread_count), count / std::max(1, min_range_size)));
+		if (range_count == 1) {
+			func(0, count);
+			return;
+		}
+
+		int range_size = (count + range_count - 1) / range_count;
+
+		std::vector<std::thread> threads;
+		threads.reserve(range_count - 1);
+		for (int i_range = 1; i_range < range_count; ++i_range) {
+			int begin = i_range * range_size;
+			int end = std::min(count, begin + range_size);
+			if (begin < end) {
+				threads.emplace_back([&func, begin, end]() { func(begin, end); });
+			}
+		}
+
+		func(0, std::min(count, range_size));
+
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "fbx_pipeline_benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include "solar/math/mat33.h"
+#include "solar/utility/assert.h"
+#include "solar/utility/type_convert.h"
+#include "fbx_coordinate_converter.h"
+#include "fbx_process_memory.h"
+
+namespace solar {
+
+	namespace {
+
+		double bytes_to_mb(uint64_t bytes) {
+			return static_cast<double>(bytes) / (1024.0 * 1024.0);
+		}
+
+		template<typename FuncT>
+		double get_best_nanoseconds_per_item(int repeat_count, int item_count, FuncT func) {
+			double best = std::numeric_limits<double>::max();
+			for (int i = 0; i < repeat_count; ++i) {
+				auto start = std::chrono::high_resolution_clock::now();
+				func();
+				auto end = std::chrono::high_resolution_clock::now();
+				best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / item_count);
+			}
+			return best;
+		}
+
+	}
+
+	fbx_pipeline_benchmark::fbx_pipeline_benchmark(const fbx_converter_params& params, int max_triangle_count)
+		: _params(params)
+		, _max_triangle_count(max_triangle_count) {
+
+		_params.set_is_verbose(false); //per mesh messages would be timed too
+	}
+
+	std::vector<fbx_pipeline_benchmark::result> fbx_pipeline_benchmark::run(std::ostream& os) const {
+		std::vector<result> results;
+		for (int triangle_count = MIN_TRIANGLE_COUNT; triangle_count <= std::max(_max_triangle_count, MIN_TRIANGLE_COUNT); triangle_count *= 10) {
+			for (int i_shape = 0; i_shape < fbx_synthetic_mesh::SHAPE_COUNT; ++i_shape) {
+				results.push_back(run_one(static_cast<fbx_synthetic_mesh::shape>(i_shape), triangle_count));
+				write_result(os, results.back());
+			}
+			if (triangle_count > std::numeric_limits<int>::max() / 10) {
+				break;
+			}
+		}
+
+		//once, each mesh only reports its own scratch memory. before the coordinate conversion, whose buffers aren't
+		//the pipeline's.
+		os << std::fixed << std::setprecision(2) << "process peak memory " << bytes_to_mb(get_peak_process_memory_bytes()) << " MB\n";
+		run_coordinate_conversion(os, std::min(std::max(_max_triangle_count, MIN_TRIANGLE_COUNT), MAX_COORDINATE_CONVERSION_COUNT));
+		return results;
+	}
+
+	bool fbx_pipeline_benchmark::run_coordinate_conversion(std::ostream& os, int count) {
+		//the converter's RH->LH conversion : one vector at a time with the matrix built per vector (how it used to
+		//be), one at a time with the matrix built once, and fbx_coordinate_converter's batch conversion.
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<double> distribution(-1000.0, 1000.0);
+		std::vector<double> vec4_values(count * 4);
+		std::vector<double> uv_values(count * 2);
+		for (auto& value : vec4_values) {
+			value = distribution(random);
+		}
+		for (auto& value : uv_values) {
+			value = distribution(random) / 1000.0;
+		}
+
+		std::vector<vec3> per_vector_vec3s(count);
+		std::vector<vec3> scalar_vec3s(count);
+		std::vector<vec3> batch_vec3s(count);
+		std::vector<uv> scalar_uvs(count);
+		std::vector<uv> batch_uvs(count);
+		const int repeat_count = 5;
+
+		double per_vector_ns = get_best_nanoseconds_per_item(repeat_count, count, [&]() {
+			for (int i = 0; i < count; ++i) {
+				const double* value = &vec4_values[i * 4];
+				per_vector_vec3s[i] = make_mat33_rotation_on_y(deg(180.f)).transform_vec3(
+					vec3(double_to_float(value[0]), double_to_float(value[1]), -double_to_float(value[2])));
+			}
+		});
+		double scalar_ns = get_best_nanoseconds_per_item(repeat_count, count, [&]() {
+			for (int i = 0; i < count; ++i) {
+				scalar_vec3s[i] = fbx_coordinate_converter::convert_vec3(&vec4_values[i * 4]);
+			}
+		});
+		double batch_ns = get_best_nanoseconds_per_item(repeat_count, count, [&]() {
+			fbx_coordinate_converter::convert_vec3s(vec4_values.data(), count, batch_vec3s.data());
+		});
+		double scalar_uv_ns = get_best_nanoseconds_per_item(repeat_count, count, [&]() {
+			for (int i = 0; i < count; ++i) {
+				scalar_uvs[i] = fbx_coordinate_converter::convert_uv(&uv_values[i * 2]);
+			}
+		});
+		double batch_uv_ns = get_best_nanoseconds_per_item(repeat_count, count, [&]() {
+			fbx_coordinate_converter::convert_uvs(uv_values.data(), count, batch_uvs.data());
+		});
+
+		//bitwise, the batch conversion must never change the output.
+		int mismatch_count = 0;
+		for (int i = 0; i < count; ++i) {
+			if (std::memcmp(&per_vector_vec3s[i], &batch_vec3s[i], sizeof(vec3)) != 0 ||
+				std::memcmp(&scalar_vec3s[i], &batch_vec3s[i], sizeof(vec3)) != 0 ||
+				std::memcmp(&scalar_uvs[i], &batch_uvs[i], sizeof(uv)) != 0) {
+				++mismatch_count;
+			}
+		}
+
+		os << std::fixed << std::setprecision(2);
+		os << "coordinate conversion : " << count << " vectors, simd " << (fbx_coordinate_converter::is_simd_enabled() ? "on" : "off")
+			<< ", " << mismatch_count << " mismatches\n";
+		os << "    vec3 per vector matrix " << std::setw(8) << per_vector_ns << " ns\n";
+		os << "    vec3 scalar            " << std::setw(8) << scalar_ns << " ns\n";
+		os << "    vec3 batch             " << std::setw(8) << batch_ns << " ns\n";
+		os << "    uv scalar              " << std::setw(8) << scalar_uv_ns << " ns\n";
+		os << "    uv batch               " << std::setw(8) << batch_uv_ns << " ns\n";
+		os.flush();
+		return mismatch_count == 0;
+	}
+
+	fbx_pipeline_benchmark::result fbx_pipeline_benchmark::run_one(fbx_synthetic_mesh::shape shape, int triangle_count) const {
+		auto mesh_data = fbx_synthetic_mesh::make(shape, triangle_count);
+
+		fbx_mesh_pipeline pipeline(_params);
+		auto output_mesh = pipeline.convert_mesh_data_to_output_mesh(std::move(mesh_data));
+		ASSERT(output_mesh != nullptr);
+
+		result result;
+		result._shape = shape;
+		result._stats = pipeline.get_stats();
+		result._error_count = pipeline.get_error_count();
+		return result;
+	}
+
+	void fbx_pipeline_benchmark::write_result(std::ostream& os, const result& result) {
+		double milliseconds = result._stats.get_total_milliseconds();
+		double triangles_per_second = (milliseconds > 0.0) ? result._stats._triangle_count / (milliseconds / 1000.0) : 0.0;
+
+		os << std::fixed << std::setprecision(2);
+		os << fbx_synthetic_mesh::shape_to_string(result._shape)
+			<< " : " << result._stats._triangle_count << " triangles, " << result._stats._vertex_count << " vertices, "
+			<< milliseconds << " ms, " << triangles_per_second / 1000000.0 << " Mtri/s, scratch "
+			<< bytes_to_mb(result._stats._scratch_memory_bytes) << " MB";
+		if (result._error_count > 0) {
+			os << ", " << result._error_count << " errors";
+		}
+		os << "\n";
+
+		for (const auto& stage : result._stats._stages) {
+			double percent = (milliseconds > 0.0) ? 100.0 * stage._milliseconds / milliseconds : 0.0;
+			os << "    " << std::left << std::setw(32) << stage._name << std::right
+				<< std::setw(10) << stage._milliseconds << " ms " << std::setw(6) << percent << " % "
+				<< std::setw(10) << bytes_to_mb(stage._scratch_memory_bytes) << " MB\n";
+		}
+		os.flush();
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+#include "fbx_converter_params.h"
+#include "fbx_mesh_pipeline.h"
+#include "fbx_synthetic_mesh.h"
+
+namespace solar {
+
+	//runs fbx_mesh_pipeline on every fbx_synthetic_mesh shape at 1K, 10K, ... triangles up to a max and reports
+	//each stage's time and scratch memory and the throughput, then the process's peak memory once. the coordinate
+	//conversion microbenchmark runs last.
+	//
+	//like the pipeline it has no FBX SDK or win32 dependency.
+
+	class fbx_pipeline_benchmark {
+	public:
+		static const int MIN_TRIANGLE_COUNT = 1000;
+		static const int MAX_COORDINATE_CONVERSION_COUNT = 4 * 1024 * 1024;
+
+		class result {
+		public:
+			fbx_synthetic_mesh::shape _shape;
+			fbx_conversion_stats _stats;
+			int _error_count;
+		};
+
+	private:
+		fbx_converter_params _params;
+		int _max_triangle_count;
+
+	public:
+		fbx_pipeline_benchmark(const fbx_converter_params& params, int max_triangle_count);
+
+		std::vector<result> run(std::ostream& os) const;
+
+		//times fbx_coordinate_converter against the scalar conversion and returns whether the results are bit
+		//identical.
+		static bool run_coordinate_conversion(std::ostream& os, int count);
+
+	private:
+		result run_one(fbx_synthetic_mesh::shape shape, int triangle_count) const;
+		static void write_result(std::ostream& os, const result& result);
+	};
+
+}
\ No newline at end of file
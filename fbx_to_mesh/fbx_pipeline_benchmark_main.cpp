@@ -0,0 +1,39 @@
+#include "fbx_pipeline_benchmark.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace solar;
+
+//standalone entry point for fbx_pipeline_benchmark, built by CMakeLists.txt without the FBX SDK or the win32
+//engine. the same benchmark runs from fbx_to_mesh with -z.
+//
+//usage : fbx_pipeline_benchmark [max_triangle_count] [thread_count]
+
+int main(int argc, char* argv[])
+{
+	try {
+		int max_triangle_count = (argc > 1) ? std::stoi(argv[1]) : 100000;
+		if (max_triangle_count <= 0) {
+			throw std::runtime_error("max triangle count must be positive");
+		}
+		fbx_converter_params params;
+		if (argc > 2) {
+			int thread_count = std::stoi(argv[2]);
+			if (thread_count <= 0) {
+				throw std::runtime_error("thread count must be positive");
+			}
+			params.set_thread_count(static_cast<unsigned int>(thread_count));
+		}
+
+		int error_count = 0;
+		for (const auto& result : fbx_pipeline_benchmark(params, max_triangle_count).run(std::cout)) {
+			error_count += result._error_count;
+		}
+		return (error_count == 0) ? 0 : 1;
+	}
+	catch (const std::exception& e) {
+		std::cerr << "error : " << e.what() << std::endl;
+		return 1;
+	}
+}
\ No newline at end of file
@@ -1,32 +1,35 @@
 #pragma once
 
-#include "solar/utility/optional.h"
+#include "solar/math/vec3.h"
+#include "solar/rendering/textures/uv.h"
 #include "solar/utility/checksum.h"
 
 namespace solar {
 
 	class fbx_polygon_vertex_data {
 	public:
-		optional<vec3> _position;
-		optional<vec3> _normal;
-		optional<vec3> _tangent;
-		optional<uv> _uv;
+		vec3 _position;
+		vec3 _normal;
+		vec3 _tangent;
+		float _tangent_sign; //1 or -1, bitangent = cross(_normal, _tangent) * _tangent_sign
+		uv _uv;
 
 	public:
 		checksum get_checksum() const {
 			return checksum()
-				.add_checksum_at_index(0, checksum().add_vec3(_position.value()))
-				.add_checksum_at_index(1, checksum().add_vec3(_normal.value_or_default()))
-				.add_checksum_at_index(2, checksum().add_vec3(_tangent.value_or_default()))
-				.add_checksum_at_index(3, _uv.value_or_default().to_checksum());
+				.add_checksum_at_index(0, checksum().add_vec3(_position))
+				.add_checksum_at_index(1, checksum().add_vec3(_normal))
+				.add_checksum_at_index(2, checksum().add_vec3(_tangent).add_vec3(vec3(_tangent_sign, 0.f, 0.f)))
+				.add_checksum_at_index(3, _uv.to_checksum());
 		}
 
 		bool operator==(const fbx_polygon_vertex_data& rhs) const {
 			return
-				_position.value() == rhs._position.value() &&
-				_normal.value() == rhs._normal.value() &&
-				_tangent.value() == rhs._tangent.value() &&
-				_uv.value() == rhs._uv.value();
+				_position == rhs._position &&
+				_normal == rhs._normal &&
+				_tangent == rhs._tangent &&
+				_tangent_sign == rhs._tangent_sign &&
+				_uv == rhs._uv;
 		}
 	};
 
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+namespace solar {
+
+	//largest resident set of this process so far, 0 if the platform can't tell.
+	inline uint64_t get_peak_process_memory_bytes() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		counters.cb = sizeof(counters);
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+		}
+		return 0;
+#else
+		rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) == 0) {
+			return static_cast<uint64_t>(usage.ru_maxrss) * 1024; //kilobytes on linux
+		}
+		return 0;
+#endif
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "fbx_scratch_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include "solar/utility/assert.h"
+
+namespace solar {
+
+	fbx_scratch_arena::fbx_scratch_arena()
+		: _used(0)
+		, _allocated_bytes(0)
+		, _high_water_bytes(0) {
+	}
+
+	void* fbx_scratch_arena::allocate(size_t size, size_t alignment) {
+		ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0);
+		if (size == 0) {
+			size = 1; //distinct pointers, like operator new
+		}
+
+		auto try_allocate = [&]() -> void* {
+			if (_blocks.empty()) {
+				return nullptr;
+			}
+			unsigned char* memory = _blocks.back().get();
+			uintptr_t begin = reinterpret_cast<uintptr_t>(memory);
+			size_t aligned_used = static_cast<size_t>(((begin + _used + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1)) - begin);
+			if (aligned_used + size > _block_sizes.back()) {
+				return nullptr;
+			}
+			_allocated_bytes += aligned_used + size - _used;
+			_high_water_bytes = std::max(_high_water_bytes, _allocated_bytes);
+			_used = aligned_used + size;
+			return memory + aligned_used;
+		};
+
+		void* memory = try_allocate();
+		if (memory == nullptr) {
+			size_t last_size = _block_sizes.empty() ? 0 : _block_sizes.back();
+			add_block(std::max(std::max(MIN_BLOCK_SIZE, last_size * 2), size + alignment));
+			memory = try_allocate();
+			ASSERT(memory != nullptr);
+		}
+		return memory;
+	}
+
+	void fbx_scratch_arena::reset() {
+		if (_blocks.size() > 1) {
+			size_t capacity = get_capacity();
+			_blocks.clear();
+			_block_sizes.clear();
+			add_block(capacity);
+		}
+		_used = 0;
+		_allocated_bytes = 0;
+	}
+
+	size_t fbx_scratch_arena::get_capacity() const {
+		size_t capacity = 0;
+		for (size_t size : _block_sizes) {
+			capacity += size;
+		}
+		return capacity;
+	}
+
+	size_t fbx_scratch_arena::get_allocated_bytes() const {
+		return _allocated_bytes;
+	}
+
+	size_t fbx_scratch_arena::get_high_water_bytes() const {
+		return _high_water_bytes;
+	}
+
+	void fbx_scratch_arena::add_block(size_t size) {
+		_blocks.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[size]));
+		_block_sizes.push_back(size);
+		_used = 0;
+	}
+
+}
\ No newline at end of file
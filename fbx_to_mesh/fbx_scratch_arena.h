@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace solar {
+
+	//monotonic allocator for the scratch memory of one conversion. allocations are bumped out of large blocks and
+	//never freed one by one, reset() makes everything available again for the next conversion.
+	//
+	//reset is O(1) and keeps the capacity. when a conversion needed more than one block they are merged into a
+	//single block of their total size, so once the high water mark is reached every later conversion runs in one
+	//block without touching the heap. an arena belongs to one converter and must only be used by its thread, worker
+	//threads of a stage must not allocate from it.
+
+	class fbx_scratch_arena {
+	public:
+		static const size_t MIN_BLOCK_SIZE = 1024 * 1024;
+
+	private:
+		std::vector<std::unique_ptr<unsigned char[]>> _blocks;
+		std::vector<size_t> _block_sizes;
+		size_t _used; //in the last block
+		size_t _allocated_bytes; //since the last reset, alignment padding included
+		size_t _high_water_bytes;
+
+	public:
+		fbx_scratch_arena();
+		fbx_scratch_arena(const fbx_scratch_arena&) = delete;
+		fbx_scratch_arena& operator=(const fbx_scratch_arena&) = delete;
+
+		void* allocate(size_t size, size_t alignment);
+		void reset();
+
+		size_t get_capacity() const;
+		size_t get_allocated_bytes() const; //since the last reset
+		size_t get_high_water_bytes() const;
+
+	private:
+		void add_block(size_t size);
+	};
+
+	//STL allocator over a fbx_scratch_arena, deallocate does nothing. vectors should be sized once, growing one
+	//leaves its old buffers in the arena until the next reset.
+	template<typename T>
+	class fbx_arena_allocator {
+	public:
+		typedef T value_type;
+
+		template<typename U>
+		struct rebind {
+			typedef fbx_arena_allocator<U> other;
+		};
+
+	public:
+		fbx_scratch_arena* _arena;
+
+	public:
+		fbx_arena_allocator(fbx_scratch_arena& arena)
+			: _arena(&arena) {
+		}
+
+		template<typename U>
+		fbx_arena_allocator(const fbx_arena_allocator<U>& other)
+			: _arena(other._arena) {
+		}
+
+		T* allocate(size_t count) {
+			return static_cast<T*>(_arena->allocate(count * sizeof(T), std::alignment_of<T>::value));
+		}
+
+		void deallocate(T*, size_t) {
+		}
+
+		template<typename U>
+		bool operator==(const fbx_arena_allocator<U>& other) const {
+			return _arena == other._arena;
+		}
+
+		template<typename U>
+		bool operator!=(const fbx_arena_allocator<U>& other) const {
+			return _arena != other._arena;
+		}
+	};
+
+	template<typename T>
+	using fbx_arena_vector = std::vector<T, fbx_arena_allocator<T>>;
+
+}
\ No newline at end of file
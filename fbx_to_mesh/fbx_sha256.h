@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace solar {
+
+	//streaming SHA-256, used to content address cached conversions.
+
+	class fbx_sha256 {
+	private:
+		uint32_t _state[8];
+		uint8_t _block[64];
+		uint64_t _total_size;
+		size_t _block_size;
+
+	public:
+		fbx_sha256();
+
+		fbx_sha256& add_bytes(const void* data, size_t size);
+		fbx_sha256& add_string(const std::string& s);
+		std::string finish_to_hex_string();
+
+	private:
+		void process_block(const uint8_t* block);
+	};
+
+}
\ No newline at end of file
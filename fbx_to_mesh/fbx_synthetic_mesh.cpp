@@ -0,0 +1,143 @@
+#include "fbx_synthetic_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "solar/utility/assert.h"
+
+namespace solar {
+
+	namespace {
+
+		const float PI = 3.14159265f;
+
+		int add_vertex(fbx_converter_mesh_data& mesh_data, const vec3& position, int control_point_index, const uv& uv) {
+			int i_pv = mesh_data.add_polygon_vertex(position, control_point_index);
+			mesh_data._uvs[i_pv] = uv;
+			mesh_data.set_attribute_flag(i_pv, fbx_converter_mesh_data::HAS_UV);
+			return i_pv;
+		}
+
+	}
+
+	fbx_converter_mesh_data fbx_synthetic_mesh::make(shape shape, int triangle_count) {
+		fbx_converter_mesh_data mesh_data;
+		switch (shape) {
+			case GRID:
+				make_grid(mesh_data, triangle_count, false, false, true);
+				make_materials(mesh_data, 1);
+				break;
+			case SPHERE:
+				make_sphere(mesh_data, triangle_count);
+				make_materials(mesh_data, 1);
+				break;
+			case SEAMS:
+				make_grid(mesh_data, triangle_count, true, true, false);
+				make_materials(mesh_data, 1);
+				break;
+			case MATERIALS:
+				make_grid(mesh_data, triangle_count, true, false, true);
+				make_materials(mesh_data, MATERIAL_COUNT);
+				break;
+			default:
+				ASSERT(false);
+		}
+		return mesh_data;
+	}
+
+	const char* fbx_synthetic_mesh::shape_to_string(shape shape) {
+		switch (shape) {
+			case GRID: return "grid";
+			case SPHERE: return "sphere";
+			case SEAMS: return "seams";
+			case MATERIALS: return "materials";
+			default: return "unknown";
+		}
+	}
+
+	void fbx_synthetic_mesh::make_grid(fbx_converter_mesh_data& mesh_data, int triangle_count, bool is_wavy, bool is_uv_per_quad, bool has_normals_and_tangents) {
+		int side = std::max(1, static_cast<int>(std::sqrt(triangle_count / 2.f)));
+		mesh_data.reserve(side * side * 2, side * side * 6);
+
+		auto get_position = [&](int x, int z) {
+			float height = is_wavy ? std::sin(x * 0.3f) * std::cos(z * 0.2f) * 2.f : 0.f;
+			return vec3(static_cast<float>(x), height, static_cast<float>(z));
+		};
+		auto get_uv = [&](int x, int z, int quad_x, int quad_z) {
+			return is_uv_per_quad ?
+				uv(static_cast<float>(x - quad_x), static_cast<float>(z - quad_z)) :
+				uv(static_cast<float>(x) / side, static_cast<float>(z) / side);
+		};
+
+		for (int quad_z = 0; quad_z < side; ++quad_z) {
+			for (int quad_x = 0; quad_x < side; ++quad_x) {
+				int corner_xs[4] = { quad_x, quad_x + 1, quad_x + 1, quad_x };
+				int corner_zs[4] = { quad_z, quad_z, quad_z + 1, quad_z + 1 };
+				auto add_corner = [&](int k) {
+					int x = corner_xs[k];
+					int z = corner_zs[k];
+					int i_pv = add_vertex(mesh_data, get_position(x, z), z * (side + 1) + x, get_uv(x, z, quad_x, quad_z));
+					if (has_normals_and_tangents) {
+						mesh_data._normals[i_pv] = vec3(0.f, 1.f, 0.f); //only right when flat, the pipeline doesn't care
+						mesh_data._tangents[i_pv] = vec3(1.f, 0.f, 0.f);
+						mesh_data.set_attribute_flag(i_pv, fbx_converter_mesh_data::HAS_NORMAL);
+						mesh_data.set_attribute_flag(i_pv, fbx_converter_mesh_data::HAS_TANGENT);
+					}
+					return i_pv;
+				};
+
+				//in the .fbx winding, facing +y once build_output_mesh reverses it. every triangle gets its own
+				//polygon vertices, as after triangulating a .fbx.
+				mesh_data.add_triangle({ { add_corner(0), add_corner(1), add_corner(2) } });
+				mesh_data.add_triangle({ { add_corner(0), add_corner(2), add_corner(3) } });
+			}
+		}
+		mesh_data.build_control_point_vertices((side + 1) * (side + 1));
+	}
+
+	void fbx_synthetic_mesh::make_sphere(fbx_converter_mesh_data& mesh_data, int triangle_count) {
+		//rings * segments * 2 triangles with segments = 2 * rings, the pole rows keep their degenerate triangles.
+		int ring_count = std::max(2, static_cast<int>(std::sqrt(triangle_count / 4.f)));
+		int segment_count = ring_count * 2;
+		mesh_data.reserve(ring_count * segment_count * 2, ring_count * segment_count * 6);
+
+		auto get_position = [&](int ring, int segment) {
+			float theta = PI * ring / ring_count;
+			float phi = 2.f * PI * (segment % segment_count) / segment_count;
+			return vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+		};
+
+		for (int ring = 0; ring < ring_count; ++ring) {
+			for (int segment = 0; segment < segment_count; ++segment) {
+				int corner_rings[4] = { ring, ring, ring + 1, ring + 1 };
+				int corner_segments[4] = { segment, segment + 1, segment + 1, segment };
+				auto add_corner = [&](int k) {
+					int r = corner_rings[k];
+					int s = corner_segments[k];
+					//the last segment wraps to the first control point but keeps u = 1, which makes the uv seam.
+					uv corner_uv(static_cast<float>(s) / segment_count, static_cast<float>(r) / ring_count);
+					return add_vertex(mesh_data, get_position(r, s), r * segment_count + (s % segment_count), corner_uv);
+				};
+				mesh_data.add_triangle({ { add_corner(0), add_corner(2), add_corner(1) } });
+				mesh_data.add_triangle({ { add_corner(0), add_corner(3), add_corner(2) } });
+			}
+		}
+		mesh_data.build_control_point_vertices((ring_count + 1) * segment_count);
+	}
+
+	void fbx_synthetic_mesh::make_materials(fbx_converter_mesh_data& mesh_data, int material_count) {
+		for (int i_material = 0; i_material < material_count; ++i_material) {
+			fbx_converter_mesh_data::material material;
+			material._diffuse_map_file_name = build_string("synthetic_{}_diffuse.dds", i_material);
+			material._normal_map_file_name = build_string("synthetic_{}_normal.dds", i_material);
+			mesh_data._materials.push_back(material);
+		}
+
+		std::mt19937 random(1234);
+		std::uniform_int_distribution<int> distribution(0, material_count - 1);
+		for (auto& material_index : mesh_data._material_indices) {
+			material_index = distribution(random);
+		}
+	}
+
+}
\ No newline at end of file
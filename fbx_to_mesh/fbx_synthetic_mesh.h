@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "fbx_converter_mesh_data.h"
+
+namespace solar {
+
+	//procedural meshes in the same state fbx_converter leaves them in after import, for running fbx_mesh_pipeline
+	//without .fbx files. every shape is deterministic for a given triangle count, which is approximate.
+	//
+	//GRID : flat, every attribute imported, one material. the cheapest case.
+	//SPHERE : positions and uvs only, so normals and tangents are generated. has a uv seam and degenerate poles.
+	//SEAMS : wavy grid with every quad its own uv island, so no corners weld and vertices are 2x the triangles.
+	//MATERIALS : wavy grid with every triangle given one of MATERIAL_COUNT materials at random.
+
+	class fbx_synthetic_mesh {
+	public:
+		enum shape {
+			GRID,
+			SPHERE,
+			SEAMS,
+			MATERIALS,
+			SHAPE_COUNT
+		};
+
+		static const int MATERIAL_COUNT = 64;
+
+	public:
+		static fbx_converter_mesh_data make(shape shape, int triangle_count);
+		static const char* shape_to_string(shape shape);
+
+	private:
+		static void make_grid(fbx_converter_mesh_data& mesh_data, int triangle_count, bool is_wavy, bool is_uv_per_quad, bool has_normals_and_tangents);
+		static void make_sphere(fbx_converter_mesh_data& mesh_data, int triangle_count);
+		static void make_materials(fbx_converter_mesh_data& mesh_data, int material_count);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "fbx_tangent_frame_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include "solar/utility/assert.h"
+#include "fbx_parallel_for.h"
+
+namespace solar {
+
+	namespace {
+
+		float dot_product(const vec3& a, const vec3& b) {
+			return a._x * b._x + a._y * b._y + a._z * b._z;
+		}
+
+		vec3 cross_product(const vec3& a, const vec3& b) {
+			return vec3(
+				a._y * b._z - a._z * b._y,
+				a._z * b._x - a._x * b._z,
+				a._x * b._y - a._y * b._x);
+		}
+
+		vec3 normalized_or_zero(const vec3& v) {
+			float length = std::sqrt(dot_product(v, v));
+			return (length > 0.f) ? v * (1.f / length) : vec3();
+		}
+
+		float angle_between(const vec3& a, const vec3& b) {
+			float d = dot_product(normalized_or_zero(a), normalized_or_zero(b));
+			return std::acos(std::max(-1.f, std::min(1.f, d)));
+		}
+
+		vec3 project_on_plane(const vec3& v, const vec3& normal) {
+			return v - normal * dot_product(normal, v);
+		}
+
+		vec3 any_perpendicular(const vec3& normal) {
+			//cross with the axis least aligned with the normal, so the result is never tiny.
+			vec3 axis = (std::fabs(normal._x) < 0.9f) ? vec3(1.f, 0.f, 0.f) : vec3(0.f, 1.f, 0.f);
+			vec3 perpendicular = normalized_or_zero(cross_product(normal, axis));
+			return (perpendicular == vec3()) ? vec3(1.f, 0.f, 0.f) : perpendicular;
+		}
+
+	}
+
+	fbx_tangent_frame_generator::fbx_tangent_frame_generator(unsigned int thread_count, fbx_scratch_arena& arena)
+		: _thread_count(std::max(1u, thread_count))
+		, _arena(arena)
+		, _face_normals(arena)
+		, _corner_angles(arena)
+		, _face_tangents(arena)
+		, _face_bitangents(arena)
+		, _is_uv_winding_flipped(arena)
+		, _polygon_vertex_corners(arena) {
+	}
+
+	int fbx_tangent_frame_generator::generate_normals(fbx_converter_mesh_data& mesh_data) {
+		bool is_any_normal_missing = false;
+		for (int i_pv = 0; i_pv < mesh_data.get_polygon_vertex_count() && !is_any_normal_missing; ++i_pv) {
+			is_any_normal_missing = !mesh_data.has_attribute(i_pv, fbx_converter_mesh_data::HAS_NORMAL);
+		}
+		if (!is_any_normal_missing) {
+			return 0;
+		}
+		build_face_data(mesh_data);
+
+		fbx_arena_vector<int> generated_counts(mesh_data.get_control_point_count(), 0, _arena);
+		fbx_parallel_for(_thread_count, mesh_data.get_control_point_count(), MIN_CONTROL_POINTS_PER_THREAD, [&](int begin, int end) {
+			for (int i_control_point = begin; i_control_point < end; ++i_control_point) {
+				int vertex_begin = mesh_data._control_point_vertex_offsets[i_control_point];
+				int vertex_end = mesh_data._control_point_vertex_offsets[i_control_point + 1];
+
+				vec3 normal_sum;
+				for (int i = vertex_begin; i < vertex_end; ++i) {
+					int corner = _polygon_vertex_corners[mesh_data._control_point_vertices[i]];
+					normal_sum = normal_sum + _face_normals[corner / 3] * _corner_angles[corner / 3][corner % 3];
+				}
+				vec3 normal = normalized_or_zero(normal_sum);
+				if (normal == vec3()) {
+					normal = vec3(0.f, 1.f, 0.f); //only degenerate triangles use this control point
+				}
+
+				for (int i = vertex_begin; i < vertex_end; ++i) {
+					int i_pv = mesh_data._control_point_vertices[i];
+					if (!mesh_data.has_attribute(i_pv, fbx_converter_mesh_data::HAS_NORMAL)) {
+						mesh_data._normals[i_pv] = normal;
+						++generated_counts[i_control_point];
+					}
+				}
+			}
+		});
+
+		int generated_count = 0;
+		for (int count : generated_counts) {
+			generated_count += count;
+		}
+		return generated_count;
+	}
+
+	int fbx_tangent_frame_generator::generate_tangents(fbx_converter_mesh_data& mesh_data) {
+		build_face_data(mesh_data);
+		build_face_tangents(mesh_data);
+
+		fbx_arena_vector<int> generated_counts(mesh_data.get_control_point_count(), 0, _arena);
+		fbx_parallel_for(_thread_count, mesh_data.get_control_point_count(), MIN_CONTROL_POINTS_PER_THREAD, [&](int begin, int end) {
+			std::vector<int> group_vertices;
+			std::vector<bool> is_grouped;
+			for (int i_control_point = begin; i_control_point < end; ++i_control_point) {
+				int vertex_begin = mesh_data._control_point_vertex_offsets[i_control_point];
+				int vertex_end = mesh_data._control_point_vertex_offsets[i_control_point + 1];
+				is_grouped.assign(vertex_end - vertex_begin, false);
+
+				for (int i_first = vertex_begin; i_first < vertex_end; ++i_first) {
+					if (is_grouped[i_first - vertex_begin]) {
+						continue;
+					}
+
+					//corners of this control point that would weld into one vertex share their tangent frame.
+					int first_pv = mesh_data._control_point_vertices[i_first];
+					unsigned char is_first_flipped = _is_uv_winding_flipped[_polygon_vertex_corners[first_pv] / 3];
+					group_vertices.clear();
+					for (int i = i_first; i < vertex_end; ++i) {
+						int i_pv = mesh_data._control_point_vertices[i];
+						if (!is_grouped[i - vertex_begin] &&
+							mesh_data._normals[i_pv] == mesh_data._normals[first_pv] &&
+							mesh_data._uvs[i_pv] == mesh_data._uvs[first_pv] &&
+							_is_uv_winding_flipped[_polygon_vertex_corners[i_pv] / 3] == is_first_flipped) {
+							is_grouped[i - vertex_begin] = true;
+							group_vertices.push_back(i_pv);
+						}
+					}
+
+					const vec3& normal = mesh_data._normals[first_pv];
+					vec3 tangent_sum;
+					vec3 bitangent_sum;
+					for (int i_pv : group_vertices) {
+						int corner = _polygon_vertex_corners[i_pv];
+						float angle = _corner_angles[corner / 3][corner % 3];
+						tangent_sum = tangent_sum + normalized_or_zero(project_on_plane(_face_tangents[corner / 3], normal)) * angle;
+						bitangent_sum = bitangent_sum + normalized_or_zero(project_on_plane(_face_bitangents[corner / 3], normal)) * angle;
+					}
+					vec3 tangent = normalized_or_zero(project_on_plane(tangent_sum, normal));
+					if (tangent == vec3()) {
+						tangent = any_perpendicular(normal); //no usable uvs
+					}
+
+					for (int i_pv : group_vertices) {
+						if (!mesh_data.has_attribute(i_pv, fbx_converter_mesh_data::HAS_TANGENT)) {
+							mesh_data._tangents[i_pv] = tangent;
+							++generated_counts[i_control_point];
+						}
+						float handedness = dot_product(cross_product(normal, mesh_data._tangents[i_pv]), bitangent_sum);
+						mesh_data._tangent_signs[i_pv] = (handedness < 0.f) ? -1.f : 1.f;
+					}
+				}
+			}
+		});
+
+		int generated_count = 0;
+		for (int count : generated_counts) {
+			generated_count += count;
+		}
+		return generated_count;
+	}
+
+	void fbx_tangent_frame_generator::build_face_data(const fbx_converter_mesh_data& mesh_data) {
+		int triangle_count = mesh_data.get_triangle_count();
+		_face_normals.resize(triangle_count);
+		_corner_angles.resize(triangle_count);
+		_polygon_vertex_corners.assign(mesh_data.get_polygon_vertex_count(), -1);
+
+		//serial, so a polygon vertex shared by two triangles is caught rather than raced on. the per control point
+		//passes would otherwise pick either triangle depending on thread timing.
+		for (int i_triangle = 0; i_triangle < triangle_count; ++i_triangle) {
+			for (int k = 0; k < 3; ++k) {
+				int& corner = _polygon_vertex_corners[mesh_data._triangles[i_triangle][k]];
+				ASSERT(corner < 0); //each polygon vertex must belong to one triangle, as after triangulating a .fbx
+				corner = i_triangle * 3 + k;
+			}
+		}
+
+		fbx_parallel_for(_thread_count, triangle_count, MIN_TRIANGLES_PER_THREAD, [&](int begin, int end) {
+			for (int i_triangle = begin; i_triangle < end; ++i_triangle) {
+				const auto& triangle = mesh_data._triangles[i_triangle];
+				const vec3& p0 = mesh_data._positions[triangle[0]];
+				const vec3& p1 = mesh_data._positions[triangle[1]];
+				const vec3& p2 = mesh_data._positions[triangle[2]];
+
+				//mesh data is already LH but still in the .fbx winding, which build_output_mesh reverses.
+				_face_normals[i_triangle] = normalized_or_zero(cross_product(p2 - p0, p1 - p0));
+				_corner_angles[i_triangle][0] = angle_between(p1 - p0, p2 - p0);
+				_corner_angles[i_triangle][1] = angle_between(p2 - p1, p0 - p1);
+				_corner_angles[i_triangle][2] = angle_between(p0 - p2, p1 - p2);
+			}
+		});
+	}
+
+	void fbx_tangent_frame_generator::build_face_tangents(const fbx_converter_mesh_data& mesh_data) {
+		int triangle_count = mesh_data.get_triangle_count();
+		_face_tangents.resize(triangle_count);
+		_face_bitangents.resize(triangle_count);
+		_is_uv_winding_flipped.resize(triangle_count);
+
+		fbx_parallel_for(_thread_count, triangle_count, MIN_TRIANGLES_PER_THREAD, [&](int begin, int end) {
+			for (int i_triangle = begin; i_triangle < end; ++i_triangle) {
+				const auto& triangle = mesh_data._triangles[i_triangle];
+				const vec3& p0 = mesh_data._positions[triangle[0]];
+				vec3 edge1 = mesh_data._positions[triangle[1]] - p0;
+				vec3 edge2 = mesh_data._positions[triangle[2]] - p0;
+				const uv& uv0 = mesh_data._uvs[triangle[0]];
+				float du1 = mesh_data._uvs[triangle[1]]._u - uv0._u;
+				float dv1 = mesh_data._uvs[triangle[1]]._v - uv0._v;
+				float du2 = mesh_data._uvs[triangle[2]]._u - uv0._u;
+				float dv2 = mesh_data._uvs[triangle[2]]._v - uv0._v;
+
+				//only directions matter, so the 1 / determinant scale is reduced to its sign.
+				float determinant = du1 * dv2 - du2 * dv1;
+				float orientation = (determinant < 0.f) ? -1.f : 1.f;
+				_is_uv_winding_flipped[i_triangle] = (determinant < 0.f) ? 1 : 0;
+				if (determinant == 0.f) {
+					_face_tangents[i_triangle] = vec3();
+					_face_bitangents[i_triangle] = vec3();
+					continue;
+				}
+				_face_tangents[i_triangle] = normalized_or_zero((edge1 * dv2 - edge2 * dv1) * orientation);
+				_face_bitangents[i_triangle] = normalized_or_zero((edge2 * du1 - edge1 * du2) * orientation);
+			}
+		});
+	}
+
+}
\ No newline at end of file
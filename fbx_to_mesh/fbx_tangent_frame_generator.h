@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "solar/math/vec3.h"
+#include "fbx_converter_mesh_data.h"
+#include "fbx_scratch_arena.h"
+
+namespace solar {
+
+	//generates what the .fbx left out of a mesh's tangent frames.
+	//
+	//normals : smooth, the angle weighted average of the face normals around each control point.
+	//tangents : MikkTSpace style (Mikkelsen, "Simulation of Wrinkled Surfaces Revisited"). per triangle tangents
+	//and bitangents from the uv gradients are projected onto each corner's normal and summed, weighted by corner
+	//angle, over the corners sharing a control point, normal, uv and uv winding. the tangent is that sum made
+	//orthogonal to the normal and the sign is the handedness of the bitangent sum, so mirrored uvs get -1.
+	//
+	//the per triangle and per control point passes are split across threads, every thread writes its own range.
+	//per triangle scratch comes from the arena, only the owning thread allocates from it.
+	//
+	//each polygon vertex must belong to exactly one triangle, as after triangulating a .fbx. that's asserted.
+
+	class fbx_tangent_frame_generator {
+	public:
+		static const int MIN_TRIANGLES_PER_THREAD = 16 * 1024;
+		static const int MIN_CONTROL_POINTS_PER_THREAD = 8 * 1024;
+
+	private:
+		unsigned int _thread_count;
+		fbx_scratch_arena& _arena;
+		fbx_arena_vector<vec3> _face_normals; //per triangle, unit
+		fbx_arena_vector<std::array<float, 3>> _corner_angles; //per triangle
+		fbx_arena_vector<vec3> _face_tangents; //per triangle, unit or zero when the uvs are degenerate
+		fbx_arena_vector<vec3> _face_bitangents;
+		fbx_arena_vector<unsigned char> _is_uv_winding_flipped; //per triangle, bytes so threads can write neighbors
+		fbx_arena_vector<int> _polygon_vertex_corners; //per polygon vertex, triangle * 3 + corner
+
+	public:
+		fbx_tangent_frame_generator(unsigned int thread_count, fbx_scratch_arena& arena);
+
+		//fills the normals of polygon vertices without HAS_NORMAL. returns how many were generated.
+		int generate_normals(fbx_converter_mesh_data& mesh_data);
+
+		//fills the tangents of polygon vertices without HAS_TANGENT and the tangent sign of every polygon vertex,
+		//imported tangents included. normals must be complete. returns how many tangents were generated.
+		int generate_tangents(fbx_converter_mesh_data& mesh_data);
+
+	private:
+		void build_face_data(const fbx_converter_mesh_data& mesh_data);
+		void build_face_tangents(const fbx_converter_mesh_data& mesh_data);
+	};
+
+}
\ No newline at end of file
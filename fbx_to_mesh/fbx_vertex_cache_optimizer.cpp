@@ -0,0 +1,250 @@
+#include "fbx_vertex_cache_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include "solar/utility/assert.h"
+
+namespace solar {
+
+	namespace {
+
+		const float CACHE_DECAY_POWER = 1.5f;
+		const float LAST_TRIANGLE_SCORE = 0.75f;
+		const float VALENCE_BOOST_SCALE = 2.0f;
+		const float VALENCE_BOOST_POWER = 0.5f;
+
+	}
+
+	void fbx_vertex_cache_optimizer::optimize_triangle_order(const unsigned int* indices, int triangle_count, int vertex_count, std::vector<int>& triangle_order) {
+		triangle_order.clear();
+		if (triangle_count == 0) {
+			return;
+		}
+
+		build_local_indices(indices, triangle_count, vertex_count);
+		build_adjacency(triangle_count);
+
+		for (auto& v : _vertices) {
+			v._score = compute_vertex_score(v);
+		}
+
+		_triangle_scores.resize(triangle_count);
+		int best_triangle = 0;
+		for (int i_triangle = 0; i_triangle < triangle_count; ++i_triangle) {
+			_triangle_scores[i_triangle] = compute_triangle_score(i_triangle);
+			if (_triangle_scores[i_triangle] > _triangle_scores[best_triangle]) {
+				best_triangle = i_triangle;
+			}
+		}
+
+		_is_triangle_emitted.assign(triangle_count, false);
+		triangle_order.reserve(triangle_count);
+
+		int cache[CACHE_SIZE + 3];
+		int cache_count = 0;
+		int next_unemitted_triangle = 0;
+
+		while (static_cast<int>(triangle_order.size()) < triangle_count) {
+			if (best_triangle < 0) {
+				//dead end, nothing in the cache has triangles left. continue with the next triangle in input order.
+				while (_is_triangle_emitted[next_unemitted_triangle]) {
+					++next_unemitted_triangle;
+				}
+				best_triangle = next_unemitted_triangle;
+			}
+
+			_is_triangle_emitted[best_triangle] = true;
+			triangle_order.push_back(best_triangle);
+
+			const int* triangle_vertices = &_local_indices[best_triangle * 3];
+			for (int k = 0; k < 3; ++k) {
+				auto& v = _vertices[triangle_vertices[k]];
+				int* adjacency = &_adjacency[v._adjacency_offset];
+				for (int i = 0; i < v._remaining_triangle_count; ++i) {
+					if (adjacency[i] == best_triangle) {
+						adjacency[i] = adjacency[v._remaining_triangle_count - 1];
+						v._remaining_triangle_count--;
+						break;
+					}
+				}
+			}
+
+			//the emitted triangle's vertices move to the front of the cache, everything else is pushed back.
+			int new_cache[CACHE_SIZE + 3];
+			int new_cache_count = 0;
+			for (int k = 0; k < 3; ++k) {
+				int v = triangle_vertices[k];
+				bool is_duplicate = false;
+				for (int i = 0; i < new_cache_count; ++i) {
+					is_duplicate = is_duplicate || (new_cache[i] == v);
+				}
+				if (!is_duplicate) {
+					new_cache[new_cache_count++] = v;
+				}
+			}
+			for (int i = 0; i < cache_count; ++i) {
+				int v = cache[i];
+				if (v != triangle_vertices[0] && v != triangle_vertices[1] && v != triangle_vertices[2]) {
+					new_cache[new_cache_count++] = v;
+				}
+			}
+
+			for (int i = 0; i < new_cache_count; ++i) {
+				auto& v = _vertices[new_cache[i]];
+				v._cache_position = (i < CACHE_SIZE) ? i : -1;
+				v._score = compute_vertex_score(v);
+			}
+
+			//only triangles touching a vertex whose cache position changed can have a new score.
+			best_triangle = -1;
+			float best_score = -1.f;
+			for (int i = 0; i < new_cache_count; ++i) {
+				const auto& v = _vertices[new_cache[i]];
+				for (int i_adjacent = 0; i_adjacent < v._remaining_triangle_count; ++i_adjacent) {
+					int adjacent_triangle = _adjacency[v._adjacency_offset + i_adjacent];
+					float score = compute_triangle_score(adjacent_triangle);
+					_triangle_scores[adjacent_triangle] = score;
+					if (score > best_score) {
+						best_score = score;
+						best_triangle = adjacent_triangle;
+					}
+				}
+			}
+
+			cache_count = std::min(new_cache_count, static_cast<int>(CACHE_SIZE));
+			for (int i = 0; i < cache_count; ++i) {
+				cache[i] = new_cache[i];
+			}
+		}
+	}
+
+	void fbx_vertex_cache_optimizer::build_local_indices(const unsigned int* indices, int triangle_count, int vertex_count) {
+		//compact the range's vertices to [0, local_vertex_count) so per vertex state is sized by the range, not the mesh.
+		if (static_cast<int>(_global_to_local.size()) < vertex_count) {
+			_global_to_local.resize(vertex_count, -1);
+		}
+
+		std::vector<int> local_to_global;
+		_local_indices.resize(triangle_count * 3);
+		for (int i = 0; i < triangle_count * 3; ++i) {
+			int global_index = static_cast<int>(indices[i]);
+			ASSERT(global_index < vertex_count);
+			if (_global_to_local[global_index] < 0) {
+				_global_to_local[global_index] = static_cast<int>(local_to_global.size());
+				local_to_global.push_back(global_index);
+			}
+			_local_indices[i] = _global_to_local[global_index];
+		}
+
+		for (int global_index : local_to_global) {
+			_global_to_local[global_index] = -1;
+		}
+
+		vertex empty_vertex;
+		empty_vertex._cache_position = -1;
+		empty_vertex._remaining_triangle_count = 0;
+		empty_vertex._adjacency_offset = 0;
+		empty_vertex._score = 0.f;
+		_vertices.assign(local_to_global.size(), empty_vertex);
+	}
+
+	void fbx_vertex_cache_optimizer::build_adjacency(int triangle_count) {
+		for (int local_index : _local_indices) {
+			_vertices[local_index]._remaining_triangle_count++;
+		}
+
+		int offset = 0;
+		for (auto& v : _vertices) {
+			v._adjacency_offset = offset;
+			offset += v._remaining_triangle_count;
+			v._remaining_triangle_count = 0;
+		}
+
+		_adjacency.resize(offset);
+		for (int i_triangle = 0; i_triangle < triangle_count; ++i_triangle) {
+			for (int k = 0; k < 3; ++k) {
+				auto& v = _vertices[_local_indices[i_triangle * 3 + k]];
+				_adjacency[v._adjacency_offset + v._remaining_triangle_count++] = i_triangle;
+			}
+		}
+	}
+
+	float fbx_vertex_cache_optimizer::compute_vertex_score(const vertex& v) const {
+		if (v._remaining_triangle_count == 0) {
+			return -1.f; //no triangles left to use it
+		}
+
+		float score = 0.f;
+		if (v._cache_position >= 0) {
+			if (v._cache_position < 3) {
+				//used by the last triangle. a fixed score so it isn't favored over other cached vertices, otherwise the
+				//output tends to be long thin strips.
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else {
+				float scaler = 1.f / (CACHE_SIZE - 3);
+				score = std::pow(1.f - (v._cache_position - 3) * scaler, CACHE_DECAY_POWER);
+			}
+		}
+
+		//boost vertices with few triangles left so lone triangles don't get stranded.
+		score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(v._remaining_triangle_count), -VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	float fbx_vertex_cache_optimizer::compute_triangle_score(int triangle_index) const {
+		const int* triangle_vertices = &_local_indices[triangle_index * 3];
+		return
+			_vertices[triangle_vertices[0]]._score +
+			_vertices[triangle_vertices[1]]._score +
+			_vertices[triangle_vertices[2]]._score;
+	}
+
+	void fbx_vertex_cache_optimizer::build_first_use_vertex_remap(const std::vector<unsigned int>& indices, int vertex_count, std::vector<int>& remap) {
+		remap.assign(vertex_count, -1);
+
+		int next_index = 0;
+		for (unsigned int index : indices) {
+			if (remap[index] < 0) {
+				remap[index] = next_index++;
+			}
+		}
+
+		//vertices no triangle uses keep their relative order at the end.
+		for (auto& new_index : remap) {
+			if (new_index < 0) {
+				new_index = next_index++;
+			}
+		}
+	}
+
+	fbx_vertex_cache_optimizer::cache_stats fbx_vertex_cache_optimizer::measure(const std::vector<unsigned int>& indices, int vertex_count, int cache_size) {
+		//FIFO cache : a vertex is cached if fewer than cache_size misses happened since it was last loaded.
+		std::vector<int> load_times(vertex_count, -cache_size - 1);
+		std::vector<bool> is_used(vertex_count, false);
+
+		int miss_count = 0;
+		int used_vertex_count = 0;
+		for (unsigned int index : indices) {
+			if (miss_count - load_times[index] > cache_size) {
+				load_times[index] = miss_count;
+				miss_count++;
+			}
+			if (!is_used[index]) {
+				is_used[index] = true;
+				used_vertex_count++;
+			}
+		}
+
+		cache_stats stats;
+		int triangle_count = static_cast<int>(indices.size()) / 3;
+		if (triangle_count > 0) {
+			stats._acmr = static_cast<float>(miss_count) / triangle_count;
+		}
+		if (used_vertex_count > 0) {
+			stats._atvr = static_cast<float>(miss_count) / used_vertex_count;
+		}
+		return stats;
+	}
+
+}
\ No newline at end of file
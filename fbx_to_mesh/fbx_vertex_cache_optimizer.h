@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+namespace solar {
+
+	//reorders triangles for post-transform vertex cache locality (Tom Forsyth, "Linear-Speed Vertex Cache
+	//Optimisation") and renumbers vertices in first use order for vertex fetch locality.
+	//
+	//indices are triangle lists (3 per triangle). ranges are optimized independently so triangles never move
+	//between material groups.
+
+	class fbx_vertex_cache_optimizer {
+	public:
+		static const int CACHE_SIZE = 32; //size of the modeled LRU cache the scores are tuned for
+		static const int MEASURE_CACHE_SIZE = 16; //size of the FIFO cache used to report ACMR/ATVR
+
+		class cache_stats {
+		public:
+			float _acmr; //average cache miss ratio : transformed vertices per triangle, 0.5 is ideal on big meshes.
+			float _atvr; //average transform to vertex ratio : transformed vertices per vertex, 1 is ideal.
+
+		public:
+			cache_stats()
+				: _acmr(0.f)
+				, _atvr(0.f) {
+			}
+		};
+
+	private:
+		class vertex {
+		public:
+			int _cache_position;
+			int _remaining_triangle_count;
+			int _adjacency_offset;
+			float _score;
+		};
+
+		std::vector<vertex> _vertices;
+		std::vector<int> _adjacency; //per vertex, the triangles not yet emitted that use it
+		std::vector<float> _triangle_scores;
+		std::vector<bool> _is_triangle_emitted;
+		std::vector<int> _local_indices;
+		std::vector<int> _global_to_local;
+
+	public:
+		//triangle_order receives the new order as offsets from the first triangle of the range.
+		void optimize_triangle_order(const unsigned int* indices, int triangle_count, int vertex_count, std::vector<int>& triangle_order);
+
+		static void build_first_use_vertex_remap(const std::vector<unsigned int>& indices, int vertex_count, std::vector<int>& remap);
+		static cache_stats measure(const std::vector<unsigned int>& indices, int vertex_count, int cache_size = MEASURE_CACHE_SIZE);
+
+	private:
+		void build_local_indices(const unsigned int* indices, int triangle_count, int vertex_count);
+		void build_adjacency(int triangle_count);
+		float compute_vertex_score(const vertex& v) const;
+		float compute_triangle_score(int triangle_index) const;
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "fbx_vertex_deduper.h"
+
+#include <cstring>
+#include "solar/utility/assert.h"
+#include "fbx_hash.h"
+#include "fbx_parallel_for.h"
+
+namespace solar {
+
+	static_assert(sizeof(fbx_polygon_vertex_data) == 12 * sizeof(float), "fbx_polygon_vertex_data must be tightly packed to be hashed and compared as raw bytes");
+
+	namespace {
+
+		const int MIN_VERTICES_PER_THREAD = 16 * 1024;
+		const int UNIQUE_NUMBERING_CHUNK_SIZE = 64 * 1024;
+		const int EMPTY_SLOT = -1;
+		const int VERTEX_WORD_COUNT = sizeof(fbx_polygon_vertex_data) / sizeof(uint32_t); //hashed, the whole vertex
+
+		void canonicalize_signed_zeros(fbx_polygon_vertex_data& vertex) {
+			//-0 and +0 compare equal as floats but not as bytes. store them all as +0 so they still dedup.
+			float* values = reinterpret_cast<float*>(&vertex);
+			for (int i = 0; i < 12; ++i) {
+				if (values[i] == 0.f) {
+					values[i] = 0.f;
+				}
+			}
+		}
+
+		int get_partition_bits(unsigned int thread_count) {
+			//a few partitions per thread keeps the threads busy when partitions are unevenly sized.
+			int bits = 0;
+			while ((1u << bits) < thread_count * 4 && bits < 10) {
+				++bits;
+			}
+			return bits;
+		}
+
+		int get_table_size(int count) {
+			//power of two with a load factor of at most 0.5
+			int size = 16;
+			while (size < count * 2) {
+				size <<= 1;
+			}
+			return size;
+		}
+
+	}
+
+	fbx_vertex_deduper::fbx_vertex_deduper(unsigned int thread_count, fbx_scratch_arena& arena)
+		: _thread_count(std::max(1u, thread_count))
+		, _arena(arena)
+		, _vertices(arena)
+		, _hashes(arena)
+		, _partition_offsets(arena)
+		, _partition_vertices(arena)
+		, _table_offsets(arena)
+		, _tables(arena)
+		, _first_vertices(arena) {
+	}
+
+	void fbx_vertex_deduper::dedup(
+		const fbx_converter_mesh_data& mesh_data,
+		std::vector<fbx_polygon_vertex_data>& unique_vertices,
+		std::vector<int>& unique_vertex_indices) {
+
+		gather_and_hash_vertices(mesh_data);
+
+		int vertex_count = static_cast<int>(_vertices.size());
+		int partition_bits = (vertex_count < MIN_VERTICES_PER_THREAD) ? 0 : get_partition_bits(_thread_count);
+		partition_vertices(partition_bits);
+
+		_first_vertices.resize(vertex_count);
+		int partition_count = 1 << partition_bits;
+		allocate_tables(partition_count);
+		fbx_parallel_for(_thread_count, partition_count, 1, [&](int begin, int end) {
+			for (int i_partition = begin; i_partition < end; ++i_partition) {
+				resolve_partition(i_partition);
+			}
+		});
+
+		number_unique_vertices(unique_vertices, unique_vertex_indices);
+	}
+
+	void fbx_vertex_deduper::gather_and_hash_vertices(const fbx_converter_mesh_data& mesh_data) {
+		int vertex_count = mesh_data.get_polygon_vertex_count();
+		_vertices.resize(vertex_count);
+		_hashes.resize(vertex_count);
+
+		fbx_parallel_for(_thread_count, vertex_count, MIN_VERTICES_PER_THREAD, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i) {
+				_vertices[i] = mesh_data.get_polygon_vertex_data(i);
+				canonicalize_signed_zeros(_vertices[i]);
+				_hashes[i] = hash_vertex(_vertices[i]);
+			}
+		});
+	}
+
+	void fbx_vertex_deduper::partition_vertices(int partition_bits) {
+		//counting sort on the high bits of the hash. vertices stay in ascending order within a partition,
+		//which is what makes the first occurrence of each vertex win.
+		int partition_count = 1 << partition_bits;
+		int shift = 64 - partition_bits;
+		auto get_partition = [&](int i) {
+			return (partition_bits == 0) ? 0 : static_cast<int>(_hashes[i] >> shift);
+		};
+
+		int vertex_count = static_cast<int>(_vertices.size());
+
+		_partition_offsets.assign(partition_count + 1, 0);
+		for (int i = 0; i < vertex_count; ++i) {
+			_partition_offsets[get_partition(i) + 1]++;
+		}
+		for (int i = 0; i < partition_count; ++i) {
+			_partition_offsets[i + 1] += _partition_offsets[i];
+		}
+
+		fbx_arena_vector<int> cursors(_partition_offsets.begin(), _partition_offsets.end() - 1, _arena);
+		_partition_vertices.resize(vertex_count);
+		for (int i = 0; i < vertex_count; ++i) {
+			_partition_vertices[cursors[get_partition(i)]++] = i;
+		}
+	}
+
+	void fbx_vertex_deduper::allocate_tables(int partition_count) {
+		_table_offsets.resize(partition_count + 1);
+		_table_offsets[0] = 0;
+		for (int i_partition = 0; i_partition < partition_count; ++i_partition) {
+			int count = _partition_offsets[i_partition + 1] - _partition_offsets[i_partition];
+			_table_offsets[i_partition + 1] = _table_offsets[i_partition] + get_table_size(count);
+		}
+		_tables.resize(_table_offsets[partition_count]);
+	}
+
+	void fbx_vertex_deduper::resolve_partition(int partition_index) {
+		int begin = _partition_offsets[partition_index];
+		int end = _partition_offsets[partition_index + 1];
+
+		int table_size = _table_offsets[partition_index + 1] - _table_offsets[partition_index];
+		uint64_t table_mask = static_cast<uint64_t>(table_size - 1);
+		int* table = &_tables[_table_offsets[partition_index]];
+		std::fill(table, table + table_size, EMPTY_SLOT); //here rather than up front, so each thread touches its own
+
+		for (int i = begin; i < end; ++i) {
+			int vertex_index = _partition_vertices[i];
+			uint64_t hash = _hashes[vertex_index];
+
+			//low bits pick the slot, the high bits were already spent on the partition.
+			uint64_t slot = hash & table_mask;
+			for (;;) {
+				int slot_vertex_index = table[slot];
+				if (slot_vertex_index == EMPTY_SLOT) {
+					table[slot] = vertex_index;
+					_first_vertices[vertex_index] = vertex_index;
+					break;
+				}
+				if (_hashes[slot_vertex_index] == hash && are_vertices_identical(_vertices[slot_vertex_index], _vertices[vertex_index])) {
+					_first_vertices[vertex_index] = slot_vertex_index;
+					break;
+				}
+				slot = (slot + 1) & table_mask;
+			}
+		}
+	}
+
+	void fbx_vertex_deduper::number_unique_vertices(std::vector<fbx_polygon_vertex_data>& unique_vertices, std::vector<int>& unique_vertex_indices) {
+		//unique vertices are numbered in order of first appearance. each chunk counts its first occurrences, a prefix
+		//sum over the chunks gives every chunk its starting unique index.
+		int vertex_count = static_cast<int>(_vertices.size());
+		int chunk_count = (vertex_count + UNIQUE_NUMBERING_CHUNK_SIZE - 1) / UNIQUE_NUMBERING_CHUNK_SIZE;
+		auto get_chunk_begin = [&](int i_chunk) { return i_chunk * UNIQUE_NUMBERING_CHUNK_SIZE; };
+		auto get_chunk_end = [&](int i_chunk) { return std::min(vertex_count, (i_chunk + 1) * UNIQUE_NUMBERING_CHUNK_SIZE); };
+
+		fbx_arena_vector<int> chunk_offsets(chunk_count + 1, 0, _arena);
+		fbx_parallel_for(_thread_count, chunk_count, 1, [&](int begin, int end) {
+			for (int i_chunk = begin; i_chunk < end; ++i_chunk) {
+				int count = 0;
+				for (int i = get_chunk_begin(i_chunk); i < get_chunk_end(i_chunk); ++i) {
+					count += (_first_vertices[i] == i) ? 1 : 0;
+				}
+				chunk_offsets[i_chunk + 1] = count;
+			}
+		});
+		for (int i_chunk = 0; i_chunk < chunk_count; ++i_chunk) {
+			chunk_offsets[i_chunk + 1] += chunk_offsets[i_chunk];
+		}
+
+		unique_vertices.resize(chunk_offsets[chunk_count]);
+		unique_vertex_indices.resize(vertex_count);
+
+		fbx_parallel_for(_thread_count, chunk_count, 1, [&](int begin, int end) {
+			for (int i_chunk = begin; i_chunk < end; ++i_chunk) {
+				int unique_index = chunk_offsets[i_chunk];
+				for (int i = get_chunk_begin(i_chunk); i < get_chunk_end(i_chunk); ++i) {
+					if (_first_vertices[i] == i) {
+						unique_vertices[unique_index] = _vertices[i];
+						unique_vertex_indices[i] = unique_index;
+						unique_index++;
+					}
+				}
+			}
+		});
+
+		//duplicates always point back at an earlier first occurrence, which was numbered above.
+		fbx_parallel_for(_thread_count, vertex_count, MIN_VERTICES_PER_THREAD, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i) {
+				if (_first_vertices[i] != i) {
+					unique_vertex_indices[i] = unique_vertex_indices[_first_vertices[i]];
+				}
+			}
+		});
+	}
+
+	uint64_t fbx_vertex_deduper::hash_vertex(const fbx_polygon_vertex_data& vertex) {
+		uint32_t words[VERTEX_WORD_COUNT];
+		std::memcpy(words, &vertex, sizeof(words));
+		return mix_fbx_hash(add_fbx_hash_words(FBX_HASH_SEED, words, VERTEX_WORD_COUNT));
+	}
+
+	bool fbx_vertex_deduper::are_vertices_identical(const fbx_polygon_vertex_data& a, const fbx_polygon_vertex_data& b) {
+		return std::memcmp(&a, &b, sizeof(fbx_polygon_vertex_data)) == 0;
+	}
+
+}
\ No newline at end of file
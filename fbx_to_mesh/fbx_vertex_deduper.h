@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "fbx_converter_mesh_data.h"
+#include "fbx_polygon_vertex_data.h"
+#include "fbx_scratch_arena.h"
+
+namespace solar {
+
+	//collapses polygon vertices with bit identical data (position,normal,tangent,uv) into unique vertices.
+	//
+	//vertices are hashed on their raw bytes and split into partitions by the high bits of the hash. each partition
+	//owns an open addressing table sized up front and is resolved on its own thread. collisions are resolved by
+	//comparing the full vertex, so two different vertices are never merged.
+	//
+	//output is deterministic and independent of thread count : a duplicate always maps to the first polygon vertex
+	//with the same data, and unique vertices are numbered in order of first appearance.
+	//
+	//scratch memory comes from the arena, the partition tables are allocated up front so the threads never allocate.
+
+	class fbx_vertex_deduper {
+	private:
+		unsigned int _thread_count;
+
+		fbx_scratch_arena& _arena;
+		fbx_arena_vector<fbx_polygon_vertex_data> _vertices;
+		fbx_arena_vector<uint64_t> _hashes;
+		fbx_arena_vector<int> _partition_offsets;
+		fbx_arena_vector<int> _partition_vertices;
+		fbx_arena_vector<int> _table_offsets; //per partition, into _tables
+		fbx_arena_vector<int> _tables;
+		fbx_arena_vector<int> _first_vertices; //per polygon vertex, the first polygon vertex with identical data.
+
+	public:
+		fbx_vertex_deduper(unsigned int thread_count, fbx_scratch_arena& arena);
+
+		void dedup(
+			const fbx_converter_mesh_data& mesh_data,
+			std::vector<fbx_polygon_vertex_data>& unique_vertices,
+			std::vector<int>& unique_vertex_indices);
+
+	private:
+		void gather_and_hash_vertices(const fbx_converter_mesh_data& mesh_data);
+		void partition_vertices(int partition_bits);
+		void allocate_tables(int partition_count);
+		void resolve_partition(int partition_index);
+		void number_unique_vertices(std::vector<fbx_polygon_vertex_data>& unique_vertices, std::vector<int>& unique_vertex_indices);
+
+	public:
+		static uint64_t hash_vertex(const fbx_polygon_vertex_data& vertex);
+		static bool are_vertices_identical(const fbx_polygon_vertex_data& a, const fbx_polygon_vertex_data& b);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "fbx_vertex_packer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace solar {
+
+	namespace {
+
+		const float RADIANS_TO_DEGREES = 57.2957795f;
+
+		float dot_product(const vec3& a, const vec3& b) {
+			return a._x * b._x + a._y * b._y + a._z * b._z;
+		}
+
+		float sign_not_zero(float value) {
+			return (value >= 0.f) ? 1.f : -1.f;
+		}
+
+		uint16_t quantize_unorm16(float value, float min, float extent) {
+			if (extent <= 0.f) {
+				return 0;
+			}
+			float scaled = (value - min) / extent * 65535.f + 0.5f;
+			return static_cast<uint16_t>(std::min(65535.f, std::max(0.f, scaled)));
+		}
+
+		float dequantize_unorm16(uint16_t value, float min, float extent) {
+			return min + extent * (value / 65535.f);
+		}
+
+		float angle_degrees(const vec3& original, const vec3& decoded) {
+			float length = std::sqrt(dot_product(original, original));
+			if (length == 0.f) {
+				return 0.f; //missing data, nothing to lose
+			}
+			float cos_angle = dot_product(original, decoded) / length;
+			return std::acos(std::min(1.f, std::max(-1.f, cos_angle))) * RADIANS_TO_DEGREES;
+		}
+
+	}
+
+	fbx_vertex_packer::fbx_vertex_packer() {
+	}
+
+	void fbx_vertex_packer::pack(const std::vector<fbx_polygon_vertex_data>& vertices, std::vector<fbx_packed_vertex>& packed_vertices) {
+		_position_min = vec3();
+		_position_extent = vec3();
+		if (!vertices.empty()) {
+			vec3 position_max = vertices.front()._position;
+			_position_min = position_max;
+			for (const auto& vertex : vertices) {
+				const auto& p = vertex._position;
+				_position_min = vec3(std::min(_position_min._x, p._x), std::min(_position_min._y, p._y), std::min(_position_min._z, p._z));
+				position_max = vec3(std::max(position_max._x, p._x), std::max(position_max._y, p._y), std::max(position_max._z, p._z));
+			}
+			_position_extent = position_max - _position_min;
+		}
+
+		packed_vertices.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			const auto& vertex = vertices[i];
+			auto& packed_vertex = packed_vertices[i];
+			packed_vertex._position[0] = quantize_unorm16(vertex._position._x, _position_min._x, _position_extent._x);
+			packed_vertex._position[1] = quantize_unorm16(vertex._position._y, _position_min._y, _position_extent._y);
+			packed_vertex._position[2] = quantize_unorm16(vertex._position._z, _position_min._z, _position_extent._z);
+			packed_vertex._position[3] = (vertex._tangent_sign < 0.f) ? 0 : 65535;
+			encode_octahedral(vertex._normal, packed_vertex._normal_tangent[0], packed_vertex._normal_tangent[1]);
+			encode_octahedral(vertex._tangent, packed_vertex._normal_tangent[2], packed_vertex._normal_tangent[3]);
+			packed_vertex._uv[0] = float_to_half(vertex._uv._u);
+			packed_vertex._uv[1] = float_to_half(vertex._uv._v);
+		}
+	}
+
+	const vec3& fbx_vertex_packer::get_position_min() const {
+		return _position_min;
+	}
+
+	const vec3& fbx_vertex_packer::get_position_extent() const {
+		return _position_extent;
+	}
+
+	fbx_vertex_packer::error_bounds fbx_vertex_packer::measure_error_bounds(const std::vector<fbx_polygon_vertex_data>& vertices, const std::vector<fbx_packed_vertex>& packed_vertices) const {
+		//measured by decoding every vertex rather than derived from the bit counts, so it is the real worst case.
+		error_bounds bounds;
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			const auto& vertex = vertices[i];
+			const auto& packed_vertex = packed_vertices[i];
+
+			vec3 position_error = decode_position(packed_vertex) - vertex._position;
+			bounds._position = std::max({ bounds._position, std::abs(position_error._x), std::abs(position_error._y), std::abs(position_error._z) });
+
+			vec3 normal = decode_octahedral(packed_vertex._normal_tangent[0], packed_vertex._normal_tangent[1]);
+			vec3 tangent = decode_octahedral(packed_vertex._normal_tangent[2], packed_vertex._normal_tangent[3]);
+			bounds._normal_degrees = std::max(bounds._normal_degrees, angle_degrees(vertex._normal, normal));
+			bounds._tangent_degrees = std::max(bounds._tangent_degrees, angle_degrees(vertex._tangent, tangent));
+
+			bounds._uv = std::max({
+				bounds._uv,
+				std::abs(half_to_float(packed_vertex._uv[0]) - vertex._uv._u),
+				std::abs(half_to_float(packed_vertex._uv[1]) - vertex._uv._v) });
+		}
+		return bounds;
+	}
+
+	vec3 fbx_vertex_packer::decode_position(const fbx_packed_vertex& packed_vertex) const {
+		return vec3(
+			dequantize_unorm16(packed_vertex._position[0], _position_min._x, _position_extent._x),
+			dequantize_unorm16(packed_vertex._position[1], _position_min._y, _position_extent._y),
+			dequantize_unorm16(packed_vertex._position[2], _position_min._z, _position_extent._z));
+	}
+
+	void fbx_vertex_packer::encode_octahedral(const vec3& v, int8_t& x, int8_t& y) {
+		//project onto the octahedron |x|+|y|+|z| = 1 and fold the lower half over the upper one.
+		float l1_length = std::abs(v._x) + std::abs(v._y) + std::abs(v._z);
+		if (l1_length == 0.f) {
+			x = 0;
+			y = 0;
+			return;
+		}
+
+		float px = v._x / l1_length;
+		float py = v._y / l1_length;
+		if (v._z < 0.f) {
+			float folded_x = (1.f - std::abs(py)) * sign_not_zero(px);
+			float folded_y = (1.f - std::abs(px)) * sign_not_zero(py);
+			px = folded_x;
+			py = folded_y;
+		}
+
+		//rounding each axis on its own is not the closest direction, try all 4 neighbours of the exact point.
+		vec3 unit_v = v * (1.f / std::sqrt(dot_product(v, v)));
+		float best_dot = -2.f;
+		float base_x = std::floor(px * 127.f);
+		float base_y = std::floor(py * 127.f);
+		for (int dx = 0; dx < 2; ++dx) {
+			for (int dy = 0; dy < 2; ++dy) {
+				auto candidate_x = static_cast<int8_t>(std::min(127.f, std::max(-127.f, base_x + dx)));
+				auto candidate_y = static_cast<int8_t>(std::min(127.f, std::max(-127.f, base_y + dy)));
+				float candidate_dot = dot_product(unit_v, decode_octahedral(candidate_x, candidate_y));
+				if (candidate_dot > best_dot) {
+					best_dot = candidate_dot;
+					x = candidate_x;
+					y = candidate_y;
+				}
+			}
+		}
+	}
+
+	vec3 fbx_vertex_packer::decode_octahedral(int8_t x, int8_t y) {
+		float px = std::max(-1.f, x / 127.f);
+		float py = std::max(-1.f, y / 127.f);
+		float pz = 1.f - std::abs(px) - std::abs(py);
+		if (pz < 0.f) {
+			float unfolded_x = (1.f - std::abs(py)) * sign_not_zero(px);
+			float unfolded_y = (1.f - std::abs(px)) * sign_not_zero(py);
+			px = unfolded_x;
+			py = unfolded_y;
+		}
+		vec3 v(px, py, pz);
+		return v * (1.f / std::sqrt(dot_product(v, v)));
+	}
+
+	uint16_t fbx_vertex_packer::float_to_half(float value) {
+		//round to nearest even, overflow goes to infinity and tiny values to half denormals or zero.
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		uint32_t sign = (bits >> 16) & 0x8000;
+		int exponent = static_cast<int>((bits >> 23) & 0xff);
+		uint32_t mantissa = bits & 0x7fffff;
+
+		if (exponent == 0xff) {
+			return static_cast<uint16_t>(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+		}
+
+		int half_exponent = exponent - 127 + 15;
+		if (half_exponent >= 0x1f) {
+			return static_cast<uint16_t>(sign | 0x7c00);
+		}
+
+		if (half_exponent <= 0) {
+			if (half_exponent < -10) {
+				return static_cast<uint16_t>(sign);
+			}
+			mantissa |= 0x800000;
+			int shift = 14 - half_exponent;
+			uint32_t half_mantissa = mantissa >> shift;
+			uint32_t remainder = mantissa & ((1u << shift) - 1);
+			uint32_t halfway = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (half_mantissa & 1) != 0)) {
+				half_mantissa++;
+			}
+			return static_cast<uint16_t>(sign | half_mantissa);
+		}
+
+		uint32_t half_bits = (static_cast<uint32_t>(half_exponent) << 10) | (mantissa >> 13);
+		uint32_t remainder = mantissa & 0x1fff;
+		if (remainder > 0x1000 || (remainder == 0x1000 && (half_bits & 1) != 0)) {
+			half_bits++; //a carry out of the mantissa correctly bumps the exponent
+		}
+		return static_cast<uint16_t>(sign | half_bits);
+	}
+
+	float fbx_vertex_packer::half_to_float(uint16_t value) {
+		uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+		uint32_t exponent = (value >> 10) & 0x1f;
+		uint32_t mantissa = value & 0x3ff;
+
+		if (exponent == 0) {
+			float denormal = std::ldexp(static_cast<float>(mantissa), -24);
+			return (sign != 0) ? -denormal : denormal;
+		}
+
+		uint32_t bits = (exponent == 0x1f)
+			? (sign | 0x7f800000 | (mantissa << 13))
+			: (sign | ((exponent - 15 + 127) << 23) | (mantissa << 13));
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+}
\ No newline at end of file
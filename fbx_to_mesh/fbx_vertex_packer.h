@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "solar/math/vec3.h"
+#include "fbx_polygon_vertex_data.h"
+
+namespace solar {
+
+	//16 byte vertex, laid out so each field maps to a GPU vertex format :
+	//- _position : R16G16B16A16_UNORM, xyz quantized against the mesh bounds, w is the tangent handedness (0 is -1, 65535 is +1).
+	//- _normal_tangent : R8G8B8A8_SNORM, octahedral normal in xy and octahedral tangent in zw.
+	//- _uv : R16G16_FLOAT.
+	class fbx_packed_vertex {
+	public:
+		uint16_t _position[4];
+		int8_t _normal_tangent[4];
+		uint16_t _uv[2];
+	};
+
+	static_assert(sizeof(fbx_packed_vertex) == 16, "fbx_packed_vertex is read directly by the GPU");
+
+	//packs full float vertices into fbx_packed_vertex and measures the worst error each attribute picked up.
+
+	class fbx_vertex_packer {
+	public:
+		static const int FORMAT_VERSION = 1; //bump whenever the packed layout or its encoding changes
+
+		class error_bounds {
+		public:
+			float _position; //max distance along any axis, in mesh units
+			float _normal_degrees; //max angle between original and decoded
+			float _tangent_degrees;
+			float _uv; //max difference along u or v
+
+		public:
+			error_bounds()
+				: _position(0.f)
+				, _normal_degrees(0.f)
+				, _tangent_degrees(0.f)
+				, _uv(0.f) {
+			}
+		};
+
+	private:
+		vec3 _position_min;
+		vec3 _position_extent;
+
+	public:
+		fbx_vertex_packer();
+
+		void pack(const std::vector<fbx_polygon_vertex_data>& vertices, std::vector<fbx_packed_vertex>& packed_vertices);
+
+		//decoded position = min + extent * quantized / 65535. valid after pack.
+		const vec3& get_position_min() const;
+		const vec3& get_position_extent() const;
+
+		error_bounds measure_error_bounds(const std::vector<fbx_polygon_vertex_data>& vertices, const std::vector<fbx_packed_vertex>& packed_vertices) const;
+
+		vec3 decode_position(const fbx_packed_vertex& packed_vertex) const;
+		static void encode_octahedral(const vec3& v, int8_t& x, int8_t& y);
+		static vec3 decode_octahedral(int8_t x, int8_t y);
+		static uint16_t float_to_half(float value);
+		static float half_to_float(uint16_t value);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "fbx_vertex_welder.h"
+
+#include <algorithm>
+#include <cmath>
+#include "solar/utility/assert.h"
+#include "fbx_hash.h"
+#include "fbx_parallel_for.h"
+
+namespace solar {
+
+	namespace {
+
+		const int EMPTY_SLOT = -1;
+		const double MAX_CELL_COORDINATE = 1 << 30; //far from overflowing when the neighbors are offset by 1
+
+		float dot_product(const vec3& a, const vec3& b) {
+			return a._x * b._x + a._y * b._y + a._z * b._z;
+		}
+
+		bool is_angle_within(const vec3& a, const vec3& b, float cos_max_angle) {
+			//not assuming unit vectors, imported normals and tangents aren't always normalized.
+			return dot_product(a, b) >= cos_max_angle * std::sqrt(dot_product(a, a) * dot_product(b, b));
+		}
+
+		int32_t quantize(float value, double inverse_cell_size, int32_t& neighbor_offset) {
+			double scaled = static_cast<double>(value) * inverse_cell_size;
+			double cell = std::floor(scaled);
+			neighbor_offset = (scaled - cell < 0.5) ? -1 : 1;
+			return static_cast<int32_t>(std::max(-MAX_CELL_COORDINATE, std::min(MAX_CELL_COORDINATE, cell)));
+		}
+
+		int get_table_size(int count) {
+			//power of two with a load factor of at most 0.5
+			int size = 16;
+			while (size < count * 2) {
+				size <<= 1;
+			}
+			return size;
+		}
+
+	}
+
+	fbx_vertex_welder::fbx_vertex_welder(unsigned int thread_count, fbx_scratch_arena& arena)
+		: _thread_count(std::max(1u, thread_count))
+		, _arena(arena)
+		, _vertex_cells(arena)
+		, _neighbor_offsets(arena)
+		, _cell_hashes(arena)
+		, _vertex_cell_indices(arena)
+		, _cells(arena)
+		, _table(arena)
+		, _next_representatives(arena)
+		, _welded_vertices(arena) {
+	}
+
+	fbx_vertex_welder::result fbx_vertex_welder::weld(
+		const tolerances& tolerances,
+		fbx_converter_mesh_data& mesh_data,
+		std::vector<fbx_polygon_vertex_data>& vertices) {
+
+		ASSERT(tolerances._position > 0.f);
+		int vertex_count = static_cast<int>(vertices.size());
+		build_grid(vertices, tolerances._position * 2.f);
+		weld_vertices(tolerances, vertices);
+
+		result weld_result;
+		weld_result._removed_triangle_count = remove_collapsed_triangles(mesh_data);
+		number_welded_vertices(mesh_data, vertices);
+		weld_result._merged_vertex_count = vertex_count - static_cast<int>(vertices.size());
+		return weld_result;
+	}
+
+	uint64_t fbx_vertex_welder::hash_cell(int32_t x, int32_t y, int32_t z) {
+		uint64_t h = add_fbx_hash_word(FBX_HASH_SEED, static_cast<uint32_t>(x));
+		h = add_fbx_hash_word(h, static_cast<uint32_t>(y));
+		h = add_fbx_hash_word(h, static_cast<uint32_t>(z));
+		return mix_fbx_hash(h);
+	}
+
+	void fbx_vertex_welder::build_grid(const std::vector<fbx_polygon_vertex_data>& vertices, float cell_size) {
+		//a vertex in the lower half of its cell on an axis can only reach the lower neighbor within half a cell, and
+		//the other way around.
+		int vertex_count = static_cast<int>(vertices.size());
+		double inverse_cell_size = 1.0 / cell_size;
+		_vertex_cells.resize(vertex_count);
+		_neighbor_offsets.resize(vertex_count);
+		_cell_hashes.resize(vertex_count);
+		fbx_parallel_for(_thread_count, vertex_count, MIN_VERTICES_PER_THREAD, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i) {
+				const vec3& position = vertices[i]._position;
+				auto& vertex_cell = _vertex_cells[i];
+				auto& neighbor_offset = _neighbor_offsets[i];
+				vertex_cell[0] = quantize(position._x, inverse_cell_size, neighbor_offset[0]);
+				vertex_cell[1] = quantize(position._y, inverse_cell_size, neighbor_offset[1]);
+				vertex_cell[2] = quantize(position._z, inverse_cell_size, neighbor_offset[2]);
+				_cell_hashes[i] = hash_cell(vertex_cell[0], vertex_cell[1], vertex_cell[2]);
+			}
+		});
+
+		_cells.clear();
+		_table.assign(get_table_size(vertex_count), EMPTY_SLOT);
+		_vertex_cell_indices.resize(vertex_count);
+		for (int i = 0; i < vertex_count; ++i) {
+			_vertex_cell_indices[i] = insert_cell(i);
+		}
+	}
+
+	int fbx_vertex_welder::insert_cell(int vertex_index) {
+		const auto& vertex_cell = _vertex_cells[vertex_index];
+		uint64_t table_mask = static_cast<uint64_t>(_table.size() - 1);
+		for (uint64_t slot = _cell_hashes[vertex_index] & table_mask;; slot = (slot + 1) & table_mask) {
+			int cell_index = _table[slot];
+			if (cell_index == EMPTY_SLOT) {
+				cell new_cell;
+				new_cell._x = vertex_cell[0];
+				new_cell._y = vertex_cell[1];
+				new_cell._z = vertex_cell[2];
+				new_cell._first_representative = -1;
+				new_cell._last_representative = -1;
+				new_cell._representative_count = 0;
+				_table[slot] = static_cast<int>(_cells.size());
+				_cells.push_back(new_cell);
+				return _table[slot];
+			}
+			const auto& existing_cell = _cells[cell_index];
+			if (existing_cell._x == vertex_cell[0] && existing_cell._y == vertex_cell[1] && existing_cell._z == vertex_cell[2]) {
+				return cell_index;
+			}
+		}
+	}
+
+	void fbx_vertex_welder::add_representative(int cell_index, int vertex_index) {
+		//vertices are welded in order, so each cell's representatives are linked in ascending order.
+		auto& cell = _cells[cell_index];
+		if (cell._representative_count >= MAX_CELL_REPRESENTATIVE_COUNT) {
+			return;
+		}
+		if (cell._last_representative < 0) {
+			cell._first_representative = vertex_index;
+		}
+		else {
+			_next_representatives[cell._last_representative] = vertex_index;
+		}
+		cell._last_representative = vertex_index;
+		cell._representative_count++;
+	}
+
+	int fbx_vertex_welder::find_cell(int32_t x, int32_t y, int32_t z, uint64_t hash) const {
+		uint64_t table_mask = static_cast<uint64_t>(_table.size() - 1);
+		for (uint64_t slot = hash & table_mask;; slot = (slot + 1) & table_mask) {
+			int cell_index = _table[slot];
+			if (cell_index == EMPTY_SLOT) {
+				return -1;
+			}
+			const auto& existing_cell = _cells[cell_index];
+			if (existing_cell._x == x && existing_cell._y == y && existing_cell._z == z) {
+				return cell_index;
+			}
+		}
+	}
+
+	void fbx_vertex_welder::weld_vertices(const tolerances& tolerances, const std::vector<fbx_polygon_vertex_data>& vertices) {
+		//serial, each vertex depends on which earlier vertices kept their own data. the neighbor cells are the costly
+		//part and they're mostly cache hits, vertices arrive in mesh order.
+		const float DEGREES_TO_RADIANS = 3.14159265f / 180.f;
+		float squared_position = tolerances._position * tolerances._position;
+		float cos_normal = std::cos(tolerances._normal_degrees * DEGREES_TO_RADIANS);
+		float cos_tangent = std::cos(tolerances._tangent_degrees * DEGREES_TO_RADIANS);
+		auto is_weldable = [&](const fbx_polygon_vertex_data& a, const fbx_polygon_vertex_data& b) {
+			vec3 offset = a._position - b._position;
+			return
+				dot_product(offset, offset) <= squared_position &&
+				std::fabs(a._uv._u - b._uv._u) <= tolerances._uv &&
+				std::fabs(a._uv._v - b._uv._v) <= tolerances._uv &&
+				a._tangent_sign == b._tangent_sign &&
+				is_angle_within(a._normal, b._normal, cos_normal) &&
+				is_angle_within(a._tangent, b._tangent, cos_tangent);
+		};
+
+		int vertex_count = static_cast<int>(vertices.size());
+		_welded_vertices.resize(vertex_count);
+		_next_representatives.assign(vertex_count, -1);
+		for (int i = 0; i < vertex_count; ++i) {
+			const auto& vertex_cell = _vertex_cells[i];
+			const auto& neighbor_offset = _neighbor_offsets[i];
+			int welded_vertex = i;
+			for (int i_cell = 0; i_cell < 8; ++i_cell) {
+				int cell_index = _vertex_cell_indices[i];
+				if (i_cell > 0) {
+					int32_t x = vertex_cell[0] + ((i_cell & 1) ? neighbor_offset[0] : 0);
+					int32_t y = vertex_cell[1] + ((i_cell & 2) ? neighbor_offset[1] : 0);
+					int32_t z = vertex_cell[2] + ((i_cell & 4) ? neighbor_offset[2] : 0);
+					cell_index = find_cell(x, y, z, hash_cell(x, y, z));
+					if (cell_index < 0) {
+						continue;
+					}
+				}
+				//ascending, the first match is the cell's earliest and nothing past welded_vertex can win.
+				for (int j = _cells[cell_index]._first_representative; j >= 0 && j < welded_vertex; j = _next_representatives[j]) {
+					if (is_weldable(vertices[j], vertices[i])) {
+						welded_vertex = j;
+						break;
+					}
+				}
+			}
+			_welded_vertices[i] = welded_vertex;
+			if (welded_vertex == i) {
+				add_representative(_vertex_cell_indices[i], i);
+			}
+		}
+	}
+
+	int fbx_vertex_welder::remove_collapsed_triangles(fbx_converter_mesh_data& mesh_data) const {
+		const auto& unduped_indices = mesh_data._unduped_vertex_indices;
+		auto get_welded_vertex = [&](int polygon_vertex_index) {
+			return _welded_vertices[unduped_indices[polygon_vertex_index]];
+		};
+
+		int triangle_count = mesh_data.get_triangle_count();
+		int kept_count = 0;
+		for (int i_triangle = 0; i_triangle < triangle_count; ++i_triangle) {
+			const auto& triangle = mesh_data._triangles[i_triangle];
+			int v0 = get_welded_vertex(triangle[0]);
+			int v1 = get_welded_vertex(triangle[1]);
+			int v2 = get_welded_vertex(triangle[2]);
+			if (v0 == v1 || v1 == v2 || v2 == v0) {
+				continue;
+			}
+			mesh_data._triangles[kept_count] = triangle;
+			mesh_data._material_indices[kept_count] = mesh_data._material_indices[i_triangle];
+			++kept_count;
+		}
+		mesh_data._triangles.resize(kept_count);
+		mesh_data._material_indices.resize(kept_count);
+		return triangle_count - kept_count;
+	}
+
+	void fbx_vertex_welder::number_welded_vertices(fbx_converter_mesh_data& mesh_data, std::vector<fbx_polygon_vertex_data>& vertices) const {
+		//numbered from the kept triangles' corners only, a vertex whose triangles all collapsed would otherwise stay
+		//in the vertex buffer unused. each polygon vertex belongs to one triangle, so it's renumbered once.
+		fbx_arena_vector<int> numbers(vertices.size(), -1, _arena);
+		fbx_arena_vector<int> new_unduped_indices(mesh_data._unduped_vertex_indices.size(), -1, _arena);
+		std::vector<fbx_polygon_vertex_data> welded_vertices;
+		for (const auto& triangle : mesh_data._triangles) {
+			for (int polygon_vertex_index : triangle) {
+				int welded_vertex = _welded_vertices[mesh_data._unduped_vertex_indices[polygon_vertex_index]];
+				if (numbers[welded_vertex] < 0) {
+					numbers[welded_vertex] = static_cast<int>(welded_vertices.size());
+					welded_vertices.push_back(vertices[welded_vertex]);
+				}
+				new_unduped_indices[polygon_vertex_index] = numbers[welded_vertex];
+			}
+		}
+		std::copy(new_unduped_indices.begin(), new_unduped_indices.end(), mesh_data._unduped_vertex_indices.begin());
+		vertices.swap(welded_vertices);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "fbx_converter_mesh_data.h"
+#include "fbx_polygon_vertex_data.h"
+#include "fbx_scratch_arena.h"
+
+namespace solar {
+
+	//merges unique vertices that only differ by float noise, which exact dedup (fbx_vertex_deduper) keeps apart.
+	//
+	//vertices are bucketed in a uniform grid with cells twice the position tolerance, found through an open
+	//addressing table keyed on the quantized position. a vertex can only weld to vertices in the 8 cells its
+	//tolerance reaches : its own and, on each axis, the neighbor on the side of the cell it lies in. so welding
+	//stays close to linear however big the mesh is.
+	//
+	//vertices are visited in order and weld to the first earlier vertex that kept its own data and is within every
+	//tolerance of it. merged vertices take that vertex's data as is, so they never drift further than the
+	//tolerances, and the output doesn't depend on the thread count. a cell only links the vertices that kept their
+	//own data, at most MAX_CELL_REPRESENTATIVE_COUNT of them. past that a vertex that finds no match keeps its data
+	//without being linked, so a cell crowded with distinct vertices (e.g. hard edges meeting at a point) costs a
+	//bounded number of comparisons instead of growing quadratically, only missing some welds in it.
+	//
+	//triangles whose corners weld together are removed, along with the vertices only they used.
+
+	class fbx_vertex_welder {
+	public:
+		class tolerances {
+		public:
+			float _position; //max distance, must be > 0
+			float _normal_degrees; //max angle between normals
+			float _tangent_degrees; //max angle between tangents, the tangent signs must match
+			float _uv; //max difference of u and of v
+		};
+
+		class result {
+		public:
+			int _merged_vertex_count; //vertices gone, merged into another or only used by removed triangles
+			int _removed_triangle_count;
+		};
+
+		static const int MIN_VERTICES_PER_THREAD = 16 * 1024;
+		static const int MAX_CELL_REPRESENTATIVE_COUNT = 64;
+
+	private:
+		class cell {
+		public:
+			int32_t _x;
+			int32_t _y;
+			int32_t _z;
+			int _first_representative; //vertices of the cell that kept their own data, ascending through _next_representatives
+			int _last_representative;
+			int _representative_count;
+		};
+
+		unsigned int _thread_count;
+
+		fbx_scratch_arena& _arena;
+		fbx_arena_vector<std::array<int32_t, 3>> _vertex_cells; //per vertex, quantized position
+		fbx_arena_vector<std::array<int32_t, 3>> _neighbor_offsets; //per vertex, -1 or 1 towards the nearer neighbor on each axis
+		fbx_arena_vector<uint64_t> _cell_hashes; //per vertex
+		fbx_arena_vector<int> _vertex_cell_indices; //per vertex, into _cells
+		fbx_arena_vector<cell> _cells;
+		fbx_arena_vector<int> _table; //into _cells
+		fbx_arena_vector<int> _next_representatives;
+		fbx_arena_vector<int> _welded_vertices; //per vertex, the vertex it welds to, itself if it kept its own data
+
+	public:
+		fbx_vertex_welder(unsigned int thread_count, fbx_scratch_arena& arena);
+
+		//vertices are the unique vertices and mesh_data's unduped vertex indices point into them, both are updated.
+		//welded vertices are numbered in order of first use by the kept triangles. polygon vertices only used by
+		//removed triangles get -1.
+		result weld(const tolerances& tolerances, fbx_converter_mesh_data& mesh_data, std::vector<fbx_polygon_vertex_data>& vertices);
+
+	private:
+		void build_grid(const std::vector<fbx_polygon_vertex_data>& vertices, float cell_size);
+		int insert_cell(int vertex_index);
+		void add_representative(int cell_index, int vertex_index);
+		int find_cell(int32_t x, int32_t y, int32_t z, uint64_t hash) const;
+		void weld_vertices(const tolerances& tolerances, const std::vector<fbx_polygon_vertex_data>& vertices);
+		int remove_collapsed_triangles(fbx_converter_mesh_data& mesh_data) const;
+		void number_welded_vertices(fbx_converter_mesh_data& mesh_data, std::vector<fbx_polygon_vertex_data>& vertices) const;
+
+	public:
+		static uint64_t hash_cell(int32_t x, int32_t y, int32_t z);
+	};
+
+}
\ No newline at end of file
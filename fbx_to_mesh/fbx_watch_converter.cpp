@@ -0,0 +1,193 @@
+#include "fbx_watch_converter.h"
+
+#include <algorithm>
+#include <thread>
+#include "solar/strings/string_build.h"
+#include "fbx_converter.h"
+
+namespace solar {
+
+	namespace {
+
+		std::string to_json_string(const std::string& s) {
+			std::string json = "\"";
+			for (char c : s) {
+				switch (c) {
+					case '"': json += "\\\""; break;
+					case '\\': json += "\\\\"; break;
+					case '\n': json += "\\n"; break;
+					case '\r': json += "\\r"; break;
+					case '\t': json += "\\t"; break;
+					default:
+						if (static_cast<unsigned char>(c) < 0x20) {
+							//every other control character, json allows none of them raw in a string.
+							const char* HEX_DIGITS = "0123456789abcdef";
+							json += "\\u00";
+							json += HEX_DIGITS[static_cast<unsigned char>(c) >> 4];
+							json += HEX_DIGITS[static_cast<unsigned char>(c) & 0xf];
+						}
+						else {
+							json += c;
+						}
+						break;
+				}
+			}
+			return json + "\"";
+		}
+
+	}
+
+	fbx_watch_converter::fbx_watch_converter(const fbx_batch_converter& batch, const std::string& output_dir, unsigned int worker_count, std::ostream& report_stream)
+		: _batch(batch)
+		, _output_dir(output_dir)
+		, _worker_count(std::max(1u, worker_count))
+		, _report_stream(report_stream)
+		, _is_stopping(false) {
+	}
+
+	bool fbx_watch_converter::add_directory(const std::string& dir_path) {
+		if (!_watcher.add_directory(dir_path)) {
+			report_line(build_string("{{\"event\":\"error\",\"message\":{}}}", to_json_string("can't watch directory : " + dir_path)));
+			return false;
+		}
+		report_line(build_string("{{\"event\":\"watching\",\"directory\":{}}}", to_json_string(dir_path)));
+		return true;
+	}
+
+	void fbx_watch_converter::run() {
+		std::vector<std::thread> workers;
+		for (unsigned int i = 0; i < _worker_count; ++i) {
+			workers.emplace_back([this]() { execute_worker(); });
+		}
+
+		std::vector<std::string> changed_paths;
+		int timeout_milliseconds = IDLE_POLL_MILLISECONDS;
+		while (!_is_stopping) {
+			changed_paths.clear();
+			if (!_watcher.wait_for_changes(timeout_milliseconds, changed_paths)) {
+				report_line("{\"event\":\"error\",\"message\":\"waiting for directory changes failed\"}");
+				break;
+			}
+
+			auto now = clock::now();
+			for (const auto& path : changed_paths) {
+				add_change(path, now);
+			}
+			int due_milliseconds = queue_debounced_files(now);
+			timeout_milliseconds = (due_milliseconds < 0) ? IDLE_POLL_MILLISECONDS : due_milliseconds;
+		}
+
+		stop();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void fbx_watch_converter::stop() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_is_stopping = true;
+		_queue_changed.notify_all();
+	}
+
+	void fbx_watch_converter::add_change(const std::string& input_path, clock::time_point time) {
+		auto file = std::find_if(_debouncing.begin(), _debouncing.end(), [&input_path](const pending_file& f) { return f._input_path == input_path; });
+		if (file != _debouncing.end()) {
+			file->_last_change_time = time;
+			return;
+		}
+		pending_file new_file;
+		new_file._input_path = input_path;
+		new_file._last_change_time = time;
+		_debouncing.push_back(new_file);
+	}
+
+	int fbx_watch_converter::queue_debounced_files(clock::time_point now) {
+		int due_milliseconds = -1;
+		auto debounce = std::chrono::milliseconds(DEBOUNCE_MILLISECONDS);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (auto file = _debouncing.begin(); file != _debouncing.end();) {
+			auto quiet = now - file->_last_change_time;
+			if (quiet >= debounce) {
+				//a file still waiting in the queue only needs its newer change time.
+				auto queued = std::find_if(_queue.begin(), _queue.end(), [&file](const pending_file& f) { return f._input_path == file->_input_path; });
+				if (queued != _queue.end()) {
+					queued->_last_change_time = file->_last_change_time;
+				}
+				else {
+					_queue.push_back(*file);
+				}
+				file = _debouncing.erase(file);
+				_queue_changed.notify_one();
+			}
+			else {
+				int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(debounce - quiet).count()) + 1;
+				due_milliseconds = (due_milliseconds < 0) ? remaining : std::min(due_milliseconds, remaining);
+				++file;
+			}
+		}
+		return due_milliseconds;
+	}
+
+	void fbx_watch_converter::execute_worker() {
+		fbx_converter converter(_batch.get_converter_params());
+		pending_file file;
+		while (try_pop_file(file)) {
+			fbx_batch_converter::job job(file._input_path, fbx_batch_converter::make_output_path(file._input_path, _output_dir));
+			if (fbx_directory_watcher::wait_until_closed(file._input_path, CLOSE_TIMEOUT_MILLISECONDS)) {
+				_batch.execute_job(converter, job);
+			}
+			else {
+				//its next save will be reported again.
+				job._error_count = 1;
+				job._exception_message = "still open in another process";
+			}
+			report_job(job, file._last_change_time);
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			_converting_paths.erase(file._input_path);
+			_queue_changed.notify_all(); //a worker may be waiting for this file to finish converting
+		}
+	}
+
+	bool fbx_watch_converter::try_pop_file(pending_file& file) {
+		std::unique_lock<std::mutex> lock(_mutex);
+		for (;;) {
+			if (_is_stopping) {
+				return false;
+			}
+			auto next = std::find_if(_queue.begin(), _queue.end(), [this](const pending_file& f) { return _converting_paths.count(f._input_path) == 0; });
+			if (next != _queue.end()) {
+				file = *next;
+				_queue.erase(next);
+				_converting_paths.insert(file._input_path);
+				return true;
+			}
+			_queue_changed.wait(lock);
+		}
+	}
+
+	void fbx_watch_converter::report_job(const fbx_batch_converter::job& job, clock::time_point last_change_time) {
+		//latency is from the last change event to the .mesh being written, debounce included.
+		double latency_milliseconds = std::chrono::duration<double, std::milli>(clock::now() - last_change_time).count();
+		std::string line = build_string(
+			"{{\"event\":\"{}\",\"input\":{},\"output\":{},\"error_count\":{},\"is_cache_hit\":{},\"milliseconds\":{},\"latency_milliseconds\":{}",
+			job.is_successful() ? "converted" : "failed",
+			to_json_string(job._input_path),
+			to_json_string(job._output_path),
+			job._error_count,
+			job._is_cache_hit ? "true" : "false",
+			job._stats.get_total_milliseconds(),
+			latency_milliseconds);
+		if (!job._exception_message.empty()) {
+			line += build_string(",\"message\":{}", to_json_string(job._exception_message));
+		}
+		report_line(line + "}");
+	}
+
+	void fbx_watch_converter::report_line(const std::string& line) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_report_stream << line << std::endl; //flushed, whoever reads the lines is waiting for them
+	}
+
+}
\ No newline at end of file
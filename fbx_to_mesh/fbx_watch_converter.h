@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "fbx_batch_converter.h"
+#include "fbx_directory_watcher.h"
+
+namespace solar {
+
+	class fbx_converter;
+
+	//watches directories and reconverts each .fbx shortly after it's saved, for artists iterating on a mesh.
+	//
+	//change events for a file are debounced until it has been quiet for DEBOUNCE_MILLISECONDS, then it's queued for
+	//a pool of workers that each keep one fbx_converter (and so one FbxManager) for the whole session. a file saved
+	//again while it's converting is converted again once that finishes, never twice at the same time.
+	//
+	//every result is one json object per line on the report stream, see report_job. when that's stdout the
+	//converter must not be verbose, warnings and errors still show up there but never start with '{'.
+
+	class fbx_watch_converter {
+	public:
+		static const int DEBOUNCE_MILLISECONDS = 50;
+		static const int IDLE_POLL_MILLISECONDS = 250; //how often stop() is noticed when nothing changes
+		static const int CLOSE_TIMEOUT_MILLISECONDS = 30 * 1000; //for the exporter to close the file before it's converted
+
+	private:
+		typedef std::chrono::high_resolution_clock clock;
+
+		class pending_file {
+		public:
+			std::string _input_path;
+			clock::time_point _last_change_time;
+		};
+
+		const fbx_batch_converter& _batch;
+		std::string _output_dir;
+		unsigned int _worker_count;
+		std::ostream& _report_stream;
+		fbx_directory_watcher _watcher;
+		std::vector<pending_file> _debouncing; //watch thread only
+		std::atomic<bool> _is_stopping;
+
+		std::mutex _mutex;
+		std::condition_variable _queue_changed;
+		std::deque<pending_file> _queue; //debounced, waiting for a worker
+		std::set<std::string> _converting_paths;
+
+	public:
+		fbx_watch_converter(const fbx_batch_converter& batch, const std::string& output_dir, unsigned int worker_count, std::ostream& report_stream);
+
+		bool add_directory(const std::string& dir_path); //reports and returns false if it can't be watched
+		void run(); //until stop() is called from another thread
+		void stop();
+
+	private:
+		void add_change(const std::string& input_path, clock::time_point time);
+		int queue_debounced_files(clock::time_point now); //returns milliseconds until the next file is due, or -1
+		void execute_worker();
+		bool try_pop_file(pending_file& file);
+		void report_job(const fbx_batch_converter::job& job, clock::time_point last_change_time);
+		void report_line(const std::string& line);
+	};
+
+}
\ No newline at end of file
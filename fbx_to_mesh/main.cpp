@@ -7,12 +7,26 @@
 #include "solar/strings/string_build.h"
 #include "solar/archiving/json_archive_writer.h"
 #include "solar/archiving/binary_archive_writer.h"
-#include "solar/rendering/meshes/mesh_def.h"
 #include "fbx_converter.h"
+#include "fbx_batch_converter.h"
+#include "fbx_conversion_cache.h"
+#include "fbx_mapped_mesh_writer.h"
+#include "fbx_pipeline_benchmark.h"
+#include "fbx_watch_converter.h"
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
 
 using namespace solar;
 
 std::unique_ptr<archive_writer> make_writer(std::string format, stream& stream);
+bool is_valid_format(const std::string& format);
+bool is_layout_format(const std::string& format);
+std::string get_option_mesh_def_cant_hold(const fbx_converter_params& params);
+bool parse_bool_value(const std::string& value);
+int parse_index_bits(const std::string& value);
+void parse_weld_value(const std::string& value, fbx_converter_params& params);
 
 int _tmain(int argc, _TCHAR* argv[])
 {
@@ -25,22 +39,189 @@ int _tmain(int argc, _TCHAR* argv[])
 				.set_assert_behavoir(win32_cli_app_error_behavoir::THROW)));
 
 		auto parser = command_line_parser()
-			.add_required_value('i', "input", "input .fbx file")
-			.add_required_value('o', "output", "output .mesh file")
-			.add_optional_value('f', "format", "output format (json or binary)", "binary");
+			.add_optional_value('i', "input", "input .fbx file", "")
+			.add_optional_value('o', "output", "output .mesh file (output directory in batch mode)", "")
+			.add_optional_value('f', "format", "output format : json or binary (mesh_def), json_layout or binary_layout (mesh_def plus submeshes, bounds, packed vertices, LODs, meshlets, BVH, position stream and instancing) or mapped", "binary")
+			.add_optional_value('b', "batch", "manifest file (one .fbx per line) or directory of .fbx files to convert", "")
+			.add_optional_value('j', "jobs", "batch or watch worker thread count (0 is one per core)", "0")
+			.add_optional_value('a', "watch", "directories to watch, separated by ; (.fbx files are reconverted when saved until the process is killed, results are json lines on stdout, verbose is forced off)", "")
+			.add_optional_value('v', "verbose", "verbose output (true or false)", "true")
+			.add_optional_value('w', "warnings_as_errors", "treat warnings as errors (true or false)", "false")
+			.add_optional_value('c', "cache", "conversion cache directory (disabled if empty)", "")
+			.add_optional_value('m', "cache_max_mb", "conversion cache size budget in megabytes", "4096")
+			.add_optional_value('d', "overdraw", "reorder triangles to reduce overdraw (true or false)", "false")
+			.add_optional_value('t', "overdraw_threshold", "max vertex cache miss ratio of the overdraw order relative to the cache order", "1.05")
+			.add_optional_value('n', "index_bits", "index size : 16 (meshes with too many vertices are split into submeshes) or 32", "16")
+			.add_optional_value('p', "packed", "quantized 16 byte vertices instead of 48 byte float vertices (true or false)", "false")
+			.add_optional_value('l', "lods", "number of simplified LODs to generate", "0")
+			.add_optional_value('r', "lod_ratio", "triangle count of each LOD relative to the previous one", "0.5")
+			.add_optional_value('e', "lod_max_error", "max LOD simplification error relative to the mesh's bounding sphere radius", "0.05")
+			.add_optional_value('k', "meshlets", "split into meshlets with culling bounds (true or false)", "false")
+			.add_optional_value('y', "bvh", "build a triangle BVH for raycasts (true or false)", "false")
+			.add_optional_value('u', "instancing", "write mesh nodes with identical geometry once, with a transform per node, instead of merging them (true or false, not with -f mapped)", "false")
+			.add_optional_value('q', "position_stream", "also write positions deduped on their own with their own cache optimized indices, for depth and shadow passes (true or false)", "false")
+			.add_optional_value('g', "weld", "merge vertices that only differ by float noise : false, true (default tolerances) or position,normal_degrees,tangent_degrees,uv tolerances", "false")
+			.add_optional_value('x', "raycast_benchmark", "rays cast per mesh to compare BVH and brute force raycasts (0 is disabled)", "0")
+			.add_optional_value('s', "stats", "json file to write per file stage timings, scratch memory and vertex/triangle counts and the batch's peak memory to (disabled if empty)", "")
+			.add_optional_value('z', "benchmark", "benchmark the conversion pipeline on synthetic meshes of 1K triangles up to this many, instead of converting (0 is disabled)", "0");
 
 		if (!parser.execute(argc, argv)) {
 			return 1;
 		}
 
-		fbx_converter converter;
-		auto mesh_def = converter.convert_fbx_to_mesh_def(parser.get_value("input"));
-		if (mesh_def != nullptr) {
-			auto fs = make_file_stream_ptr(engine._win32_file_system, parser.get_value("output"), file_mode::CREATE_WRITE);
-			auto writer = make_writer(parser.get_value("format"), *fs);
+		auto format = parser.get_value("format");
+		if (!is_valid_format(format)) {
+			throw std::runtime_error(build_string("unknown export format : {}", format));
+		}
+
+		auto converter_params = fbx_converter_params()
+			.set_is_verbose(parse_bool_value(parser.get_value("verbose")))
+			.set_is_warnings_as_errors_enabled(parse_bool_value(parser.get_value("warnings_as_errors")))
+			.set_is_overdraw_optimization_enabled(parse_bool_value(parser.get_value("overdraw")))
+			.set_overdraw_cache_threshold(std::stof(parser.get_value("overdraw_threshold")))
+			.set_is_32_bit_index_enabled(parse_index_bits(parser.get_value("index_bits")) == 32)
+			.set_is_vertex_packing_enabled(parse_bool_value(parser.get_value("packed")))
+			.set_lod_count(std::stoi(parser.get_value("lods")))
+			.set_lod_triangle_ratio(std::stof(parser.get_value("lod_ratio")))
+			.set_lod_max_error(std::stof(parser.get_value("lod_max_error")))
+			.set_is_meshlet_generation_enabled(parse_bool_value(parser.get_value("meshlets")))
+			.set_is_bvh_enabled(parse_bool_value(parser.get_value("bvh")))
+			.set_raycast_benchmark_ray_count(std::stoi(parser.get_value("raycast_benchmark")))
+			.set_is_instancing_enabled(parse_bool_value(parser.get_value("instancing")))
+			.set_is_position_stream_enabled(parse_bool_value(parser.get_value("position_stream")));
+		parse_weld_value(parser.get_value("weld"), converter_params);
+		if (converter_params._overdraw_cache_threshold < 1.f) {
+			throw std::runtime_error(build_string("overdraw_threshold must be at least 1 : {}", converter_params._overdraw_cache_threshold));
+		}
+		if (converter_params._lod_count < 0) {
+			throw std::runtime_error(build_string("lods must not be negative : {}", converter_params._lod_count));
+		}
+		if (converter_params._lod_triangle_ratio <= 0.f || converter_params._lod_triangle_ratio >= 1.f) {
+			throw std::runtime_error(build_string("lod_ratio must be between 0 and 1 : {}", converter_params._lod_triangle_ratio));
+		}
+		if (converter_params._is_vertex_welding_enabled && converter_params._weld_position_tolerance <= 0.f) {
+			throw std::runtime_error(build_string("weld position tolerance must be positive : {}", converter_params._weld_position_tolerance));
+		}
+		if (converter_params._is_instancing_enabled && format == "mapped") {
+			throw std::runtime_error("instancing isn't supported by the mapped format");
+		}
+		if ((format == "json" || format == "binary") && !get_option_mesh_def_cant_hold(converter_params).empty()) {
+			throw std::runtime_error(build_string("{} isn't supported by mesh_def, use -f json_layout or binary_layout", get_option_mesh_def_cant_hold(converter_params)));
+		}
+
+		int benchmark_max_triangle_count = std::stoi(parser.get_value("benchmark"));
+		if (benchmark_max_triangle_count > 0) {
+			fbx_pipeline_benchmark(converter_params, benchmark_max_triangle_count).run(std::cout);
+			engine.teardown();
+			return 0;
+		}
+
+		//batch and watch workers write concurrently but the win32 file system isn't thread safe. opening and closing
+		//streams go through it under this lock, writing to an open stream doesn't need it.
+		std::mutex file_system_mutex;
+		auto write_output_mesh = [&](const fbx_output_mesh& output_mesh, const std::string& output_path) {
+			if (format == "mapped") {
+				std::ofstream fs(output_path, std::ios::binary | std::ios::trunc);
+				if (!fbx_mapped_mesh_writer().write(output_mesh, fs)) {
+					throw std::runtime_error(build_string("failed to write : {}", output_path));
+				}
+				return;
+			}
+			if (!is_layout_format(format) && !output_mesh.is_mesh_def_compatible()) {
+				throw std::runtime_error(build_string("mesh_def can't hold this mesh, use -f json_layout, binary_layout or mapped : {}", output_path));
+			}
+
+			auto fs = [&]() {
+				std::lock_guard<std::mutex> lock(file_system_mutex);
+				return make_file_stream_ptr(engine._win32_file_system, output_path, file_mode::CREATE_WRITE);
+			}();
+			auto writer = make_writer(format, *fs);
 			writer->begin_writing();
-			mesh_def->write_to_archive(*writer.get());
+			if (is_layout_format(format)) {
+				output_mesh.write_layout_to_archive(*writer.get());
+			}
+			else {
+				output_mesh.write_to_archive(*writer.get());
+			}
 			writer->end_writing();
+
+			writer.reset();
+			std::lock_guard<std::mutex> lock(file_system_mutex);
+			fs.reset();
+		};
+
+		bool is_batch = !parser.get_value("batch").empty();
+		bool is_watch = !parser.get_value("watch").empty();
+
+		unsigned int worker_count = 1;
+		if (is_batch || is_watch) {
+			worker_count = static_cast<unsigned int>(std::stoi(parser.get_value("jobs")));
+			if (worker_count == 0) {
+				worker_count = get_default_fbx_thread_count();
+			}
+		}
+
+		if (is_watch) {
+			converter_params.set_is_verbose(false); //verbose messages would go to stdout between the json lines
+		}
+
+		fbx_batch_converter batch(converter_params, worker_count, write_output_mesh);
+
+		std::unique_ptr<fbx_conversion_cache> cache;
+		if (!parser.get_value("cache").empty()) {
+			cache = std::make_unique<fbx_conversion_cache>(
+				parser.get_value("cache"),
+				static_cast<uint64_t>(std::stoull(parser.get_value("cache_max_mb"))) * 1024 * 1024,
+				build_string("{{ version:{} , format:{} , params:{} }}", fbx_converter::VERSION, format, converter_params.to_string()));
+			batch.set_cache(cache.get());
+		}
+
+		if (is_watch) {
+			fbx_watch_converter watch(batch, parser.get_value("output"), worker_count, std::cout);
+			std::stringstream dir_paths(parser.get_value("watch"));
+			std::string dir_path;
+			while (std::getline(dir_paths, dir_path, ';')) {
+				if (!dir_path.empty() && !watch.add_directory(dir_path)) {
+					return 1;
+				}
+			}
+			watch.run();
+			engine.teardown();
+			return 0;
+		}
+
+		if (is_batch) {
+			if (!batch.add_jobs_from_manifest_or_directory(parser.get_value("batch"), parser.get_value("output"))) {
+				return 1;
+			}
+		}
+		else {
+			if (parser.get_value("input").empty() || parser.get_value("output").empty()) {
+				engine._win32_cli_app.write_to_error_console("input and output are required when not in batch mode.");
+				return 1;
+			}
+			batch.add_job(parser.get_value("input"), parser.get_value("output"));
+		}
+
+		batch.execute();
+
+		if (cache != nullptr) {
+			cache->evict();
+		}
+
+		if (!parser.get_value("stats").empty()) {
+			auto fs = make_file_stream_ptr(engine._win32_file_system, parser.get_value("stats"), file_mode::CREATE_WRITE);
+			json_archive_writer writer(*fs);
+			writer.begin_writing();
+			batch.write_stats_to_archive(writer);
+			writer.end_writing();
+		}
+
+		if (is_batch) {
+			for (const auto& job : batch.get_jobs()) {
+				TRACE("{} : {} -> {} : {} errors{}", job.is_successful() ? "OK" : "FAILED", job._input_path, job._output_path, job._error_count, job._is_cache_hit ? " (cached)" : "");
+			}
+			TRACE("batch : {} files, {} failed, {} cached, {} errors", batch.get_jobs().size(), batch.get_failed_job_count(), batch.get_cache_hit_count(), batch.get_error_count());
 		}
 
 		if (engine._win32_cli_app.get_error_count() > 0) {
@@ -58,13 +239,89 @@ int _tmain(int argc, _TCHAR* argv[])
 }
 
 std::unique_ptr<archive_writer> make_writer(std::string format, stream& stream) {
-	if (format == "json") {
+	if (format == "json" || format == "json_layout") {
 		return std::make_unique<json_archive_writer>(stream);
 	}
-	else if (format == "binary") {
+	else if (format == "binary" || format == "binary_layout") {
 		return std::make_unique<binary_archive_writer>(stream);
 	}
 
 	throw std::runtime_error(build_string("unknown export format : {}", format));
 }
 
+bool is_valid_format(const std::string& format) {
+	return format == "json" || format == "binary" || is_layout_format(format) || format == "mapped";
+}
+
+bool is_layout_format(const std::string& format) {
+	return format == "json_layout" || format == "binary_layout";
+}
+
+//json and binary stay mesh_def so existing readers keep loading them, what mesh_def can't hold is opt-in through
+//the layout formats.
+std::string get_option_mesh_def_cant_hold(const fbx_converter_params& params) {
+	if (params._is_32_bit_index_enabled) {
+		return "index_bits 32";
+	}
+	if (params._is_vertex_packing_enabled) {
+		return "packed";
+	}
+	if (params._lod_count > 0) {
+		return "lods";
+	}
+	if (params._is_meshlet_generation_enabled) {
+		return "meshlets";
+	}
+	if (params._is_bvh_enabled) {
+		return "bvh";
+	}
+	if (params._is_position_stream_enabled) {
+		return "position_stream";
+	}
+	if (params._is_instancing_enabled) {
+		return "instancing";
+	}
+	return "";
+}
+
+bool parse_bool_value(const std::string& value) {
+	if (value == "true" || value == "1") {
+		return true;
+	}
+	else if (value == "false" || value == "0") {
+		return false;
+	}
+
+	throw std::runtime_error(build_string("expected true or false : {}", value));
+}
+
+int parse_index_bits(const std::string& value) {
+	if (value == "16") {
+		return 16;
+	}
+	else if (value == "32") {
+		return 32;
+	}
+
+	throw std::runtime_error(build_string("expected 16 or 32 : {}", value));
+}
+
+void parse_weld_value(const std::string& value, fbx_converter_params& params) {
+	if (value.find(',') == std::string::npos) {
+		params.set_is_vertex_welding_enabled(parse_bool_value(value));
+		return;
+	}
+
+	std::vector<float> tolerances;
+	std::istringstream ss(value);
+	std::string item;
+	while (std::getline(ss, item, ',')) {
+		tolerances.push_back(std::stof(item));
+	}
+	if (tolerances.size() != 4) {
+		throw std::runtime_error(build_string("expected true, false or position,normal_degrees,tangent_degrees,uv : {}", value));
+	}
+	params
+		.set_is_vertex_welding_enabled(true)
+		.set_weld_tolerances(tolerances[0], tolerances[1], tolerances[2], tolerances[3]);
+}
\ No newline at end of file
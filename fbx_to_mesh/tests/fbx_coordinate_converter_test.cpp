@@ -0,0 +1,92 @@
+#include "fbx_coordinate_converter.h"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace solar;
+
+//fbx_coordinate_converter's batch conversions (SSE2 when enabled) against the one at a time reference, on the
+//values where a vectorized conversion is most likely to differ : signed zeros, denormals, nans, infinities and
+//float overflow, with counts that leave a scalar tail and arrays that aren't 16 byte aligned.
+
+namespace {
+
+	int s_failure_count = 0;
+
+	void check(bool condition, const char* what, int count, int offset, int index) {
+		if (!condition) {
+			std::cout << "FAILED : " << what << " , count " << count << " , offset " << offset << " , index " << index << "\n";
+			s_failure_count++;
+		}
+	}
+
+	std::vector<double> make_edge_values() {
+		double quiet_nan_with_payload;
+		uint64_t nan_bits = 0x7ff8000000012345ull;
+		std::memcpy(&quiet_nan_with_payload, &nan_bits, sizeof(double));
+
+		return std::vector<double>{
+			0.0, -0.0,
+			std::numeric_limits<double>::denorm_min(), -std::numeric_limits<double>::denorm_min(), //double denormals, 0 as floats
+			1e-40, -1e-40, 1e-45, -1.4e-45, //float denormals
+			static_cast<double>(std::numeric_limits<float>::min()), -static_cast<double>(std::numeric_limits<float>::min()),
+			std::numeric_limits<double>::quiet_NaN(), -std::numeric_limits<double>::quiet_NaN(), quiet_nan_with_payload,
+			std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+			3.5e38, -3.5e38, 1e300, //overflow to float infinity
+			1.0, -1.0, 0.1, -1.0 / 3.0, 16777217.0, 1.0 - 1e-9
+		};
+	}
+
+	void check_vec3s(const std::vector<double>& edge_values, int count, int offset) {
+		//offset by one double and one vec3, neither array is 16 byte aligned.
+		std::vector<double> values(offset + count * 4);
+		for (int i = 0; i < count * 4; ++i) {
+			values[offset + i] = edge_values[(i * 7 + count) % edge_values.size()];
+		}
+
+		std::vector<vec3> batch(offset + count);
+		fbx_coordinate_converter::convert_vec3s(values.data() + offset, count, batch.data() + offset);
+		for (int i = 0; i < count; ++i) {
+			vec3 reference = fbx_coordinate_converter::convert_vec3(values.data() + offset + i * 4);
+			check(std::memcmp(&reference, &batch[offset + i], sizeof(vec3)) == 0, "vec3", count, offset, i);
+		}
+	}
+
+	void check_uvs(const std::vector<double>& edge_values, int count, int offset) {
+		std::vector<double> values(offset + count * 2);
+		for (int i = 0; i < count * 2; ++i) {
+			values[offset + i] = edge_values[(i * 5 + count) % edge_values.size()];
+		}
+
+		std::vector<uv> batch(offset + count);
+		fbx_coordinate_converter::convert_uvs(values.data() + offset, count, batch.data() + offset);
+		for (int i = 0; i < count; ++i) {
+			uv reference = fbx_coordinate_converter::convert_uv(values.data() + offset + i * 2);
+			check(std::memcmp(&reference, &batch[offset + i], sizeof(uv)) == 0, "uv", count, offset, i);
+		}
+	}
+
+}
+
+int main()
+{
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	//the startup check uses fewer values than this test, but if it fails SSE2 is silently lost.
+	check(fbx_coordinate_converter::is_simd_enabled(), "SSE2 available but disabled by the startup check", 0, 0, 0);
+#endif
+
+	auto edge_values = make_edge_values();
+	for (int count = 0; count <= 13; ++count) {
+		for (int offset = 0; offset <= 1; ++offset) {
+			check_vec3s(edge_values, count, offset);
+			check_uvs(edge_values, count, offset);
+		}
+	}
+	check_vec3s(edge_values, 1001, 1);
+	check_uvs(edge_values, 1001, 1);
+
+	std::cout << "simd " << (fbx_coordinate_converter::is_simd_enabled() ? "on" : "off") << " , " << s_failure_count << " failures\n";
+	return (s_failure_count == 0) ? 0 : 1;
+}
\ No newline at end of file
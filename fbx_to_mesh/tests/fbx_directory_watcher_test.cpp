@@ -0,0 +1,112 @@
+#include "fbx_directory_watcher.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace solar;
+
+//fbx_directory_watcher's inotify branch on a temporary directory : a saved .fbx, a .fbx renamed into it and files
+//that aren't .fbx, each driven through wait_for_changes.
+
+namespace {
+
+	const int WAIT_MILLISECONDS = 2000;
+
+	int s_failure_count = 0;
+
+	void check(bool condition, const char* what) {
+		if (!condition) {
+			std::cout << "FAILED : " << what << "\n";
+			s_failure_count++;
+		}
+	}
+
+	void write_file(const std::string& path) {
+		std::ofstream fs(path, std::ios::binary | std::ios::trunc);
+		fs << "Kaydara FBX Binary";
+	}
+
+	bool contains(const std::vector<std::string>& paths, const std::string& path) {
+		return std::find(paths.begin(), paths.end(), path) != paths.end();
+	}
+
+	//events for one save can come in more than one read, wait until path shows up or the time runs out.
+	std::vector<std::string> wait_for_path(fbx_directory_watcher& watcher, const std::string& path) {
+		std::vector<std::string> changed_paths;
+		for (int waited = 0; waited < WAIT_MILLISECONDS && !contains(changed_paths, path); waited += 100) {
+			check(watcher.wait_for_changes(100, changed_paths), "wait_for_changes succeeds");
+		}
+		return changed_paths;
+	}
+
+	void test_saved_file(fbx_directory_watcher& watcher, const std::string& dir_path) {
+		auto path = fbx_directory_watcher::join_path(dir_path, "saved.fbx");
+		write_file(path);
+		auto changed_paths = wait_for_path(watcher, path);
+		check(contains(changed_paths, path), "a saved .fbx is reported");
+		check(fbx_directory_watcher::wait_until_closed(path, WAIT_MILLISECONDS), "a saved .fbx is closed");
+	}
+
+	void test_renamed_file(fbx_directory_watcher& watcher, const std::string& dir_path) {
+		auto temporary_path = fbx_directory_watcher::join_path(dir_path, "renamed.tmp");
+		auto path = fbx_directory_watcher::join_path(dir_path, "renamed.FBX");
+		write_file(temporary_path);
+		check(std::rename(temporary_path.c_str(), path.c_str()) == 0, "rename into the directory");
+		auto changed_paths = wait_for_path(watcher, path);
+		check(contains(changed_paths, path), "a .fbx renamed into the directory is reported, whatever the extension's case");
+		check(!contains(changed_paths, temporary_path), "the temporary file it was written to isn't reported");
+	}
+
+	void test_other_files(fbx_directory_watcher& watcher, const std::string& dir_path) {
+		auto path = fbx_directory_watcher::join_path(dir_path, "notes.txt");
+		write_file(path);
+		std::vector<std::string> changed_paths;
+		check(watcher.wait_for_changes(200, changed_paths), "wait_for_changes succeeds");
+		check(changed_paths.empty(), "files that aren't .fbx aren't reported");
+		check(watcher.wait_for_changes(100, changed_paths) && changed_paths.empty(), "nothing is reported when nothing changes");
+	}
+
+	void test_list(const std::string& dir_path) {
+		std::vector<std::string> paths;
+		fbx_directory_watcher::list_fbx_files(dir_path, paths);
+		std::sort(paths.begin(), paths.end());
+		check(paths.size() == 2 &&
+			paths[0] == fbx_directory_watcher::join_path(dir_path, "renamed.FBX") &&
+			paths[1] == fbx_directory_watcher::join_path(dir_path, "saved.fbx"), "listing, as done on overflow, finds every .fbx");
+	}
+
+}
+
+int main()
+{
+	char dir_template[] = "/tmp/fbx_directory_watcher_test_XXXXXX";
+	if (::mkdtemp(dir_template) == nullptr) {
+		std::cout << "FAILED : can't create a temporary directory\n";
+		return 1;
+	}
+	std::string dir_path = dir_template;
+
+	{
+		fbx_directory_watcher watcher;
+		check(!watcher.add_directory(fbx_directory_watcher::join_path(dir_path, "missing")), "a missing directory can't be watched");
+		check(watcher.add_directory(dir_path), "the directory is watched");
+
+		test_saved_file(watcher, dir_path);
+		test_renamed_file(watcher, dir_path);
+		test_other_files(watcher, dir_path);
+		test_list(dir_path);
+	}
+
+	for (const char* file_name : { "saved.fbx", "renamed.FBX", "notes.txt" }) {
+		std::remove(fbx_directory_watcher::join_path(dir_path, file_name).c_str());
+	}
+	::rmdir(dir_path.c_str());
+
+	std::cout << s_failure_count << " failures\n";
+	return (s_failure_count == 0) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "fbx_vertex_welder.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace solar;
+
+//fbx_vertex_welder on meshes whose expected result is known : a grid whose vertices were split apart and jittered
+//by float noise, a triangle that collapses on its own, and a single cell crowded with distinct vertices.
+
+namespace {
+
+	int s_failure_count = 0;
+
+	void check(bool condition, const char* what) {
+		if (!condition) {
+			std::cout << "FAILED : " << what << "\n";
+			s_failure_count++;
+		}
+	}
+
+	fbx_vertex_welder::tolerances make_tolerances() {
+		fbx_vertex_welder::tolerances tolerances;
+		tolerances._position = 1e-4f;
+		tolerances._normal_degrees = 1.f;
+		tolerances._tangent_degrees = 2.f;
+		tolerances._uv = 1e-4f;
+		return tolerances;
+	}
+
+	fbx_polygon_vertex_data make_vertex(const vec3& position, const uv& uv) {
+		fbx_polygon_vertex_data vertex;
+		vertex._position = position;
+		vertex._normal = vec3(0.f, 0.f, 1.f);
+		vertex._tangent = vec3(1.f, 0.f, 0.f);
+		vertex._tangent_sign = 1.f;
+		vertex._uv = uv;
+		return vertex;
+	}
+
+	//each polygon vertex its own unique vertex, as exact dedup leaves them when every copy has different noise.
+	void add_triangle(const fbx_polygon_vertex_data (&corners)[3], fbx_converter_mesh_data& mesh_data, std::vector<fbx_polygon_vertex_data>& vertices) {
+		std::array<int, 3> triangle;
+		for (int k = 0; k < 3; ++k) {
+			triangle[k] = static_cast<int>(mesh_data._unduped_vertex_indices.size());
+			mesh_data._unduped_vertex_indices.push_back(static_cast<int>(vertices.size()));
+			vertices.push_back(corners[k]);
+		}
+		mesh_data._triangles.push_back(triangle);
+		mesh_data._material_indices.push_back(0);
+	}
+
+	void check_no_unused_or_degenerate(const fbx_converter_mesh_data& mesh_data, const std::vector<fbx_polygon_vertex_data>& vertices) {
+		std::vector<bool> is_used(vertices.size(), false);
+		bool is_in_range = true;
+		bool is_degenerate = false;
+		for (const auto& triangle : mesh_data._triangles) {
+			int v[3];
+			for (int k = 0; k < 3; ++k) {
+				v[k] = mesh_data._unduped_vertex_indices[triangle[k]];
+				is_in_range &= v[k] >= 0 && v[k] < static_cast<int>(vertices.size());
+				if (is_in_range) {
+					is_used[v[k]] = true;
+				}
+			}
+			is_degenerate |= v[0] == v[1] || v[1] == v[2] || v[2] == v[0];
+		}
+		check(is_in_range, "kept triangles only use welded vertices");
+		check(!is_degenerate, "no kept triangle has two corners on the same vertex");
+		check(std::find(is_used.begin(), is_used.end(), false) == is_used.end(), "every welded vertex is used");
+	}
+
+	void test_noisy_grid() {
+		const int QUAD_COUNT = 64;
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> noise(-1e-6f, 1e-6f);
+		auto get_corner = [&](int x, int y) {
+			return make_vertex(
+				vec3(x * 0.01f + noise(random), y * 0.01f + noise(random), noise(random)),
+				uv(x / static_cast<float>(QUAD_COUNT) + noise(random), y / static_cast<float>(QUAD_COUNT) + noise(random)));
+		};
+
+		fbx_converter_mesh_data mesh_data;
+		std::vector<fbx_polygon_vertex_data> vertices;
+		for (int y = 0; y < QUAD_COUNT; ++y) {
+			for (int x = 0; x < QUAD_COUNT; ++x) {
+				fbx_polygon_vertex_data lower[3] = { get_corner(x, y), get_corner(x + 1, y), get_corner(x, y + 1) };
+				fbx_polygon_vertex_data upper[3] = { get_corner(x + 1, y), get_corner(x + 1, y + 1), get_corner(x, y + 1) };
+				add_triangle(lower, mesh_data, vertices);
+				add_triangle(upper, mesh_data, vertices);
+			}
+		}
+
+		fbx_scratch_arena arena;
+		auto result = fbx_vertex_welder(4, arena).weld(make_tolerances(), mesh_data, vertices);
+		check(vertices.size() == (QUAD_COUNT + 1) * (QUAD_COUNT + 1), "noisy grid welds back to one vertex per grid point");
+		check(result._removed_triangle_count == 0, "noisy grid keeps every triangle");
+		check(mesh_data.get_triangle_count() == QUAD_COUNT * QUAD_COUNT * 2, "noisy grid triangle count");
+		check_no_unused_or_degenerate(mesh_data, vertices);
+	}
+
+	void test_collapsed_triangle() {
+		//the sliver's corners are all within the tolerance, it's removed and its vertex must go with it.
+		fbx_converter_mesh_data mesh_data;
+		std::vector<fbx_polygon_vertex_data> vertices;
+		fbx_polygon_vertex_data sliver[3] = {
+			make_vertex(vec3(5.f, 5.f, 5.f), uv(0.5f, 0.5f)),
+			make_vertex(vec3(5.f + 1e-5f, 5.f, 5.f), uv(0.5f, 0.5f)),
+			make_vertex(vec3(5.f, 5.f + 1e-5f, 5.f), uv(0.5f, 0.5f)) };
+		fbx_polygon_vertex_data triangle[3] = {
+			make_vertex(vec3(0.f, 0.f, 0.f), uv(0.f, 0.f)),
+			make_vertex(vec3(1.f, 0.f, 0.f), uv(1.f, 0.f)),
+			make_vertex(vec3(0.f, 1.f, 0.f), uv(0.f, 1.f)) };
+		add_triangle(sliver, mesh_data, vertices);
+		add_triangle(triangle, mesh_data, vertices);
+
+		fbx_scratch_arena arena;
+		auto result = fbx_vertex_welder(1, arena).weld(make_tolerances(), mesh_data, vertices);
+		check(result._removed_triangle_count == 1, "the collapsed triangle is removed");
+		check(vertices.size() == 3, "the collapsed triangle's vertex is removed");
+		check(mesh_data._unduped_vertex_indices[0] == -1 && mesh_data._unduped_vertex_indices[1] == -1 && mesh_data._unduped_vertex_indices[2] == -1, "the collapsed triangle's polygon vertices are -1");
+		check_no_unused_or_degenerate(mesh_data, vertices);
+	}
+
+	void test_crowded_cell() {
+		//every vertex at the same position with a different uv, none weld. walking every earlier vertex of the cell
+		//would be billions of comparisons.
+		const int TRIANGLE_COUNT = 40000;
+		fbx_converter_mesh_data mesh_data;
+		std::vector<fbx_polygon_vertex_data> vertices;
+		for (int i = 0; i < TRIANGLE_COUNT; ++i) {
+			fbx_polygon_vertex_data corners[3];
+			for (int k = 0; k < 3; ++k) {
+				corners[k] = make_vertex(vec3(1.f, 2.f, 3.f), uv((i * 3 + k) * 1e-3f, 0.f));
+			}
+			add_triangle(corners, mesh_data, vertices);
+		}
+
+		fbx_scratch_arena arena;
+		auto start = std::chrono::high_resolution_clock::now();
+		auto result = fbx_vertex_welder(1, arena).weld(make_tolerances(), mesh_data, vertices);
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		check(result._merged_vertex_count == 0 && result._removed_triangle_count == 0, "crowded cell vertices are all distinct");
+		check(milliseconds < 2000.0, "crowded cell welds in bounded time");
+		check_no_unused_or_degenerate(mesh_data, vertices);
+		std::cout << "crowded cell : " << TRIANGLE_COUNT * 3 << " vertices in " << milliseconds << " ms\n";
+	}
+
+}
+
+int main()
+{
+	test_noisy_grid();
+	test_collapsed_triangle();
+	test_crowded_cell();
+
+	std::cout << s_failure_count << " failures\n";
+	return (s_failure_count == 0) ? 0 : 1;
+}
\ No newline at end of file